@@ -0,0 +1,118 @@
+#ifndef __ASSOCIATED_ALLOCATOR_HPP__
+#define __ASSOCIATED_ALLOCATOR_HPP__
+
+//
+// associated_allocator.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/config.hpp>
+#include <type_traits>
+#include <utility>
+
+namespace cport {
+
+namespace detail {
+
+template <typename T>
+struct void_type {
+    typedef void type;
+};
+
+} // namespace detail
+
+/// Traits to get the allocator associated with a handler.
+/**
+ * A handler with an associated allocator is stored in a node allocated
+ *  with that allocator, instead of the memory resource of the port or
+ *  the scheduler. Among the task handler and the completion handler passed
+ *  to task_scheduler::async(), the allocator of the completion handler is
+ *  used.
+ *
+ * By default a handler has an associated allocator if it has a nested type
+ *  allocator_type and a get_allocator() method. The traits could be
+ *  specialized for other handler types. Such specialization must provide
+ *  a nested type and a static get() method.
+ *
+ * @note The allocator is copied from the handler before the handler is
+ *  destroyed, and it is used to deallocate the node.
+ */
+template <typename Handler, typename = void>
+struct associated_allocator {
+    /// The handler has no associated allocator.
+    typedef void type;
+};
+
+template <typename Handler>
+struct associated_allocator<Handler,
+    typename detail::void_type<typename Handler::allocator_type>::type> {
+    /// The type of the associated allocator.
+    typedef typename Handler::allocator_type type;
+
+    /// Get the allocator associated with the handler.
+    static type get(const Handler &h)
+    {
+        return h.get_allocator();
+    }
+};
+
+/// Associate an allocator with a handler.
+/**
+ * The wrapper invokes the handler with the arguments it is called with.
+ *
+ * @see bind_allocator()
+ */
+template <typename Handler, typename Allocator>
+class allocator_binder {
+public:
+    /// The type of the associated allocator.
+    typedef Allocator allocator_type;
+
+    /// Construct the wrapper.
+    template <typename H>
+    allocator_binder(const Allocator &a, H&& h);
+
+    /// Get the associated allocator.
+    allocator_type get_allocator() const;
+
+    /// Get the wrapped handler.
+    Handler& get();
+
+    /// Get the wrapped handler.
+    const Handler& get() const;
+
+    /// Invoke the wrapped handler.
+    template <typename... Args>
+    void operator()(Args&&... args);
+
+private:
+    Allocator allocator_;
+    Handler handler_;
+};
+
+/// Associate an allocator with a handler.
+/**
+ * A lambda can not have an associated allocator on its own. It could be
+ *  wrapped instead:
+ * @code
+ *  port.post(cport::bind_allocator(request.allocator(),
+ *      [&request](const cport::generic_error &e) { request.resume(e); }));
+ * @endcode
+ *
+ * @param a The allocator. It must stay usable until the handler is destroyed.
+ *
+ * @param h The handler.
+ */
+template <typename Allocator, typename Handler>
+allocator_binder<typename std::decay<Handler>::type, Allocator>
+bind_allocator(const Allocator &a, Handler&& h);
+
+} // namespace cport
+
+#include <cport/impl/associated_allocator.inl>
+
+#endif // __ASSOCIATED_ALLOCATOR_HPP__
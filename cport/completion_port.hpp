@@ -11,6 +11,11 @@
 //
 
 #include <cport/config.hpp>
+#include <cport/memory_resource.hpp>
+#include <cport/metrics.hpp>
+#include <cport/timer_handle.hpp>
+#include <cport/wait_policy.hpp>
+#include <chrono>
 #include <cport/detail/completion_port_impl.hpp>
 #include <cport/detail/impl_accessor.hpp>
 
@@ -32,6 +37,64 @@ public:
     /// Construct new completion_port.
     CPORT_DECL_TYPE completion_port();
 
+    /// Construct new completion_port with sharded ready queues.
+    /**
+     * Each thread posts handlers to and runs handlers from its own shard,
+     *  and takes handlers from the other shards when its own shard is empty.
+     *  The threads of different shards share no counter when they post or
+     *  run handlers, and the queues of a shard are allocated when a thread
+     *  first uses it. Posted handlers are still invoked in the order a
+     *  thread posted them, but there is no order between handlers posted
+     *  by threads of different shards. Dispatched handlers run before the
+     *  posted ones of their shard.
+     *
+     * @param shards The number of shards.
+     *  0 == number of concurrent threads supported by the system.
+     */
+    CPORT_DECL_TYPE explicit completion_port(std::size_t shards);
+
+    /// Construct new completion_port with priority levels.
+    /**
+     * Posted handlers are queued by priority level, 0 being the highest.
+     *  A ready handler of a level is invoked only when there is no ready
+     *  handler of a higher level, unless aging is enabled by
+     *  set_priority_aging(). Handlers of the same level are invoked in
+     *  FIFO order. Dispatched handlers run before all posted ones. In a
+     *  sharded port the levels are ordered within each shard.
+     *
+     * @param shards The number of shards of each level.
+     *  0 == number of concurrent threads supported by the system.
+     *
+     * @param priority_levels The number of priority levels.
+     */
+    CPORT_DECL_TYPE completion_port(std::size_t shards, std::size_t priority_levels);
+
+    /// Construct new completion_port which allocates from a memory resource.
+    /**
+     * The completion handlers and the ready queues of the port are
+     *  allocated from the resource. So are the handlers of the services
+     *  and the task schedulers using the port, unless a scheduler has its
+     *  own resource.
+     *
+     * @param r The memory resource. It must outlive the port.
+     */
+    CPORT_DECL_TYPE explicit completion_port(memory_resource &r);
+
+    /// Construct new completion_port with priority levels which allocates
+    ///  from a memory resource.
+    /**
+     * @param shards The number of shards of each level.
+     *  0 == number of concurrent threads supported by the system.
+     *
+     * @param priority_levels The number of priority levels.
+     *
+     * @param r The memory resource. It must outlive the port.
+     *
+     * @see completion_port(std::size_t, std::size_t)
+     */
+    CPORT_DECL_TYPE completion_port(std::size_t shards, std::size_t priority_levels,
+        memory_resource &r);
+
     /// Destruct the port.
     /**
      * @note All ready completion handlers will be processed before destroy.
@@ -97,6 +160,88 @@ public:
     template <typename Handler>
     void post(Handler&& h);
 
+    /// Post a completion handler at a priority level and return immediately.
+    /**
+     * @param h The completion handler to be invoked.
+     *
+     * @param e An error to be passed when the handler is invoked.
+     *
+     * @param priority The priority level, 0 is the highest. Levels past the
+     *  last one are clamped to it.
+     *
+     * @see completion_port(std::size_t, std::size_t)
+     */
+    template <typename Handler>
+    void post(Handler&& h, const generic_error& e, std::size_t priority);
+
+    /// Post a completion handler at a priority level and return immediately.
+    /**
+     * @param h The completion handler to be invoked.
+     *
+     * @param priority The priority level, 0 is the highest. Levels past the
+     *  last one are clamped to it.
+     */
+    template <typename Handler>
+    void post(Handler&& h, std::size_t priority);
+
+    /// Post a range of completion handlers and return immediately.
+    /**
+     * All handlers are copied and inserted at once, waking at most one
+     *  blocked thread per handler.
+     *
+     * @param first The beginning of the range of completion handlers.
+     *
+     * @param last The end of the range of completion handlers.
+     *
+     * @returns The number of posted handlers.
+     *
+     * @see post_batch
+     */
+    template <typename InputIterator>
+    std::size_t post_range(InputIterator first, InputIterator last);
+
+    /// Post a completion handler after a timeout duration elapses.
+    /**
+     * The handler is posted with no error when the duration elapses, or with
+     *  operation_aborted error if the timer is canceled or the port is
+     *  destroyed before that. Until then the timer is counted as an enqueued
+     *  operation, so wait() blocks for it. Timers are kept in a hierarchical
+     *  timing wheel with a resolution of one millisecond, served by a thread
+     *  started on first use.
+     *
+     * @param d The duration after which the handler is posted.
+     *
+     * @param h The completion handler to be invoked.
+     *
+     * @returns A timer identifier, invalid if the port is stopped.
+     */
+    template <typename Rep, typename Period, typename Handler>
+    timer_handle post_after(const std::chrono::duration<Rep, Period> &d, Handler&& h);
+
+    /// Post a completion handler when a time point is reached.
+    /**
+     * @param tp The time point at which the handler is posted.
+     *
+     * @param h The completion handler to be invoked.
+     *
+     * @returns A timer identifier, invalid if the port is stopped.
+     *
+     * @see post_after
+     */
+    template <typename Clock, typename Duration, typename Handler>
+    timer_handle post_at(const std::chrono::time_point<Clock, Duration> &tp, Handler&& h);
+
+    /// Cancel a timer.
+    /**
+     * The completion handler is posted with operation_aborted error.
+     *  The method call has no effect if the timer has already expired.
+     *
+     * @param t An identifier of the timer to be canceled.
+     *
+     * @returns true if the timer was canceled.
+     */
+    bool cancel(const timer_handle &t);
+
     /// Call a completion handler.
     /**
      * Call a completion handler in calling thread.
@@ -153,6 +298,124 @@ public:
      */
     bool run_one();
 
+    /// Run processing of a batch of ready completion handlers.
+    /**
+     * This method will block the calling thread until at least one handler
+     *  is ready or stop() method is called. Up to max ready handlers are then
+     *  claimed at once and processed in the calling thread.
+     *
+     * @param max The maximum number of handlers to process.
+     *
+     * @returns The number of processed handlers.
+     */
+    std::size_t run_batch(std::size_t max);
+
+    /// Wait for enqueued operations to be processed for a limited time.
+    /**
+     * This method will block the calling thread until all enqueued operations
+     *  are executed and all ready completion handlers are processed, or until
+     *  the specified timeout duration elapses.
+     *
+     * @param d The maximum time to wait.
+     *
+     * @returns The number of processed handlers.
+     */
+    template <typename Rep, typename Period>
+    std::size_t wait_for(const std::chrono::duration<Rep, Period> &d);
+
+    /// Wait for enqueued operations to be processed until a time point.
+    /**
+     * This method will block the calling thread until all enqueued operations
+     *  are executed and all ready completion handlers are processed, or until
+     *  the specified time point has been reached. The time point is checked
+     *  before each handler, so handlers which keep becoming ready do not
+     *  extend the wait.
+     *
+     * @param tp The time point to wait until.
+     *
+     * @returns The number of processed handlers.
+     */
+    template <typename Clock, typename Duration>
+    std::size_t wait_until(const std::chrono::time_point<Clock, Duration> &tp);
+
+    /// Wait for one ready completion handler to be processed for a limited time.
+    /**
+     * Behaves as wait_one(), but returns false if no handler becomes ready
+     *  within the specified timeout duration.
+     *
+     * @param d The maximum time to wait.
+     *
+     * @returns true if a handler was processed, otherwise returns false.
+     */
+    template <typename Rep, typename Period>
+    bool wait_one_for(const std::chrono::duration<Rep, Period> &d);
+
+    /// Wait for one ready completion handler to be processed until a time point.
+    /**
+     * Behaves as wait_one(), but returns false if no handler becomes ready
+     *  until the specified time point.
+     *
+     * @param tp The time point to wait until.
+     *
+     * @returns true if a handler was processed, otherwise returns false.
+     */
+    template <typename Clock, typename Duration>
+    bool wait_one_until(const std::chrono::time_point<Clock, Duration> &tp);
+
+    /// Run processing of ready completion handlers for a limited time.
+    /**
+     * This method will block the calling thread until stop() method is called
+     *  or the specified timeout duration elapses. The port is not stopped
+     *  when the time elapses, so there is no need to call reset().
+     *
+     * @param d The time to run for.
+     *
+     * @returns The number of processed handlers.
+     */
+    template <typename Rep, typename Period>
+    std::size_t run_for(const std::chrono::duration<Rep, Period> &d);
+
+    /// Run processing of ready completion handlers until a time point.
+    /**
+     * This method will block the calling thread until stop() method is called
+     *  or the specified time point has been reached. The port is not stopped
+     *  when the time point is reached, so there is no need to call reset().
+     *  The time point is checked before each handler, so handlers which keep
+     *  becoming ready do not extend the run.
+     *
+     * @param tp The time point to run until.
+     *
+     * @returns The number of processed handlers.
+     */
+    template <typename Clock, typename Duration>
+    std::size_t run_until(const std::chrono::time_point<Clock, Duration> &tp);
+
+    /// Run processing of one ready completion handler for a limited time.
+    /**
+     * This method will block the calling thread until one handler is
+     *  processed, stop() method is called or the specified timeout
+     *  duration elapses.
+     *
+     * @param d The maximum time to wait.
+     *
+     * @returns true if a handler was processed, otherwise will return false.
+     */
+    template <typename Rep, typename Period>
+    bool run_one_for(const std::chrono::duration<Rep, Period> &d);
+
+    /// Run processing of one ready completion handler until a time point.
+    /**
+     * This method will block the calling thread until one handler is
+     *  processed, stop() method is called or the specified time point
+     *  has been reached.
+     *
+     * @param tp The time point to wait until.
+     *
+     * @returns true if a handler was processed, otherwise will return false.
+     */
+    template <typename Clock, typename Duration>
+    bool run_one_until(const std::chrono::time_point<Clock, Duration> &tp);
+
     /// Run processing of ready completion handlers.
     /**
      * This method will return when there is no ready handlers, without blocking
@@ -162,6 +425,17 @@ public:
      */
     std::size_t pull();
 
+    /// Run processing of a batch of ready completion handlers.
+    /**
+     * Up to max ready handlers are claimed at once and processed in the
+     *  calling thread. This method does not block the calling thread.
+     *
+     * @param max The maximum number of handlers to process.
+     *
+     * @returns The number of processed handlers.
+     */
+    std::size_t pull_n(std::size_t max);
+
     /// Run processing of one ready completion handlers.
     /**
      * This method will return when there is no ready handlers, without blocking
@@ -187,9 +461,86 @@ public:
     /// Get the number of completion handlers, ready to be called.
     std::size_t ready_handlers() const;
 
+    /// Get the number of posted completion handlers of a priority level, ready to be called.
+    std::size_t ready_handlers(std::size_t priority) const;
+
     /// Get the number of threads blocked on wait(), wait_one(), run() or run_one() methods
     std::size_t blocked_threads() const;
 
+    /// Get the number of shards of the ready queue.
+    std::size_t shards() const;
+
+    /// Get the number of priority levels.
+    std::size_t priority_levels() const;
+
+    /// Prevent starvation of the lower priority levels.
+    /**
+     * A level which has ready handlers and was passed over limit times in
+     *  favor of higher levels gets the next turn. The count is approximate
+     *  when many threads run the port.
+     *
+     * @param limit The number of times a level could be passed over.
+     *  0 == strict priority, the default.
+     */
+    void set_priority_aging(std::size_t limit);
+
+    /// Get the aging limit of the priority levels.
+    std::size_t get_priority_aging() const;
+
+    /// Set how threads wait for ready handlers before they are blocked.
+    /**
+     * The policy applies to wait(), wait_one(), run(), run_one() and
+     *  run_batch() methods. Threads that are spinning or yielding are not
+     *  counted by blocked_threads().
+     *
+     * @param wp The wait policy.
+     */
+    void set_wait_policy(const wait_policy &wp);
+
+    /// Get the current wait policy.
+    wait_policy get_wait_policy() const;
+
+    /// Get the number of waits satisfied in each phase of the wait policy.
+    wait_stats get_wait_stats() const;
+
+    /// Get the memory resource the port allocates from.
+    memory_resource* get_memory_resource() const;
+
+    /// Get a snapshot of the runtime metrics of the port.
+    /**
+     * The method does not lock and does not block the threads using the
+     *  port. The counters are cheap to update, so they are collected
+     *  unless the library is built with CPORT_DISABLE_METRICS. In that
+     *  configuration the counters and the high-water mark stay zero, and
+     *  only the number of ready handlers is reported.
+     *
+     * @see port_metrics
+     */
+    port_metrics snapshot() const;
+
+#ifdef CPORT_HAS_EVENTFD
+    /// The type of the native handle.
+    typedef int native_handle_type;
+
+    /// Get a file descriptor which is readable while there are ready handlers.
+    /**
+     * It allows an external event loop (epoll, poll, select) to wait for the
+     *  port without blocking a thread in run_one() or polling pull_one().
+     *  When the descriptor becomes readable call pull() or pull_n(). It is
+     *  drained when the last ready handler is claimed, and it may report a
+     *  readable state spuriously, so pull() could process no handlers.
+     *
+     * The eventfd descriptor is created on the first call and is owned by
+     *  the port. Only then posting handlers starts to signal it.
+     *  Available on Linux only, unless CPORT_DISABLE_EVENTFD is defined.
+     *
+     * @returns The eventfd file descriptor.
+     *
+     * @throw std::system_error if the descriptor can not be created.
+     */
+    native_handle_type native_handle();
+#endif // CPORT_HAS_EVENTFD
+
     /// The implementation type.
     typedef detail::completion_port_impl impl_type;
 protected:
@@ -9,4 +9,79 @@
     #endif // CPORT_HEADER_ONLY_LIB
 #endif // CPORT_DECL_TYPE
 
+#ifndef CPORT_CACHELINE_SIZE
+    #define CPORT_CACHELINE_SIZE 64
+#endif // CPORT_CACHELINE_SIZE
+
+// Pooled handler objects up to this size, including the captured state,
+//  are stored in nodes of power of two size classes. The larger ones are
+//  allocated one by one.
+#ifndef CPORT_POOL_MAX_NODE_SIZE
+    #define CPORT_POOL_MAX_NODE_SIZE 4096
+#endif // CPORT_POOL_MAX_NODE_SIZE
+
+// The number of freed objects each thread caches per pool before it
+//  hands them to the shared depot in one batch.
+#ifndef CPORT_POOL_MAGAZINE_SIZE
+    #define CPORT_POOL_MAGAZINE_SIZE 32
+#endif // CPORT_POOL_MAGAZINE_SIZE
+
+// The number of shards of the metric counters. Threads are spread over
+//  the shards, so the threads updating a counter rarely share a cache line.
+#ifndef CPORT_METRICS_SHARDS
+    #define CPORT_METRICS_SHARDS 16
+#endif // CPORT_METRICS_SHARDS
+
+#ifndef CPORT_HAS_METRICS
+    #if !defined(CPORT_DISABLE_METRICS)
+        #define CPORT_HAS_METRICS 1
+    #endif
+#endif // CPORT_HAS_METRICS
+
+#ifndef CPORT_HAS_TRACING
+    #if !defined(CPORT_DISABLE_TRACING)
+        #define CPORT_HAS_TRACING 1
+    #endif
+#endif // CPORT_HAS_TRACING
+
+// The internal mutexes account their contention, see lock_profiler.
+//  Off by default, as it adds two clock reads to each lock.
+#ifndef CPORT_HAS_LOCK_PROFILING
+    #if defined(CPORT_ENABLE_LOCK_PROFILING)
+        #define CPORT_HAS_LOCK_PROFILING 1
+    #endif
+#endif // CPORT_HAS_LOCK_PROFILING
+
+#ifndef CPORT_HAS_EVENTFD
+    #if defined(__linux__) && !defined(CPORT_DISABLE_EVENTFD)
+        #define CPORT_HAS_EVENTFD 1
+    #endif
+#endif // CPORT_HAS_EVENTFD
+
+#ifndef CPORT_HAS_FUTEX
+    #if defined(__linux__) && !defined(CPORT_DISABLE_FUTEX)
+        #define CPORT_HAS_FUTEX 1
+    #endif
+#endif // CPORT_HAS_FUTEX
+
+#ifndef CPORT_HAS_EPOLL
+    #if defined(__linux__) && !defined(CPORT_DISABLE_EPOLL)
+        #define CPORT_HAS_EPOLL 1
+    #endif
+#endif // CPORT_HAS_EPOLL
+
+#ifndef CPORT_HAS_FILE_SERVICE
+    #if defined(__unix__) || defined(__APPLE__)
+        #define CPORT_HAS_FILE_SERVICE 1
+    #endif
+#endif // CPORT_HAS_FILE_SERVICE
+
+#ifndef CPORT_HAS_IO_URING
+    #if defined(__linux__) && !defined(CPORT_DISABLE_IO_URING) && defined(__has_include)
+        #if __has_include(<linux/io_uring.h>)
+            #define CPORT_HAS_IO_URING 1
+        #endif
+    #endif
+#endif // CPORT_HAS_IO_URING
+
 #endif // __CPORT_CONFIG_HPP__
@@ -0,0 +1,119 @@
+#ifndef __ADAPTIVE_WAIT_HPP__
+#define __ADAPTIVE_WAIT_HPP__
+
+//
+// adaptive_wait.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/wait_policy.hpp>
+#include <atomic>
+#include <thread>
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#endif
+
+namespace cport {
+
+namespace detail {
+
+// Hint the processor that the calling thread is in a spin loop.
+inline void cpu_relax()
+{
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+    _mm_pause();
+#elif defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+// Implements the spin and yield phases of a wait_policy and counts the
+//  phase in which each wait was satisfied. Blocking is left to the owner.
+class adaptive_wait {
+public:
+    adaptive_wait()
+        : spin_count_(0)
+        , yield_count_(0)
+        , spins_(0)
+        , yields_(0)
+        , parks_(0)
+    {
+    }
+
+    adaptive_wait(const adaptive_wait&) = delete;
+
+    adaptive_wait& operator=(const adaptive_wait&) = delete;
+
+    void set_policy(const wait_policy &wp)
+    {
+        spin_count_.store(wp.spin_count, std::memory_order_relaxed);
+        yield_count_.store(wp.yield_count, std::memory_order_relaxed);
+    }
+
+    wait_policy get_policy() const
+    {
+        return wait_policy(spin_count_.load(std::memory_order_relaxed),
+            yield_count_.load(std::memory_order_relaxed));
+    }
+
+    wait_stats get_stats() const
+    {
+        wait_stats ws;
+        ws.spins = spins_.load(std::memory_order_relaxed);
+        ws.yields = yields_.load(std::memory_order_relaxed);
+        ws.parks = parks_.load(std::memory_order_relaxed);
+        return ws;
+    }
+
+    // Poll pred according to the policy. Return false if the caller
+    //  should block.
+    template <typename Predicate>
+    bool spin(Predicate pred)
+    {
+        const std::size_t spins = spin_count_.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < spins; ++i) {
+            if (pred()) {
+                spins_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            cpu_relax();
+        }
+
+        const std::size_t yields = yield_count_.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < yields; ++i) {
+            if (pred()) {
+                yields_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            std::this_thread::yield();
+        }
+        return false;
+    }
+
+    // Count a thread about to block.
+    void parked()
+    {
+        parks_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<std::size_t> spin_count_;
+    std::atomic<std::size_t> yield_count_;
+    std::atomic<std::size_t> spins_;
+    std::atomic<std::size_t> yields_;
+    std::atomic<std::size_t> parks_;
+};
+
+} // namespace detail
+
+} // namespace cport
+
+#endif // __ADAPTIVE_WAIT_HPP__
@@ -0,0 +1,240 @@
+#ifndef __CHASE_LEV_DEQUE_HPP__
+#define __CHASE_LEV_DEQUE_HPP__
+
+//
+// chase_lev_deque.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/config.hpp>
+#include <cport/memory_resource.hpp>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <new>
+
+namespace cport {
+
+namespace detail {
+
+// A work-stealing deque of pointers (Chase and Lev, with the memory
+//  orderings of Le et al., "Correct and Efficient Work-Stealing for Weak
+//  Memory Models").
+//
+// The owner thread pushes and pops at the bottom, LIFO. Any other thread
+//  steals from the top, FIFO. The circular array grows when full; the
+//  outgrown arrays are kept until destruction, as a thief may still be
+//  reading them. The arrays are allocated from the memory resource.
+//
+// The extract and drain operations need exclusive access to the deque.
+template <typename T>
+class chase_lev_deque {
+public:
+    explicit chase_lev_deque(std::size_t capacity = 256,
+        memory_resource &r = *get_default_resource())
+        : resource_(r)
+        , top_(0)
+        , bottom_(0)
+        , array_(create_array(round_capacity(capacity), nullptr))
+    {
+    }
+
+    ~chase_lev_deque()
+    {
+        array_type *a = array_.load(std::memory_order_relaxed);
+        while (a != nullptr) {
+            array_type *previous = a->previous;
+            destroy_array(a);
+            a = previous;
+        }
+    }
+
+    chase_lev_deque(const chase_lev_deque&) = delete;
+
+    chase_lev_deque& operator=(const chase_lev_deque&) = delete;
+
+    // Called only by the owner.
+    void push(T *value)
+    {
+        const std::int64_t b = bottom_.load(std::memory_order_relaxed);
+        const std::int64_t t = top_.load(std::memory_order_acquire);
+        array_type *a = array_.load(std::memory_order_relaxed);
+        if (b - t > static_cast<std::int64_t>(a->mask)) {
+            a = grow(a, t, b);
+            array_.store(a, std::memory_order_release);
+        }
+        a->at(b).store(value, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // Called only by the owner. Return nullptr if the deque is empty.
+    T* pop()
+    {
+        const std::int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        array_type *a = array_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top_.load(std::memory_order_relaxed);
+
+        T *value = nullptr;
+        if (t <= b) {
+            value = a->at(b).load(std::memory_order_relaxed);
+            if (t == b) {
+                // The last element, race with the thieves
+                if (!top_.compare_exchange_strong(t, t + 1,
+                        std::memory_order_seq_cst, std::memory_order_relaxed))
+                    value = nullptr;
+                bottom_.store(b + 1, std::memory_order_relaxed);
+            }
+        }
+        else {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+        return value;
+    }
+
+    // Return nullptr if the deque is empty or another thread won the race
+    //  for the top element.
+    T* steal()
+    {
+        std::int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b)
+            return nullptr;
+
+        array_type *a = array_.load(std::memory_order_acquire);
+        T *value = a->at(t).load(std::memory_order_relaxed);
+        if (!top_.compare_exchange_strong(t, t + 1,
+                std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+        return value;
+    }
+
+    // The number of elements, exact only when the deque is not modified.
+    std::size_t size() const
+    {
+        const std::int64_t b = bottom_.load(std::memory_order_relaxed);
+        const std::int64_t t = top_.load(std::memory_order_relaxed);
+        return b > t ? static_cast<std::size_t>(b - t) : 0;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    // Remove the oldest element matching pred and return it, or nullptr
+    //  if there is none. The deque must not be used by other threads.
+    template <typename Predicate>
+    T* extract(Predicate pred)
+    {
+        const std::int64_t t = top_.load(std::memory_order_relaxed);
+        const std::int64_t b = bottom_.load(std::memory_order_relaxed);
+        array_type *a = array_.load(std::memory_order_relaxed);
+        for (std::int64_t i = t; i < b; ++i) {
+            T *value = a->at(i).load(std::memory_order_relaxed);
+            if (!pred(value))
+                continue;
+
+            // Close the gap by moving the older elements up
+            for (std::int64_t j = i; j > t; --j)
+                a->at(j).store(a->at(j - 1).load(std::memory_order_relaxed),
+                    std::memory_order_relaxed);
+            top_.store(t + 1, std::memory_order_relaxed);
+            return value;
+        }
+        return nullptr;
+    }
+
+    // Remove all elements, oldest first, calling f for each one. The
+    //  deque must not be used by other threads.
+    template <typename Func>
+    std::size_t drain(Func f)
+    {
+        const std::int64_t t = top_.load(std::memory_order_relaxed);
+        const std::int64_t b = bottom_.load(std::memory_order_relaxed);
+        array_type *a = array_.load(std::memory_order_relaxed);
+        for (std::int64_t i = t; i < b; ++i)
+            f(a->at(i).load(std::memory_order_relaxed));
+        if (b > t)
+            top_.store(b, std::memory_order_relaxed);
+        return b > t ? static_cast<std::size_t>(b - t) : 0;
+    }
+
+private:
+    struct array_type {
+        std::size_t mask;
+        // The outgrown array
+        array_type *previous;
+
+        std::atomic<T *>& at(std::int64_t i)
+        {
+            return slots()[static_cast<std::size_t>(i) & mask];
+        }
+
+        std::atomic<T *>* slots()
+        {
+            return reinterpret_cast<std::atomic<T *> *>(this + 1);
+        }
+    };
+
+    static std::size_t round_capacity(std::size_t capacity)
+    {
+        std::size_t c = 2;
+        while (c < capacity)
+            c <<= 1;
+        return c;
+    }
+
+    static std::size_t array_bytes(std::size_t capacity)
+    {
+        return sizeof(array_type) + sizeof(std::atomic<T *>) * capacity;
+    }
+
+    array_type* create_array(std::size_t capacity, array_type *previous)
+    {
+        array_type *a = static_cast<array_type *>(
+            resource_.allocate(array_bytes(capacity), alignof(array_type)));
+        a->mask = capacity - 1;
+        a->previous = previous;
+        for (std::size_t i = 0; i < capacity; ++i)
+            new (&a->slots()[i]) std::atomic<T *>(nullptr);
+        return a;
+    }
+
+    void destroy_array(array_type *a)
+    {
+        // The slots are trivially destructible
+        resource_.deallocate(a, array_bytes(a->mask + 1), alignof(array_type));
+    }
+
+    array_type* grow(array_type *a, std::int64_t t, std::int64_t b)
+    {
+        array_type *grown = create_array((a->mask + 1) * 2, a);
+        for (std::int64_t i = t; i < b; ++i)
+            grown->at(i).store(a->at(i).load(std::memory_order_relaxed),
+                std::memory_order_relaxed);
+        return grown;
+    }
+
+    typedef char cacheline_pad[CPORT_CACHELINE_SIZE];
+
+    memory_resource &resource_;
+    cacheline_pad pad0_;
+    std::atomic<std::int64_t> top_;
+    cacheline_pad pad1_;
+    std::atomic<std::int64_t> bottom_;
+    std::atomic<array_type *> array_;
+};
+
+} // namespace detail
+
+} // namespace cport
+
+#endif // __CHASE_LEV_DEQUE_HPP__
@@ -11,7 +11,7 @@
 //
 
 #include <cport/detail/completion_handler_base.hpp>
-#include <cport/detail/obj_mem_pool.hpp>
+#include <cport/detail/resource_obj.hpp>
 #include <cassert>
 
 namespace cport {
@@ -20,20 +20,17 @@ namespace detail {
 
 template <typename Handler>
 class completion_handler : public completion_handler_base {
-    DECLARE_OBJ_MEMORY_POOL(completion_handler)
 public:
     completion_handler(const Handler& handler, std::size_t seqno,
-        const generic_error& e)
-        : completion_handler_base(&completion_handler::invoke_,
-            &completion_handler::destroy_, seqno, e)
+        const error_code& e)
+        : completion_handler_base(&table_, seqno, e)
         , handler_(handler)
     {
     }
 
     completion_handler(Handler&& handler, std::size_t seqno,
-        const generic_error& e)
-        : completion_handler_base(&completion_handler::invoke_,
-            &completion_handler::destroy_, seqno, e)
+        const error_code& e)
+        : completion_handler_base(&table_, seqno, e)
         , handler_(std::move(handler))
     {
     }
@@ -47,13 +44,19 @@ public:
         handler_(e);
     }
 
+    Handler& handler()
+    {
+        return handler_;
+    }
+
 private:
     typedef completion_handler<Handler> this_type;
 
     static void destroy_(destroyable_obj *base)
     {
         assert(base != nullptr);
-        delete static_cast<this_type *>(base);
+        this_type *h = static_cast<this_type *>(base);
+        handler_alloc<typename std::decay<Handler>::type>::destroy(h, h->handler_);
     }
 
     static void invoke_(completion_handler_base *base,
@@ -63,19 +66,27 @@ private:
         static_cast<this_type *>(base)->invoke(e);
     }
 
+    static const vtable_type table_;
+
     Handler handler_;
 };
 
+template <typename Handler>
+const completion_handler_base::vtable_type completion_handler<Handler>::table_ = {
+    { &completion_handler<Handler>::destroy_ },
+    &completion_handler<Handler>::invoke_
+};
+
 template <typename Handler>
 inline completion_handler<typename std::remove_reference<Handler>::type>* 
-create_completion_handler(Handler&& h, std::size_t seq, const generic_error& e)
+create_completion_handler(memory_resource &r, Handler&& h, std::size_t seq,
+    const error_code& e)
 {
-    return new completion_handler<typename std::remove_reference<Handler>::type>(
-        std::forward<typename std::remove_reference<Handler>::type>(h), seq, e);
+    return handler_alloc<typename std::decay<Handler>::type>::template create<
+        completion_handler<typename std::remove_reference<Handler>::type>>(
+            r, h, std::forward<Handler>(h), seq, e);
 }
 
-IMPLEMENT_OBJ_MEMORY_POOL_T1(completion_handler, H);
-
 } // namespace detail
 
 } // namespace cport
@@ -12,30 +12,33 @@
 
 #include <cport/error_types.hpp>
 #include <cport/detail/destroyable_obj.hpp>
+#include <cstddef>
 
 namespace cport {
 
 namespace detail {
 
 class completion_handler_base : public destroyable_obj {
-    using invoke_helper_type = std::function<
-        void(completion_handler_base*, const generic_error&)
-    >;
 public:
-    completion_handler_base(invoke_helper_type invoke_helper,
-                            destroy_helper_type destroy_helper,
+    // One static table per handler type
+    struct vtable_type {
+        destroyable_obj::vtable_type destroyable;
+        void (*invoke)(completion_handler_base *, const generic_error &);
+    };
+
+    completion_handler_base(const vtable_type *vtable,
                             std::size_t seqno,
-                            const generic_error &generic_error)
-        : destroyable_obj(destroy_helper)
-        , invoke_helper_(invoke_helper)
+                            const error_code &e)
+        : destroyable_obj(&vtable->destroyable)
         , seqno_(seqno)
-        , error_(generic_error)
+        , error_(e)
     {
     }
 
     void complete()
     {
-        invoke_helper_(this, error_);
+        // The table of the destroyable base is the first member of vtable_type
+        reinterpret_cast<const vtable_type *>(vtable())->invoke(this, error_.error());
     }
 
     std::size_t seqno() const
@@ -43,13 +46,17 @@ public:
         return seqno_;
     }
 
+    void set_error(const error_code &e)
+    {
+        error_ = e;
+    }
+
 protected:
     ~completion_handler_base() = default;
 
 private:
-    invoke_helper_type invoke_helper_;
     std::size_t seqno_;
-    generic_error error_;
+    error_code error_;
 };
 
 } // namespace detail
@@ -11,37 +11,77 @@
 //
 
 #include <cport/config.hpp>
+#include <cport/memory_resource.hpp>
+#include <cport/metrics.hpp>
+#include <cport/timer_handle.hpp>
+#include <cport/detail/adaptive_wait.hpp>
 #include <cport/detail/completion_handler_base.hpp>
+#include <cport/detail/concurrent_histogram.hpp>
+#include <cport/detail/deadline.hpp>
+#include <cport/detail/mpmc_queue.hpp>
+#include <cport/detail/profiled_mutex.hpp>
+#include <cport/detail/sharded_counter.hpp>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <limits>
 #include <memory>
-#include <queue>
+#include <mutex>
+#include <vector>
 
 namespace cport {
 
 namespace detail {
 
+class timer_service_impl;
+
 class completion_port_impl {
     typedef std::unique_ptr<completion_handler_base, destroyable_deletor> auto_destroy;
+    typedef mpmc_queue<completion_handler_base> handler_queue;
 public:
-    CPORT_DECL_TYPE completion_port_impl();
+    // Handlers and queues are allocated from the resource, or from the
+    //  default resource if r is nullptr.
+    CPORT_DECL_TYPE explicit completion_port_impl(std::size_t shards = 1,
+        std::size_t priority_levels = 1, memory_resource *r = nullptr);
 
     CPORT_DECL_TYPE ~completion_port_impl();
 
     template <typename Handler>
-    void dispatch(Handler&& h, const generic_error& e);
+    void dispatch(Handler&& h, const error_code& e);
 
     template <typename Handler>
-    void post(Handler&& h, std::size_t seqno, const generic_error& e);
+    void post(Handler&& h, std::size_t seqno, const error_code& e,
+        std::size_t priority = 0);
 
     template <typename Handler>
     void call(Handler&& h, const generic_error& e);
 
+    template <typename Handler>
+    timer_handle post_at(Handler&& h, const std::chrono::steady_clock::time_point &tp);
+
+    CPORT_DECL_TYPE bool cancel(const timer_handle &t);
+
+    // Posted handlers are queued at the priority level, dispatched ones
+    //  are not affected by it.
+    CPORT_DECL_TYPE void post(completion_handler_base *const *handlers,
+        std::size_t count, std::size_t priority = 0);
+
     CPORT_DECL_TYPE bool wait_one();
 
     CPORT_DECL_TYPE bool run_one();
+
+    CPORT_DECL_TYPE std::size_t run_batch(std::size_t max);
+
+    template <typename Clock, typename Duration>
+    bool wait_one_until(const std::chrono::time_point<Clock, Duration> &tp);
+
+    template <typename Clock, typename Duration>
+    bool run_one_until(const std::chrono::time_point<Clock, Duration> &tp);
     
     bool pull_one();
 
+    std::size_t pull_n(std::size_t max);
+
     void reset();
 
     void stop();
@@ -50,41 +90,174 @@ public:
 
     std::size_t ready_handlers() const;
 
+    std::size_t ready_handlers(std::size_t priority) const;
+
     std::size_t blocked_threads() const;
 
+    void set_wait_policy(const wait_policy &wp);
+
+    wait_policy get_wait_policy() const;
+
+    wait_stats get_wait_stats() const;
+
+    CPORT_DECL_TYPE port_metrics snapshot() const;
+
+    // The delay of the completion handlers posted by the scheduled tasks
+    concurrent_histogram& task_completion_latency();
+
+    std::size_t shards() const;
+
+    std::size_t priority_levels() const;
+
+    void set_priority_aging(std::size_t limit);
+
+    std::size_t get_priority_aging() const;
+
     CPORT_DECL_TYPE std::size_t next_operation_id();
+
+    // The sequence number of a handler posted directly. It is ready at
+    //  once, so it is not counted as a queued operation. Zero when the
+    //  port is stopped, as next_operation_id() returns.
+    std::size_t post_seqno() const;
+
+    // The sequence number of the directly posted handlers, which no
+    //  operation takes. A handler with it is posted even if the port is
+    //  stopped, so it runs after the handlers posted before it.
+    static std::size_t direct_seqno()
+    {
+        return std::numeric_limits<std::size_t>::max();
+    }
+
+    memory_resource& resource() const;
+
+#ifdef CPORT_HAS_EVENTFD
+    CPORT_DECL_TYPE int native_handle();
+#endif // CPORT_HAS_EVENTFD
     
 private:
-    CPORT_DECL_TYPE void post(completion_handler_base *h);
+    CPORT_DECL_TYPE std::size_t local_shard() const;
 
-    CPORT_DECL_TYPE bool do_one(std::unique_lock<std::mutex> &lock);
+    CPORT_DECL_TYPE timer_handle schedule_timer(completion_handler_base *h,
+        const std::chrono::steady_clock::time_point &tp);
 
-    bool stopped_;
-    // Number of threads blocked on wait_one operation
-    std::size_t run_one_threads_;
-    // Number of threads blocked on wait_one operation
-    std::size_t wait_one_threads_;
-    std::size_t queued_ops_;
-    std::size_t seqno_;
-    mutable std::mutex guard_;
-    std::condition_variable cond_;
+    void post(completion_handler_base *h, std::size_t priority = 0);
 
-    struct priority_less_pred
-    {
-        const std::size_t gap;
+    struct lane;
+
+    // The lane of the dispatched handlers is 0, of priority level l is l + 1
+    lane& lane_at(std::size_t shard, std::size_t index) const;
+
+    CPORT_DECL_TYPE handler_queue& lane_queue(lane &l);
+
+    // True if a handler is ready in any shard
+    CPORT_DECL_TYPE bool has_ready() const;
+
+    // Claim from the own shard of the thread first, then from the others.
+    //  Return the number of claimed handlers and set shard to theirs.
+    CPORT_DECL_TYPE std::size_t claim_ready(std::size_t max, std::size_t &shard);
+
+    CPORT_DECL_TYPE completion_handler_base* pop_claimed(std::size_t shard);
+
+    CPORT_DECL_TYPE completion_handler_base* pop_lane(std::size_t shard,
+        std::size_t index);
+
+    CPORT_DECL_TYPE void release_claimed(std::size_t shard, std::size_t count);
+
+    CPORT_DECL_TYPE std::size_t do_batch(std::size_t max);
+
+    template <typename Deadline>
+    bool do_wait_one(const Deadline &deadline);
+
+    template <typename Deadline>
+    std::size_t do_run(std::size_t max, const Deadline &deadline);
 
-        priority_less_pred& operator=(const priority_less_pred &) = delete;
+    bool do_one();
 
-        CPORT_DECL_TYPE priority_less_pred();
+    // Called with the number of ready handlers before some were added
+    void ready_added(std::size_t prev);
 
-        CPORT_DECL_TYPE std::size_t diff(std::size_t s1, std::size_t s2);
+    // Called when the last ready handler of a shard is claimed
+    void ready_drained();
 
-        CPORT_DECL_TYPE bool operator()(const completion_handler_base *h1,
-                                        const completion_handler_base *h2);
+#ifdef CPORT_HAS_EVENTFD
+    CPORT_DECL_TYPE void signal_event();
+
+    CPORT_DECL_TYPE void drain_event();
+#endif // CPORT_HAS_EVENTFD
+
+    memory_resource &resource_;
+    std::atomic<bool> stopped_;
+    // Number of threads blocked on run_one operation
+    std::atomic<std::size_t> run_one_threads_;
+    // Number of threads blocked on wait_one operation
+    std::atomic<std::size_t> wait_one_threads_;
+    // Operations which will post a handler, the direct posts excluded
+    std::atomic<std::size_t> queued_ops_;
+    std::atomic<std::size_t> seqno_;
+    struct guard_site {
+        static const char* name() { return "completion_port_impl::guard_"; }
+    };
+    typedef site_mutex<guard_site> mutex_type;
+    // Used only to park and wake blocked threads
+    mutable mutex_type guard_;
+    site_condition_variable cond_;
+    adaptive_wait waiter_;
+
+    // Each thread posts to and claims from its own shard, and claims from
+    //  the others only when its shard is empty. The shards share no
+    //  counter on the post and claim paths.
+    struct shard_state {
+        // Handlers pushed to the shard and not yet claimed by a runner
+        std::atomic<std::size_t> ready;
+        char pad[CPORT_CACHELINE_SIZE];
+    };
+    std::size_t shards_;
+    std::unique_ptr<shard_state[]> shard_state_;
+
+    // A FIFO of handlers of one shard: the dispatched ones (seqno 0), which
+    //  run before the posted ones of the shard, or the posted ones of a
+    //  priority level. The queue of a sharded port is allocated on first
+    //  use, so the shards no thread runs on cost no ring.
+    struct lane {
+        std::atomic<handler_queue *> queue;
+        // Handlers pushed to the lane and not yet popped
+        std::atomic<std::size_t> depth;
+        char pad[CPORT_CACHELINE_SIZE];
+    };
+    // The lanes of each shard, stored shard by shard
+    std::unique_ptr<lane[]> lanes_;
+
+    struct level_state {
+        // Pops of higher levels since the level was last served while
+        //  it had handlers
+        std::atomic<std::size_t> skipped;
+        char pad[CPORT_CACHELINE_SIZE];
     };
+    const std::size_t levels_;
+    std::unique_ptr<level_state[]> level_state_;
+    // A lower level is served after being skipped that many times, 0 if never
+    std::atomic<std::size_t> aging_;
+
+    enum {
+        metric_posted,
+        metric_dispatched,
+        metric_completed,
+        metric_count
+    };
+    sharded_counters<metric_count> metrics_;
+    std::atomic<std::size_t> ready_high_water_;
+    concurrent_histogram task_completion_latency_;
+
+    // Started on first use of post_at()
+    std::once_flag timers_once_;
+    std::unique_ptr<timer_service_impl> timers_;
 
-    std::priority_queue<completion_handler_base *,
-        std::vector<completion_handler_base *>, priority_less_pred> handlers_;
+#ifdef CPORT_HAS_EVENTFD
+    // Readable while there are ready handlers. Created on first use of
+    //  native_handle(), -1 until then.
+    std::once_flag event_once_;
+    std::atomic<int> event_fd_;
+#endif // CPORT_HAS_EVENTFD
 };
 
 } // namespace detail
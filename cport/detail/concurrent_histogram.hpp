@@ -0,0 +1,144 @@
+#ifndef __CONCURRENT_HISTOGRAM_HPP__
+#define __CONCURRENT_HISTOGRAM_HPP__
+
+//
+// concurrent_histogram.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/latency_histogram.hpp>
+#include <cport/detail/histogram_buckets.hpp>
+#include <cport/detail/sharded_counter.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+namespace cport {
+
+namespace detail {
+
+// A latency histogram recorded by many threads without locking.
+//
+// The histogram is split in the shards of metrics_shard_registry, as the
+//  sharded_counters are. A thread records to the shard it owns with relaxed
+//  loads and stores, and only the threads sharing the last shard use atomic
+//  read-modify-write. A shard is allocated by the first thread recording to
+//  it, so an idle histogram costs no bucket memory. The minimum and the
+//  maximum of a shard are written only when they change. The count is the
+//  sum of the buckets, so a snapshot is always consistent with itself.
+class concurrent_histogram {
+public:
+    concurrent_histogram()
+    {
+        for (std::size_t s = 0; s < CPORT_METRICS_SHARDS; ++s)
+            shards_[s].store(nullptr, std::memory_order_relaxed);
+    }
+
+    ~concurrent_histogram()
+    {
+        for (std::size_t s = 0; s < CPORT_METRICS_SHARDS; ++s)
+            delete shards_[s].load(std::memory_order_relaxed);
+    }
+
+    concurrent_histogram(const concurrent_histogram&) = delete;
+
+    concurrent_histogram& operator=(const concurrent_histogram&) = delete;
+
+    void record(std::chrono::nanoseconds latency)
+    {
+        const std::uint64_t v = latency.count() > 0
+            ? static_cast<std::uint64_t>(latency.count()) : 0;
+        const std::size_t s = metrics_shard_registry::thread_shard();
+        shard &sh = get_shard(s);
+        std::atomic<std::uint64_t> &bucket = sh.buckets[histogram_buckets::index(v)];
+
+        if (s != metrics_shard_registry::shared_shard) {
+            bucket.store(bucket.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+            if (v > sh.max.load(std::memory_order_relaxed))
+                sh.max.store(v, std::memory_order_relaxed);
+            if (v < sh.min.load(std::memory_order_relaxed))
+                sh.min.store(v, std::memory_order_relaxed);
+            return;
+        }
+
+        bucket.fetch_add(1, std::memory_order_relaxed);
+        std::uint64_t current = sh.max.load(std::memory_order_relaxed);
+        while (v > current
+            && !sh.max.compare_exchange_weak(current, v, std::memory_order_relaxed))
+            ;
+        current = sh.min.load(std::memory_order_relaxed);
+        while (v < current
+            && !sh.min.compare_exchange_weak(current, v, std::memory_order_relaxed))
+            ;
+    }
+
+    latency_histogram snapshot() const
+    {
+        latency_histogram h;
+        std::uint64_t min = std::numeric_limits<std::uint64_t>::max();
+        std::uint64_t max = 0;
+        for (std::size_t s = 0; s < CPORT_METRICS_SHARDS; ++s) {
+            const shard *sh = shards_[s].load(std::memory_order_acquire);
+            if (sh == nullptr)
+                continue;
+            for (std::size_t i = 0; i < histogram_buckets::count; ++i) {
+                const std::uint64_t n = sh->buckets[i].load(std::memory_order_relaxed);
+                h.buckets_[i] += n;
+                h.count_ += n;
+            }
+            min = std::min(min, sh->min.load(std::memory_order_relaxed));
+            max = std::max(max, sh->max.load(std::memory_order_relaxed));
+        }
+        if (h.count_ != 0) {
+            h.max_ = max;
+            // A concurrent record() may not have updated the limits yet
+            h.min_ = std::min(min, h.max_);
+        }
+        return h;
+    }
+
+private:
+    struct shard {
+        shard()
+            : min(std::numeric_limits<std::uint64_t>::max())
+            , max(0)
+        {
+            for (std::size_t i = 0; i < histogram_buckets::count; ++i)
+                buckets[i].store(0, std::memory_order_relaxed);
+        }
+
+        std::atomic<std::uint64_t> buckets[histogram_buckets::count];
+        std::atomic<std::uint64_t> min;
+        std::atomic<std::uint64_t> max;
+    };
+
+    shard& get_shard(std::size_t s)
+    {
+        shard *sh = shards_[s].load(std::memory_order_acquire);
+        if (sh != nullptr)
+            return *sh;
+
+        // Only the threads sharing the last shard can race to allocate it
+        shard *created = new shard();
+        if (shards_[s].compare_exchange_strong(sh, created,
+                std::memory_order_acq_rel, std::memory_order_acquire))
+            return *created;
+        delete created;
+        return *sh;
+    }
+
+    std::atomic<shard *> shards_[CPORT_METRICS_SHARDS];
+};
+
+} // namespace detail
+
+} // namespace cport
+
+#endif // __CONCURRENT_HISTOGRAM_HPP__
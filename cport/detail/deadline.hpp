@@ -0,0 +1,75 @@
+#ifndef __DEADLINE_HPP__
+#define __DEADLINE_HPP__
+
+//
+// deadline.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace cport {
+
+namespace detail {
+
+// A deadline that never expires.
+struct no_deadline {
+    bool expired() const
+    {
+        return false;
+    }
+
+    // Return false if the deadline expired while waiting.
+    template <typename Condition, typename Lock>
+    bool wait(Condition &cond, Lock &lock) const
+    {
+        cond.wait(lock);
+        return true;
+    }
+};
+
+// A deadline at a time point of an arbitrary clock.
+template <typename Clock, typename Duration>
+class time_point_deadline {
+public:
+    typedef std::chrono::time_point<Clock, Duration> time_point;
+
+    explicit time_point_deadline(const time_point &tp)
+        : tp_(tp)
+    {
+    }
+
+    bool expired() const
+    {
+        return Clock::now() >= tp_;
+    }
+
+    // Return false if the deadline expired while waiting.
+    template <typename Condition, typename Lock>
+    bool wait(Condition &cond, Lock &lock) const
+    {
+        return cond.wait_until(lock, tp_) == std::cv_status::no_timeout;
+    }
+
+private:
+    time_point tp_;
+};
+
+template <typename Clock, typename Duration>
+inline time_point_deadline<Clock, Duration> make_deadline(
+    const std::chrono::time_point<Clock, Duration> &tp)
+{
+    return time_point_deadline<Clock, Duration>(tp);
+}
+
+} // namespace detail
+
+} // namespace cport
+
+#endif // __DEADLINE_HPP__
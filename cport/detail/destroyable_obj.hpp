@@ -10,30 +10,54 @@
 // visit http://www.apache.org/licenses/ for more information.
 //
 
-#include <functional>
-
 namespace cport {
+
+class memory_resource;
+
 namespace detail {
 
+// The base of objects destroyed through a static per-type table of
+//  functions, instead of a virtual destructor.
 class destroyable_obj {
 public:
     void destroy()
     {
-        destroy_helper_(this);
+        vtable_->destroy(this);
+    }
+
+    // The resource the object is allocated from
+    memory_resource* resource() const
+    {
+        return resource_;
+    }
+
+    void set_resource(memory_resource *r)
+    {
+        resource_ = r;
     }
 
 protected:
-    using destroy_helper_type = std::function<void(destroyable_obj*)>;
+    // The first member of the tables of the derived bases
+    struct vtable_type {
+        void (*destroy)(destroyable_obj *);
+    };
 
-    explicit destroyable_obj(destroy_helper_type helper)
-        : destroy_helper_(helper)
+    explicit destroyable_obj(const vtable_type *vtable)
+        : vtable_(vtable)
+        , resource_(nullptr)
     {
     }
 
     ~destroyable_obj() = default;
 
+    const vtable_type* vtable() const
+    {
+        return vtable_;
+    }
+
 private:
-    destroy_helper_type destroy_helper_;
+    const vtable_type *vtable_;
+    memory_resource *resource_;
 };
 
 struct destroyable_deletor
@@ -0,0 +1,65 @@
+#ifndef __FILE_POOL_BACKEND_HPP__
+#define __FILE_POOL_BACKEND_HPP__
+
+//
+// file_pool_backend.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/config.hpp>
+#include <cport/detail/file_service_impl.hpp>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cport {
+
+namespace detail {
+
+// Executes requests with blocking pread() and pwrite() on dedicated threads.
+class file_pool_backend : public file_backend {
+public:
+    CPORT_DECL_TYPE file_pool_backend(completion_port_impl &port,
+        std::size_t threads);
+
+    CPORT_DECL_TYPE ~file_pool_backend();
+
+    CPORT_DECL_TYPE void submit(file_request *const *requests, std::size_t count);
+
+    // Registered buffers are ordinary memory for blocking calls
+    void register_buffers(const file_buffer *, std::size_t)
+    {
+    }
+
+    void unregister_buffers()
+    {
+    }
+
+    CPORT_DECL_TYPE void shutdown();
+
+private:
+    CPORT_DECL_TYPE void thread_routine();
+
+    completion_port_impl &port_;
+    std::mutex guard_;
+    std::condition_variable cond_;
+    std::deque<file_request *> pending_;
+    bool stopped_;
+    std::vector<std::thread> threads_;
+};
+
+} // namespace detail
+
+} // namespace cport
+
+#ifdef CPORT_HEADER_ONLY_LIB
+#include <cport/detail/impl/file_pool_backend.ipp>
+#endif//CPORT_HEADER_ONLY_LIB
+
+#endif // __FILE_POOL_BACKEND_HPP__
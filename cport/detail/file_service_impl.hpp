@@ -0,0 +1,135 @@
+#ifndef __FILE_SERVICE_IMPL_HPP__
+#define __FILE_SERVICE_IMPL_HPP__
+
+//
+// file_service_impl.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/config.hpp>
+#include <cport/error_types.hpp>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace cport {
+
+/// A memory region registered with a file_service.
+struct file_buffer {
+    void *data;
+    std::size_t size;
+};
+
+namespace detail {
+
+class completion_handler_base;
+class completion_port_impl;
+
+// A read or write, stored in the completion handler which reports its result.
+struct file_request {
+    enum opcode { read_op, write_op };
+
+    int op;
+    int fd;
+    void *data;
+    std::size_t size;
+    std::uint64_t offset;
+    // Index of the registered buffer which contains data, -1 if none
+    int buffer_index;
+    // The handler to post when the request completes
+    completion_handler_base *handler;
+    // Set by the backend when the request completes
+    std::size_t transferred;
+};
+
+// Executes requests and posts their handlers to the port.
+class file_backend {
+public:
+    virtual ~file_backend()
+    {
+    }
+
+    // The requests are completed in any order.
+    virtual void submit(file_request *const *requests, std::size_t count) = 0;
+
+    virtual void register_buffers(const file_buffer *buffers, std::size_t count) = 0;
+
+    virtual void unregister_buffers() = 0;
+
+    // Complete all submitted requests and stop the backend.
+    virtual void shutdown() = 0;
+};
+
+// Invokes a handler with the result of the request it holds.
+template <typename Handler>
+class file_op_handler {
+public:
+    explicit file_op_handler(Handler&& h);
+
+    explicit file_op_handler(const Handler& h);
+
+    void operator()(const generic_error &e);
+
+    file_request& request();
+
+private:
+    Handler handler_;
+    file_request request_;
+};
+
+class file_service_impl {
+public:
+    enum backend_type { automatic, uring, thread_pool };
+
+    CPORT_DECL_TYPE file_service_impl(completion_port_impl &port,
+        std::size_t queue_depth, backend_type backend);
+
+    CPORT_DECL_TYPE ~file_service_impl();
+
+    file_service_impl(const file_service_impl&) = delete;
+
+    file_service_impl& operator=(const file_service_impl&) = delete;
+
+    backend_type backend() const;
+
+    // Return nullptr if the port is stopped.
+    template <typename Handler>
+    file_request* create(int op, int fd, void *data, std::size_t size,
+        std::uint64_t offset, int buffer_index, Handler&& h);
+
+    // A request outside of its registered buffer completes with EINVAL.
+    CPORT_DECL_TYPE void submit(file_request *const *requests, std::size_t count);
+
+    CPORT_DECL_TYPE void register_buffers(const file_buffer *buffers,
+        std::size_t count);
+
+    CPORT_DECL_TYPE void unregister_buffers();
+
+    // Set the result of a request from a read() or write() like return value.
+    CPORT_DECL_TYPE static void complete(file_request &r, long result);
+
+private:
+    CPORT_DECL_TYPE bool valid_buffer(const file_request &r) const;
+
+    completion_port_impl &port_;
+    backend_type backend_type_;
+    std::unique_ptr<file_backend> backend_;
+    mutable std::mutex buffers_guard_;
+    std::vector<file_buffer> buffers_;
+};
+
+} // namespace detail
+
+} // namespace cport
+
+#include <cport/detail/impl/file_service_impl.inl>
+#ifdef CPORT_HEADER_ONLY_LIB
+#include <cport/detail/impl/file_service_impl.ipp>
+#endif//CPORT_HEADER_ONLY_LIB
+
+#endif // __FILE_SERVICE_IMPL_HPP__
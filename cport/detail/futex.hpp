@@ -0,0 +1,84 @@
+#ifndef __FUTEX_HPP__
+#define __FUTEX_HPP__
+
+//
+// futex.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/config.hpp>
+#include <atomic>
+#include <cstdint>
+#ifdef CPORT_HAS_FUTEX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#endif // CPORT_HAS_FUTEX
+
+namespace cport {
+
+namespace detail {
+
+#ifdef CPORT_HAS_FUTEX
+
+// Block while the word holds the expected value. May return spuriously.
+inline void futex_wait(std::atomic<std::uint32_t> &word, std::uint32_t expected)
+{
+    ::syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word),
+        FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+}
+
+// Wake all threads blocked on the word.
+inline void futex_wake_all(std::atomic<std::uint32_t> &word)
+{
+    ::syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word),
+        FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr, nullptr, 0);
+}
+
+#else // CPORT_HAS_FUTEX
+
+// Without futexes the words are hashed to a fixed table of condition
+//  variables, shared by all words.
+struct futex_bucket {
+    std::mutex mutex;
+    std::condition_variable cond;
+};
+
+inline futex_bucket& get_futex_bucket(const void *addr)
+{
+    enum { buckets = 64 };
+    static futex_bucket table[buckets];
+    const std::size_t h = reinterpret_cast<std::size_t>(addr) / sizeof(std::uint32_t);
+    return table[h % buckets];
+}
+
+inline void futex_wait(std::atomic<std::uint32_t> &word, std::uint32_t expected)
+{
+    futex_bucket &b = get_futex_bucket(&word);
+    std::unique_lock<std::mutex> lock(b.mutex);
+    if (word.load() == expected)
+        b.cond.wait(lock);
+}
+
+inline void futex_wake_all(std::atomic<std::uint32_t> &word)
+{
+    futex_bucket &b = get_futex_bucket(&word);
+    std::lock_guard<std::mutex> lock(b.mutex);
+    b.cond.notify_all();
+}
+
+#endif // CPORT_HAS_FUTEX
+
+} // namespace detail
+
+} // namespace cport
+
+#endif // __FUTEX_HPP__
@@ -0,0 +1,89 @@
+#ifndef __HISTOGRAM_BUCKETS_HPP__
+#define __HISTOGRAM_BUCKETS_HPP__
+
+//
+// histogram_buckets.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cport {
+
+namespace detail {
+
+// The bucket layout of the latency histograms, as in HdrHistogram.
+//
+// Values below 2^exact_bits have a bucket each. Each higher power of two
+//  range is split in 2^sub_bits linear buckets, so a recorded value is
+//  within 1/2^sub_bits (3.1%) of the value of its bucket. Values are
+//  clamped to 2^max_bits - 1 (about 18 minutes in nanoseconds).
+struct histogram_buckets {
+    enum {
+        exact_bits = 6,
+        sub_bits = exact_bits - 1,
+        max_bits = 40,
+        sub_count = 1 << sub_bits,
+        count = (1 << exact_bits) + (max_bits - exact_bits) * sub_count
+    };
+
+    static std::uint64_t max_value()
+    {
+        return (std::uint64_t(1) << max_bits) - 1;
+    }
+
+    static std::size_t index(std::uint64_t v)
+    {
+        if (v < (std::uint64_t(1) << exact_bits))
+            return static_cast<std::size_t>(v);
+        if (v > max_value())
+            v = max_value();
+
+        const unsigned msb = most_significant_bit(v);
+        // The bits below the leading one select the linear bucket
+        const std::size_t sub = static_cast<std::size_t>(v >> (msb - sub_bits)) - sub_count;
+        return (1 << exact_bits) + (msb - exact_bits) * sub_count + sub;
+    }
+
+    // The highest value which falls in the bucket
+    static std::uint64_t upper_value(std::size_t i)
+    {
+        if (i < (std::size_t(1) << exact_bits))
+            return i;
+        const std::size_t k = i - (1 << exact_bits);
+        const unsigned msb = static_cast<unsigned>(k / sub_count) + exact_bits;
+        const std::uint64_t sub = k % sub_count + sub_count;
+        return ((sub + 1) << (msb - sub_bits)) - 1;
+    }
+
+    // The lowest value which falls in the bucket
+    static std::uint64_t lower_value(std::size_t i)
+    {
+        if (i < (std::size_t(1) << exact_bits))
+            return i;
+        return upper_value(i - 1) + 1;
+    }
+
+    static unsigned most_significant_bit(std::uint64_t v)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return 63 - static_cast<unsigned>(__builtin_clzll(v));
+#else
+        unsigned msb = 0;
+        while (v >>= 1)
+            ++msb;
+        return msb;
+#endif
+    }
+};
+
+} // namespace detail
+
+} // namespace cport
+
+#endif // __HISTOGRAM_BUCKETS_HPP__
@@ -17,61 +17,272 @@ namespace cport {
 
 namespace detail {
 
+class scope_ref_counter
+{
+public:
+    explicit scope_ref_counter(std::atomic<std::size_t>& counter)
+        : counter_(counter)
+    {
+        ++counter_;
+    }
+
+    ~scope_ref_counter()
+    {
+        --counter_;
+    }
+private:
+    std::atomic<std::size_t>& counter_;
+};
+
 template <typename Handler>
-inline void completion_port_impl::post(Handler&& h, std::size_t seqno, const generic_error& e)
+inline void completion_port_impl::post(Handler&& h, std::size_t seqno,
+    const error_code& e, std::size_t priority)
 {
-    post(create_completion_handler(std::forward<Handler>(h), seqno, e));
+    post(create_completion_handler(resource_, std::forward<Handler>(h), seqno, e),
+        priority);
 }
 
 template <typename Handler>
-inline void completion_port_impl::dispatch(Handler&& h, const generic_error& e)
+inline void completion_port_impl::dispatch(Handler&& h, const error_code& e)
 {
     post(std::forward<Handler>(h), 0, e);
 }
 
+template <typename Handler>
+inline timer_handle completion_port_impl::post_at(Handler&& h,
+    const std::chrono::steady_clock::time_point &tp)
+{
+    const std::size_t seqno = next_operation_id();
+    if (seqno == 0)
+        return timer_handle();
+
+    return schedule_timer(create_completion_handler(resource_, std::forward<Handler>(h),
+        seqno, error_code()), tp);
+}
+
 template <typename Handler>
 inline void completion_port_impl::call(Handler&& h, const generic_error& e)
 {
     h(e);
 }
 
+inline void completion_port_impl::post(completion_handler_base *h,
+    std::size_t priority)
+{
+    post(&h, 1, priority);
+}
+
+template <typename Clock, typename Duration>
+inline bool completion_port_impl::wait_one_until(
+    const std::chrono::time_point<Clock, Duration> &tp)
+{
+    return do_wait_one(make_deadline(tp));
+}
+
+template <typename Clock, typename Duration>
+inline bool completion_port_impl::run_one_until(
+    const std::chrono::time_point<Clock, Duration> &tp)
+{
+    return do_run(1, make_deadline(tp)) != 0;
+}
+
 inline bool completion_port_impl::pull_one()
 {
-    std::unique_lock<std::mutex> lock(guard_);
-    return do_one(lock);
+    return do_one();
+}
+
+inline std::size_t completion_port_impl::pull_n(std::size_t max)
+{
+    return do_batch(max);
 }
 
 inline void completion_port_impl::reset()
 {
-    std::unique_lock<std::mutex> lock(guard_);
+    std::unique_lock<mutex_type> lock(guard_);
     stopped_ = false;
 }
 
 inline void completion_port_impl::stop()
 {
-    std::unique_lock<std::mutex> lock(guard_);
+    std::unique_lock<mutex_type> lock(guard_);
     stopped_ = true;
     cond_.notify_all();
 }
 
 inline bool completion_port_impl::stopped() const
 {
-    std::unique_lock<std::mutex> lock(guard_);
     return stopped_;
 }
 
 inline std::size_t completion_port_impl::ready_handlers() const
 {
-    std::unique_lock<std::mutex> lock(guard_);
-    return handlers_.size();
+    std::size_t count = 0;
+    for (std::size_t s = 0; s < shards_; ++s)
+        count += shard_state_[s].ready.load();
+    return count;
+}
+
+inline std::size_t completion_port_impl::ready_handlers(std::size_t priority) const
+{
+    if (priority >= levels_)
+        return 0;
+
+    std::size_t count = 0;
+    for (std::size_t s = 0; s < shards_; ++s)
+        count += lane_at(s, priority + 1).depth.load();
+    return count;
 }
 
 inline std::size_t completion_port_impl::blocked_threads() const
 {
-    std::unique_lock<std::mutex> lock(guard_);
     return wait_one_threads_ + run_one_threads_;
 }
 
+inline void completion_port_impl::set_wait_policy(const wait_policy &wp)
+{
+    waiter_.set_policy(wp);
+}
+
+inline wait_policy completion_port_impl::get_wait_policy() const
+{
+    return waiter_.get_policy();
+}
+
+inline wait_stats completion_port_impl::get_wait_stats() const
+{
+    return waiter_.get_stats();
+}
+
+inline std::size_t completion_port_impl::post_seqno() const
+{
+    return stopped_ ? 0 : direct_seqno();
+}
+
+inline completion_port_impl::lane& completion_port_impl::lane_at(std::size_t shard,
+    std::size_t index) const
+{
+    return lanes_[shard * (levels_ + 1) + index];
+}
+
+inline std::size_t completion_port_impl::shards() const
+{
+    return shards_;
+}
+
+inline std::size_t completion_port_impl::priority_levels() const
+{
+    return levels_;
+}
+
+inline memory_resource& completion_port_impl::resource() const
+{
+    return resource_;
+}
+
+inline concurrent_histogram& completion_port_impl::task_completion_latency()
+{
+    return task_completion_latency_;
+}
+
+inline void completion_port_impl::set_priority_aging(std::size_t limit)
+{
+    aging_ = limit;
+}
+
+inline std::size_t completion_port_impl::get_priority_aging() const
+{
+    return aging_;
+}
+
+template <typename Deadline>
+inline bool completion_port_impl::do_wait_one(const Deadline &deadline)
+{
+    // The deadline is checked before each claim, so that continuously
+    //  ready handlers do not keep the caller past it
+    while (!deadline.expired()) {
+        if (do_one())
+            return true;
+
+        // post() raises the ready count before it lowers queued_ops_, so the
+        //  ready count is read last: a handler made ready by the post which
+        //  completed the last operation is seen here
+        const auto idle = [&]() {
+            return (stopped_ || queued_ops_ == 0 || deadline.expired())
+                && !has_ready();
+        };
+
+        if (!waiter_.spin([&]() { return has_ready() || idle(); })) {
+            std::unique_lock<mutex_type> lock(guard_);
+            // The counter is raised before the state is checked, so that post()
+            //  either sees a blocked thread or this thread sees the new handler.
+            scope_ref_counter c(wait_one_threads_);
+            if (!stopped_ && queued_ops_ > 0 && !has_ready()) {
+                waiter_.parked();
+                do {
+                    if (!deadline.wait(cond_, lock))
+                        break;
+                } while (!stopped_ && queued_ops_ > 0 && !has_ready());
+            }
+        }
+
+        if (idle())
+            return false;
+    }
+    return false;
+}
+
+template <typename Deadline>
+inline std::size_t completion_port_impl::do_run(std::size_t max,
+    const Deadline &deadline)
+{
+    std::size_t count = 0;
+    // As in do_wait_one(), the deadline is checked before each claim
+    while (!deadline.expired() && (count = do_batch(max)) == 0) {
+        const auto idle = [&]() {
+            return !has_ready() && (stopped_ || deadline.expired());
+        };
+
+        if (!waiter_.spin([&]() { return has_ready() || idle(); })) {
+            std::unique_lock<mutex_type> lock(guard_);
+            scope_ref_counter c(run_one_threads_);
+            if (!stopped_ && !has_ready()) {
+                waiter_.parked();
+                do {
+                    if (!deadline.wait(cond_, lock))
+                        break;
+                } while (!stopped_ && !has_ready());
+            }
+        }
+
+        if (idle())
+            break;
+    }
+    return count;
+}
+
+inline bool completion_port_impl::do_one()
+{
+    return do_batch(1) != 0;
+}
+
+inline void completion_port_impl::ready_added(std::size_t prev)
+{
+#ifdef CPORT_HAS_EVENTFD
+    if (prev == 0 && event_fd_.load() >= 0)
+        signal_event();
+#else
+    (void)prev;
+#endif // CPORT_HAS_EVENTFD
+}
+
+inline void completion_port_impl::ready_drained()
+{
+#ifdef CPORT_HAS_EVENTFD
+    if (event_fd_.load() >= 0 && !has_ready())
+        drain_event();
+#endif // CPORT_HAS_EVENTFD
+}
+
 } // namespace detail
 
 } // namespace cport
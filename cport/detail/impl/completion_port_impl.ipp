@@ -11,137 +11,398 @@
 //
 
 #include <cport/detail/completion_port_impl.hpp>
+#include <cport/detail/timer_service_impl.hpp>
+#include <algorithm>
 #include <cassert>
-#include <limits>
+#include <system_error>
+#include <thread>
+#ifdef CPORT_HAS_EVENTFD
+#include <cerrno>
+#include <cstdint>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif // CPORT_HAS_EVENTFD
 
 namespace cport {
 
 namespace detail {
 
-class scope_ref_counter
-{
-public:
-    explicit scope_ref_counter(std::size_t& counter)
-        : counter_(counter)
-    {
-        ++counter_;
-    }
-
-    ~scope_ref_counter()
-    {
-        --counter_;
-    }
-private:
-    std::size_t& counter_;
-};
-
-completion_port_impl::completion_port_impl() 
-: stopped_(false)
+completion_port_impl::completion_port_impl(std::size_t shards,
+    std::size_t priority_levels, memory_resource *r)
+: resource_(r != nullptr ? *r : *get_default_resource())
+, stopped_(false)
 , run_one_threads_(0)
 , wait_one_threads_(0)
 , queued_ops_(0)
 , seqno_(0)
+, shards_(shards != 0 ? shards
+    : std::max<std::size_t>(std::thread::hardware_concurrency(), 1))
+, shard_state_(new shard_state[shards_])
+, levels_(std::max<std::size_t>(priority_levels, 1))
+, level_state_(new level_state[levels_])
+, aging_(0)
+, ready_high_water_(0)
+#ifdef CPORT_HAS_EVENTFD
+, event_fd_(-1)
+#endif // CPORT_HAS_EVENTFD
 {
+    for (std::size_t s = 0; s < shards_; ++s)
+        shard_state_[s].ready = 0;
+
+    lanes_.reset(new lane[shards_ * (levels_ + 1)]);
+    for (std::size_t i = 0; i < shards_ * (levels_ + 1); ++i) {
+        lanes_[i].queue = nullptr;
+        lanes_[i].depth = 0;
+    }
+    // All threads run on the only shard
+    if (shards_ == 1) {
+        for (std::size_t i = 0; i < levels_ + 1; ++i)
+            lane_queue(lanes_[i]);
+    }
+
+    for (std::size_t l = 0; l < levels_; ++l)
+        level_state_[l].skipped = 0;
 }
 
 completion_port_impl::~completion_port_impl()
 {
+    // Pending timers are posted with operation_aborted error
+    timers_.reset();
+
     assert(queued_ops_ == 0);
 
-    while (!handlers_.empty()) {
-        auto_destroy h(handlers_.top());
-        handlers_.pop();
+    std::size_t shard = 0;
+    while (claim_ready(1, shard) != 0) {
+        auto_destroy h(pop_claimed(shard));
         h->complete();
     }
+
+    for (std::size_t i = 0; i < shards_ * (levels_ + 1); ++i)
+        delete lanes_[i].queue.load();
+
+#ifdef CPORT_HAS_EVENTFD
+    if (event_fd_ >= 0)
+        ::close(event_fd_);
+#endif // CPORT_HAS_EVENTFD
 }
 
 bool completion_port_impl::wait_one()
 {
-    std::unique_lock<std::mutex> lock(guard_);
-    while (!stopped_ && handlers_.empty() && queued_ops_> 0) {
-        scope_ref_counter c(wait_one_threads_);
-        cond_.wait(lock);
-    }
-    return do_one(lock);
+    return do_wait_one(no_deadline());
 }
 
 bool completion_port_impl::run_one()
 {
-    std::unique_lock<std::mutex> lock(guard_);
-    while (!stopped_ && handlers_.empty()) {
-        scope_ref_counter c(run_one_threads_);
-        cond_.wait(lock);
-    }
-    return do_one(lock);
+    return do_run(1, no_deadline()) != 0;
+}
+
+std::size_t completion_port_impl::run_batch(std::size_t max)
+{
+    return do_run(max, no_deadline());
+}
+
+bool completion_port_impl::cancel(const timer_handle &t)
+{
+    // No timer was scheduled on this port if the service was not started
+    return t && timers_ && timers_->cancel(t);
+}
+
+timer_handle completion_port_impl::schedule_timer(completion_handler_base *h,
+    const std::chrono::steady_clock::time_point &tp)
+{
+    std::call_once(timers_once_, [this]() {
+        timers_.reset(new timer_service_impl(*this));
+    });
+    return timers_->schedule(h, tp);
 }
 
 std::size_t completion_port_impl::next_operation_id()
 {
-    std::unique_lock<std::mutex> lock(guard_);
     if (stopped_)
         return 0;
 
     ++queued_ops_;
-    if (seqno_ == std::numeric_limits<std::size_t>::max())
-        seqno_ = 0;
 
-    return ++seqno_;
+    // Zero is reserved for dispatched handlers, and the largest number
+    //  for the direct posts
+    std::size_t seqno = ++seqno_;
+    while (seqno == 0 || seqno == direct_seqno())
+        seqno = ++seqno_;
+    return seqno;
 }
 
-void completion_port_impl::post(completion_handler_base *h)
+void completion_port_impl::post(completion_handler_base *const *handlers,
+    std::size_t count, std::size_t priority)
 {
-    std::unique_lock<std::mutex> lock(guard_);
-    handlers_.push(h);
+    if (count == 0)
+        return;
+
+    // The operations of the direct posts were never queued
+    std::size_t posted = 0;
+    std::size_t completed_ops = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::size_t seqno = handlers[i]->seqno();
+        posted += seqno != 0 ? 1 : 0;
+        completed_ops += seqno != 0 && seqno != direct_seqno() ? 1 : 0;
+    }
+
+    // The depths are raised first, so they never drop below zero when a
+    //  runner pops the handlers before this thread raises the ready count.
+    const std::size_t shard = local_shard();
+    priority = std::min(priority, levels_ - 1);
+    lane &dispatched = lane_at(shard, 0);
+    lane &level = lane_at(shard, priority + 1);
+    if (posted != count)
+        dispatched.depth += count - posted;
+    if (posted != 0)
+        level.depth += posted;
+
+    for (std::size_t i = 0; i < count; ++i) {
+        completion_handler_base *h = handlers[i];
+        lane_queue(h->seqno() == 0 ? dispatched : level).push(h);
+    }
 
-    assert(h->seqno() == 0 || queued_ops_ > 0);
-    if (h->seqno() > 0)
-        --queued_ops_;
+    const std::size_t prev = shard_state_[shard].ready.fetch_add(count);
+    ready_added(prev);
 
-    if (queued_ops_ == 0 && wait_one_threads_ > 0)
+#ifdef CPORT_HAS_METRICS
+    if (posted != 0)
+        metrics_.add(metric_posted, posted);
+    if (posted != count)
+        metrics_.add(metric_dispatched, count - posted);
+    update_high_water(ready_high_water_, prev + count);
+#endif // CPORT_HAS_METRICS
+
+    assert(queued_ops_ >= completed_ops);
+    std::size_t ops = completed_ops != 0 ? queued_ops_ -= completed_ops : 0;
+
+    const std::size_t blocked = run_one_threads_ + wait_one_threads_;
+    if (blocked == 0)
+        return;
+    if (completed_ops == 0)
+        ops = queued_ops_;
+
+    // Wake one blocked thread per new handler, or all of them if the
+    //  last outstanding operation completed and wait_one() is blocked.
+    std::unique_lock<mutex_type> lock(guard_);
+    if ((ops == 0 && wait_one_threads_ > 0) || count >= blocked) {
         cond_.notify_all();
-    else
-        cond_.notify_one();
+    }
+    else {
+        for (std::size_t i = 0; i < count; ++i)
+            cond_.notify_one();
+    }
 }
 
-bool completion_port_impl::do_one(std::unique_lock<std::mutex> &lock)
+completion_port_impl::handler_queue& completion_port_impl::lane_queue(lane &l)
 {
-    assert(lock.owns_lock());
-    if (handlers_.empty())
-        return false;
+    handler_queue *q = l.queue.load(std::memory_order_acquire);
+    if (q != nullptr)
+        return *q;
 
-    auto_destroy h(handlers_.top());
-    handlers_.pop();
-    lock.unlock();
-    h->complete();
-    return true;
+    // The dispatched handlers are rare, and the rings of a sharded port
+    //  are kept small, as each one serves only the threads of its shard.
+    //  A burst which does not fit spills to the overflow list.
+    const bool dispatched = (&l - lanes_.get()) % (levels_ + 1) == 0;
+    const std::size_t capacity = dispatched || shards_ != 1 ? 1024 : 8192;
+    std::unique_ptr<handler_queue> created(new handler_queue(capacity, resource_));
+    if (l.queue.compare_exchange_strong(q, created.get(), std::memory_order_acq_rel,
+            std::memory_order_acquire))
+        return *created.release();
+    return *q;
 }
 
-completion_port_impl::priority_less_pred::priority_less_pred()
-    : gap(std::numeric_limits<std::size_t>::max() / 2)
+bool completion_port_impl::has_ready() const
 {
+    for (std::size_t s = 0; s < shards_; ++s) {
+        if (shard_state_[s].ready.load() != 0)
+            return true;
+    }
+    return false;
 }
 
-std::size_t completion_port_impl::priority_less_pred::diff(
-    std::size_t s1,
-    std::size_t s2)
+std::size_t completion_port_impl::claim_ready(std::size_t max, std::size_t &shard)
 {
-    return s1 > s2 ? s1 - s2 : s2 - s1;
+    if (max == 0)
+        return 0;
+
+    // The counters of the other shards are only read until one has handlers
+    const std::size_t local = local_shard();
+    for (std::size_t i = 0; i < shards_; ++i) {
+        const std::size_t s = (local + i) % shards_;
+        std::atomic<std::size_t> &ready = shard_state_[s].ready;
+        std::size_t current = ready.load();
+        std::size_t count = 0;
+        do {
+            if (current == 0)
+                break;
+            count = std::min(current, max);
+        } while (!ready.compare_exchange_weak(current, current - count));
+
+        if (current == 0)
+            continue;
+        if (current == count)
+            ready_drained();
+        shard = s;
+        return count;
+    }
+    return 0;
+}
+
+completion_handler_base* completion_port_impl::pop_claimed(std::size_t shard)
+{
+    // A handler claimed from a shard is already pushed to one of its
+    //  lanes, but it may be behind a slot which a concurrent producer has
+    //  reserved and not yet filled.
+    for (;;) {
+        if (completion_handler_base *h = pop_lane(shard, 0))
+            return h;
+
+        // A lower level skipped too many times runs before the higher ones
+        const std::size_t aging = aging_.load(std::memory_order_relaxed);
+        if (aging != 0) {
+            for (std::size_t l = levels_ - 1; l > 0; --l) {
+                level_state &ls = level_state_[l];
+                if (ls.skipped.load(std::memory_order_relaxed) < aging)
+                    continue;
+                if (completion_handler_base *h = pop_lane(shard, l + 1)) {
+                    ls.skipped.store(0, std::memory_order_relaxed);
+                    return h;
+                }
+            }
+        }
+
+        for (std::size_t l = 0; l < levels_; ++l) {
+            completion_handler_base *h = pop_lane(shard, l + 1);
+            if (h == nullptr)
+                continue;
+
+            if (aging != 0) {
+                level_state_[l].skipped.store(0, std::memory_order_relaxed);
+                for (std::size_t m = l + 1; m < levels_; ++m) {
+                    if (lane_at(shard, m + 1).depth != 0)
+                        level_state_[m].skipped.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            return h;
+        }
+        std::this_thread::yield();
+    }
+}
+
+completion_handler_base* completion_port_impl::pop_lane(std::size_t shard,
+    std::size_t index)
+{
+    lane &l = lane_at(shard, index);
+    if (l.depth.load(std::memory_order_relaxed) == 0)
+        return nullptr;
+
+    handler_queue *q = l.queue.load(std::memory_order_acquire);
+    completion_handler_base *h = q != nullptr ? q->pop() : nullptr;
+    if (h != nullptr)
+        --l.depth;
+    return h;
+}
+
+std::size_t completion_port_impl::local_shard() const
+{
+    if (shards_ == 1)
+        return 0;
+
+    // Threads are numbered in order of first use and spread evenly
+    //  over the shards.
+    static std::atomic<std::size_t> next_thread_index(0);
+    static thread_local const std::size_t thread_index = next_thread_index++;
+    return thread_index % shards_;
+}
+
+void completion_port_impl::release_claimed(std::size_t shard, std::size_t count)
+{
+    ready_added(shard_state_[shard].ready.fetch_add(count));
+    if (run_one_threads_ + wait_one_threads_ > 0) {
+        std::unique_lock<mutex_type> lock(guard_);
+        cond_.notify_all();
+    }
+}
+
+std::size_t completion_port_impl::do_batch(std::size_t max)
+{
+    // All handlers are claimed at once, but each one is popped right
+    //  before it is invoked, so a handler dispatched meanwhile still runs
+    //  first. If a handler throws, the claims left are given back.
+    struct batch_guard {
+        completion_port_impl &port;
+        std::size_t shard;
+        std::size_t count;
+        std::size_t left;
+        ~batch_guard()
+        {
+#ifdef CPORT_HAS_METRICS
+            if (count != left)
+                port.metrics_.add(metric_completed, count - left);
+#endif // CPORT_HAS_METRICS
+            if (left > 0)
+                port.release_claimed(shard, left);
+        }
+    };
+
+    std::size_t shard = 0;
+    const std::size_t count = claim_ready(max, shard);
+    batch_guard guard = { *this, shard, count, count };
+    while (guard.left > 0) {
+        --guard.left;
+        auto_destroy h(pop_claimed(shard));
+        h->complete();
+    }
+    return count;
 }
 
-bool completion_port_impl::priority_less_pred::operator()(
-    const completion_handler_base *h1,
-    const completion_handler_base *h2)
+port_metrics completion_port_impl::snapshot() const
 {
-    if (h1->seqno() == 0)
-        return false;
+    port_metrics m;
+    m.posted = metrics_.sum(metric_posted);
+    m.dispatched = metrics_.sum(metric_dispatched);
+    m.completed = metrics_.sum(metric_completed);
+    m.ready = ready_handlers();
+    m.ready_high_water = ready_high_water_.load(std::memory_order_relaxed);
+    return m;
+}
+
+#ifdef CPORT_HAS_EVENTFD
+int completion_port_impl::native_handle()
+{
+    std::call_once(event_once_, [this]() {
+        const int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (fd < 0)
+            throw std::system_error(errno, std::system_category(), "eventfd");
+        event_fd_ = fd;
+        // Handlers posted before the descriptor was published
+        if (has_ready())
+            signal_event();
+    });
+    return event_fd_;
+}
 
-    if (h2->seqno() == 0)
-        return true;
+void completion_port_impl::signal_event()
+{
+    const std::uint64_t value = 1;
+    // Fails only if the counter would overflow, it is readable then anyway
+    while (::write(event_fd_, &value, sizeof(value)) < 0 && errno == EINTR)
+        ;
+}
+
+void completion_port_impl::drain_event()
+{
+    std::uint64_t value = 0;
+    while (::read(event_fd_, &value, sizeof(value)) < 0 && errno == EINTR)
+        ;
 
-    if (diff(h1->seqno(), h2->seqno()) > gap)
-        return h1->seqno() < h2->seqno();
-    return h1->seqno() > h2->seqno();
+    // A handler may have been posted after the counter was claimed down
+    //  to zero and signalled before the read above.
+    if (has_ready())
+        signal_event();
 }
+#endif // CPORT_HAS_EVENTFD
 
 } // namespace detail
 
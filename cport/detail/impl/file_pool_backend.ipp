@@ -0,0 +1,95 @@
+#ifndef __FILE_POOL_BACKEND_IPP__
+#define __FILE_POOL_BACKEND_IPP__
+
+//
+// file_pool_backend.ipp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/detail/file_pool_backend.hpp>
+#include <cport/detail/completion_port_impl.hpp>
+#include <cerrno>
+#include <unistd.h>
+
+namespace cport {
+
+namespace detail {
+
+file_pool_backend::file_pool_backend(completion_port_impl &port,
+    std::size_t threads)
+    : port_(port)
+    , stopped_(false)
+{
+    threads_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i)
+        threads_.emplace_back(&file_pool_backend::thread_routine, this);
+}
+
+file_pool_backend::~file_pool_backend()
+{
+    shutdown();
+}
+
+void file_pool_backend::submit(file_request *const *requests, std::size_t count)
+{
+    std::unique_lock<std::mutex> lock(guard_);
+    pending_.insert(pending_.end(), requests, requests + count);
+    if (count >= threads_.size())
+        cond_.notify_all();
+    else
+        for (std::size_t i = 0; i < count; ++i)
+            cond_.notify_one();
+}
+
+void file_pool_backend::shutdown()
+{
+    {
+        std::unique_lock<std::mutex> lock(guard_);
+        if (stopped_)
+            return;
+        stopped_ = true;
+        cond_.notify_all();
+    }
+    for (std::thread &t : threads_)
+        t.join();
+}
+
+void file_pool_backend::thread_routine()
+{
+    std::unique_lock<std::mutex> lock(guard_);
+    for (;;) {
+        // The pending requests are completed before the threads stop
+        while (!stopped_ && pending_.empty())
+            cond_.wait(lock);
+        if (pending_.empty())
+            break;
+
+        file_request *r = pending_.front();
+        pending_.pop_front();
+        lock.unlock();
+
+        ssize_t result = 0;
+        do {
+            const off_t offset = static_cast<off_t>(r->offset);
+            result = r->op == file_request::read_op
+                ? ::pread(r->fd, r->data, r->size, offset)
+                : ::pwrite(r->fd, r->data, r->size, offset);
+        } while (result < 0 && errno == EINTR);
+
+        file_service_impl::complete(*r, result < 0 ? -errno : result);
+        completion_handler_base *h = r->handler;
+        port_.post(&h, 1);
+
+        lock.lock();
+    }
+}
+
+} // namespace detail
+
+} // namespace cport
+
+#endif // __FILE_POOL_BACKEND_IPP__
@@ -0,0 +1,82 @@
+#ifndef __FILE_SERVICE_IMPL_INL__
+#define __FILE_SERVICE_IMPL_INL__
+
+//
+// file_service_impl.inl
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/detail/completion_handler.hpp>
+#include <cport/detail/completion_port_impl.hpp>
+#include <type_traits>
+
+namespace cport {
+
+namespace detail {
+
+template <typename Handler>
+inline file_op_handler<Handler>::file_op_handler(Handler&& h)
+    : handler_(std::move(h))
+    , request_()
+{
+}
+
+template <typename Handler>
+inline file_op_handler<Handler>::file_op_handler(const Handler& h)
+    : handler_(h)
+    , request_()
+{
+}
+
+template <typename Handler>
+inline void file_op_handler<Handler>::operator()(const generic_error &e)
+{
+    handler_(e, request_.transferred);
+}
+
+template <typename Handler>
+inline file_request& file_op_handler<Handler>::request()
+{
+    return request_;
+}
+
+inline file_service_impl::backend_type file_service_impl::backend() const
+{
+    return backend_type_;
+}
+
+template <typename Handler>
+inline file_request* file_service_impl::create(int op, int fd, void *data,
+    std::size_t size, std::uint64_t offset, int buffer_index, Handler&& h)
+{
+    typedef file_op_handler<typename std::decay<Handler>::type> op_handler;
+
+    const std::size_t seqno = port_.next_operation_id();
+    if (seqno == 0)
+        return nullptr;
+
+    // The request lives in the handler until the handler is invoked
+    completion_handler<op_handler> *ch = create_completion_handler(
+        port_.resource(), op_handler(std::forward<Handler>(h)), seqno,
+        error_code());
+    file_request &r = ch->handler().request();
+    r.op = op;
+    r.fd = fd;
+    r.data = data;
+    r.size = size;
+    r.offset = offset;
+    r.buffer_index = buffer_index;
+    r.handler = ch;
+    r.transferred = 0;
+    return &r;
+}
+
+} // namespace detail
+
+} // namespace cport
+
+#endif // __FILE_SERVICE_IMPL_INL__
@@ -0,0 +1,143 @@
+#ifndef __FILE_SERVICE_IMPL_IPP__
+#define __FILE_SERVICE_IMPL_IPP__
+
+//
+// file_service_impl.ipp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/detail/file_service_impl.hpp>
+#include <cport/detail/completion_port_impl.hpp>
+#include <cport/detail/file_pool_backend.hpp>
+#ifdef CPORT_HAS_IO_URING
+#include <cport/detail/io_uring_backend.hpp>
+#endif // CPORT_HAS_IO_URING
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <system_error>
+#include <thread>
+
+namespace cport {
+
+namespace detail {
+
+file_service_impl::file_service_impl(completion_port_impl &port,
+    std::size_t queue_depth, backend_type backend)
+    : port_(port)
+    , backend_type_(thread_pool)
+{
+    queue_depth = std::max<std::size_t>(queue_depth, 1);
+
+#ifdef CPORT_HAS_IO_URING
+    if (backend != thread_pool) {
+        try {
+            backend_.reset(new io_uring_backend(port,
+                static_cast<unsigned>(std::min<std::size_t>(queue_depth, 4096))));
+            backend_type_ = uring;
+        }
+        catch (const std::system_error&) {
+            // Not supported by the kernel or not permitted
+            if (backend == uring)
+                throw;
+        }
+    }
+#else
+    if (backend == uring)
+        throw std::system_error(std::make_error_code(
+            std::errc::function_not_supported), "io_uring");
+#endif // CPORT_HAS_IO_URING
+
+    if (!backend_) {
+        // Blocking calls are bound by the device, not by the cores
+        const std::size_t threads = std::max<std::size_t>(
+            std::thread::hardware_concurrency(), 4);
+        backend_.reset(new file_pool_backend(port,
+            std::min(queue_depth, threads)));
+    }
+}
+
+file_service_impl::~file_service_impl()
+{
+    backend_->shutdown();
+}
+
+void file_service_impl::submit(file_request *const *requests, std::size_t count)
+{
+    bool fixed = false;
+    for (std::size_t i = 0; i < count && !fixed; ++i)
+        fixed = requests[i]->buffer_index >= 0;
+
+    if (!fixed) {
+        backend_->submit(requests, count);
+        return;
+    }
+
+    std::vector<file_request *> accepted;
+    std::vector<completion_handler_base *> rejected;
+    accepted.reserve(count);
+    {
+        std::unique_lock<std::mutex> lock(buffers_guard_);
+        for (std::size_t i = 0; i < count; ++i) {
+            file_request *r = requests[i];
+            if (r->buffer_index < 0 || valid_buffer(*r)) {
+                accepted.push_back(r);
+            }
+            else {
+                complete(*r, -EINVAL);
+                rejected.push_back(r->handler);
+            }
+        }
+    }
+    backend_->submit(accepted.data(), accepted.size());
+    port_.post(rejected.data(), rejected.size());
+}
+
+void file_service_impl::register_buffers(const file_buffer *buffers,
+    std::size_t count)
+{
+    std::unique_lock<std::mutex> lock(buffers_guard_);
+    buffers_.clear();
+    backend_->register_buffers(buffers, count);
+    buffers_.assign(buffers, buffers + count);
+}
+
+void file_service_impl::unregister_buffers()
+{
+    std::unique_lock<std::mutex> lock(buffers_guard_);
+    backend_->unregister_buffers();
+    buffers_.clear();
+}
+
+void file_service_impl::complete(file_request &r, long result)
+{
+    if (result < 0) {
+        const int err = static_cast<int>(-result);
+        r.handler->set_error(generic_error(err,
+            std::system_category().message(err)));
+    }
+    else {
+        r.transferred = static_cast<std::size_t>(result);
+    }
+}
+
+bool file_service_impl::valid_buffer(const file_request &r) const
+{
+    if (static_cast<std::size_t>(r.buffer_index) >= buffers_.size())
+        return false;
+
+    const file_buffer &b = buffers_[r.buffer_index];
+    const std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(b.data);
+    const std::uintptr_t data = reinterpret_cast<std::uintptr_t>(r.data);
+    return data >= begin && r.size <= b.size && data - begin <= b.size - r.size;
+}
+
+} // namespace detail
+
+} // namespace cport
+
+#endif // __FILE_SERVICE_IMPL_IPP__
@@ -0,0 +1,345 @@
+#ifndef __IO_URING_BACKEND_IPP__
+#define __IO_URING_BACKEND_IPP__
+
+//
+// io_uring_backend.ipp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/detail/io_uring_backend.hpp>
+#include <cport/detail/completion_port_impl.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace cport {
+
+namespace detail {
+
+// The ring indices are shared with the kernel
+inline unsigned uring_load_acquire(const unsigned *p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+inline void uring_store_release(unsigned *p, unsigned value)
+{
+    __atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+
+io_uring_backend::io_uring_backend(completion_port_impl &port, unsigned entries)
+    : port_(port)
+    , ring_fd_(-1)
+    , sq_entries_(0)
+    , sq_ring_(nullptr)
+    , sq_ring_size_(0)
+    , cq_ring_(nullptr)
+    , cq_ring_size_(0)
+    , sqes_(nullptr)
+    , sqes_size_(0)
+    , idle_(false)
+    , inflight_(0)
+    , stopped_(false)
+{
+    io_uring_params p;
+    std::memset(&p, 0, sizeof(p));
+    ring_fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &p));
+    if (ring_fd_ < 0)
+        throw std::system_error(errno, std::system_category(), "io_uring_setup");
+
+    try {
+        probe();
+    }
+    catch (...) {
+        ::close(ring_fd_);
+        throw;
+    }
+
+    sq_entries_ = p.sq_entries;
+    sq_ring_size_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    sqes_size_ = p.sq_entries * sizeof(io_uring_sqe);
+
+    const bool single_mmap = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap)
+        sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+
+    const auto map = [this](std::size_t size, off_t offset) -> void* {
+        void *p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, ring_fd_, offset);
+        return p == MAP_FAILED ? nullptr : p;
+    };
+
+    sq_ring_ = map(sq_ring_size_, IORING_OFF_SQ_RING);
+    cq_ring_ = single_mmap ? sq_ring_ : map(cq_ring_size_, IORING_OFF_CQ_RING);
+    sqes_ = static_cast<io_uring_sqe *>(map(sqes_size_, IORING_OFF_SQES));
+    if (sq_ring_ == nullptr || cq_ring_ == nullptr || sqes_ == nullptr) {
+        const int err = errno;
+        unmap();
+        ::close(ring_fd_);
+        throw std::system_error(err, std::system_category(), "mmap");
+    }
+
+    char *sq = static_cast<char *>(sq_ring_);
+    sq_head_ = reinterpret_cast<unsigned *>(sq + p.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned *>(sq + p.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned *>(sq + p.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned *>(sq + p.sq_off.array);
+
+    char *cq = static_cast<char *>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned *>(cq + p.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned *>(cq + p.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned *>(cq + p.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe *>(cq + p.cq_off.cqes);
+
+    thread_ = std::thread(&io_uring_backend::thread_routine, this);
+}
+
+io_uring_backend::~io_uring_backend()
+{
+    shutdown();
+    unmap();
+    ::close(ring_fd_);
+}
+
+void io_uring_backend::submit(file_request *const *requests, std::size_t count)
+{
+    std::vector<completion_handler_base *> failed;
+    {
+        std::unique_lock<std::mutex> lock(guard_);
+        pending_.insert(pending_.end(), requests, requests + count);
+        flush(failed);
+    }
+    if (!failed.empty())
+        port_.post(failed.data(), failed.size());
+}
+
+void io_uring_backend::register_buffers(const file_buffer *buffers,
+    std::size_t count)
+{
+    std::vector<iovec> iov(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        iov[i].iov_base = buffers[i].data;
+        iov[i].iov_len = buffers[i].size;
+    }
+
+    // Registered buffers are replaced as a whole
+    unregister_buffers();
+    if (::syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_BUFFERS,
+            iov.data(), static_cast<unsigned>(count)) < 0)
+        throw std::system_error(errno, std::system_category(),
+            "io_uring_register");
+}
+
+void io_uring_backend::unregister_buffers()
+{
+    ::syscall(__NR_io_uring_register, ring_fd_, IORING_UNREGISTER_BUFFERS,
+        nullptr, 0);
+}
+
+void io_uring_backend::shutdown()
+{
+    std::unique_lock<std::mutex> lock(guard_);
+    if (stopped_)
+        return;
+    stopped_ = true;
+
+    // Requests can not be canceled once submitted, wait for all of them
+    while (inflight_ != 0 || !pending_.empty())
+        drained_.wait(lock);
+    work_.notify_one();
+    lock.unlock();
+
+    thread_.join();
+}
+
+void io_uring_backend::probe()
+{
+    // IORING_OP_READ and IORING_OP_WRITE came with the probe in 5.6, on older
+    //  kernels the ring works but every request fails with EINVAL
+    const unsigned ops = 256;
+    std::vector<char> buffer(sizeof(io_uring_probe) + ops * sizeof(io_uring_probe_op));
+    io_uring_probe *p = reinterpret_cast<io_uring_probe *>(buffer.data());
+    if (::syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_PROBE, p, ops) < 0)
+        throw std::system_error(errno, std::system_category(), "io_uring_register");
+
+    const auto supported = [p](unsigned op) {
+        return op <= p->last_op && (p->ops[op].flags & IO_URING_OP_SUPPORTED) != 0;
+    };
+    if (!supported(IORING_OP_READ) || !supported(IORING_OP_WRITE))
+        throw std::system_error(std::make_error_code(
+            std::errc::function_not_supported), "io_uring");
+}
+
+void io_uring_backend::flush(std::vector<completion_handler_base *> &failed)
+{
+    // Up to sq_entries_ requests are in flight, so the completion queue
+    //  which is at least twice as large never overflows.
+    unsigned tail = *sq_tail_;
+    while (!pending_.empty() && inflight_ < sq_entries_) {
+        file_request *r = pending_.front();
+        pending_.pop_front();
+
+        const unsigned index = tail & *sq_mask_;
+        io_uring_sqe &sqe = sqes_[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+
+        const bool fixed = r->buffer_index >= 0;
+        if (r->op == file_request::read_op)
+            sqe.opcode = fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+        else
+            sqe.opcode = fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+        sqe.fd = r->fd;
+        sqe.off = r->offset;
+        sqe.addr = reinterpret_cast<std::uintptr_t>(r->data);
+        // The same limit as read() and write() have, the rest is a short transfer
+        sqe.len = static_cast<unsigned>(std::min<std::size_t>(r->size, 0x7ffff000));
+        if (fixed)
+            sqe.buf_index = static_cast<std::uint16_t>(r->buffer_index);
+        sqe.user_data = reinterpret_cast<std::uintptr_t>(r);
+
+        sq_array_[index] = index;
+        ++tail;
+        ++inflight_;
+    }
+    uring_store_release(sq_tail_, tail);
+
+    const unsigned to_submit = unsubmitted();
+    if (to_submit != 0) {
+        // The kernel is out of resources, the reaping thread retries
+        //  after it reaps
+        const int err = enter(to_submit, 0, 0);
+        if (err != 0 && err != EAGAIN && err != EBUSY) {
+            fail_unsubmitted(err, failed);
+            if (!pending_.empty())
+                flush(failed);
+        }
+    }
+
+    if (idle_ && inflight_ != 0)
+        work_.notify_one();
+}
+
+void io_uring_backend::fail_unsubmitted(int err,
+    std::vector<completion_handler_base *> &failed)
+{
+    // The kernel consumes entries only within enter(), which is called under
+    //  the lock, so the tail can be moved back
+    const unsigned head = uring_load_acquire(sq_head_);
+    unsigned tail = *sq_tail_;
+    inflight_ -= tail - head;
+    for (; tail != head; --tail) {
+        const io_uring_sqe &sqe = sqes_[sq_array_[(tail - 1) & *sq_mask_]];
+        file_request *r = reinterpret_cast<file_request *>(
+            static_cast<std::uintptr_t>(sqe.user_data));
+        file_service_impl::complete(*r, -err);
+        failed.push_back(r->handler);
+    }
+    uring_store_release(sq_tail_, tail);
+
+    if (inflight_ == 0 && pending_.empty())
+        drained_.notify_all();
+}
+
+unsigned io_uring_backend::unsubmitted() const
+{
+    return *sq_tail_ - uring_load_acquire(sq_head_);
+}
+
+int io_uring_backend::enter(unsigned to_submit, unsigned min_complete,
+    unsigned flags)
+{
+    for (;;) {
+        if (::syscall(__NR_io_uring_enter, ring_fd_, to_submit, min_complete,
+                flags, nullptr, 0) >= 0)
+            return 0;
+        if (errno != EINTR)
+            return errno;
+    }
+}
+
+void io_uring_backend::thread_routine()
+{
+    std::vector<completion_handler_base *> completed;
+    std::unique_lock<std::mutex> lock(guard_);
+    for (;;) {
+        // Retry the entries refused with EAGAIN or EBUSY
+        if (unsubmitted() != 0)
+            flush(completed);
+        if (!completed.empty()) {
+            // Requests which failed to submit
+            lock.unlock();
+            port_.post(completed.data(), completed.size());
+            completed.clear();
+            lock.lock();
+            continue;
+        }
+
+        if (inflight_ == 0) {
+            if (stopped_ && pending_.empty())
+                break;
+            idle_ = true;
+            work_.wait(lock);
+            idle_ = false;
+            continue;
+        }
+
+        // Wait in the kernel only for the requests it holds
+        const bool held = inflight_ != unsubmitted();
+        lock.unlock();
+        if (held)
+            enter(0, 1, IORING_ENTER_GETEVENTS);
+        else
+            std::this_thread::yield();
+
+        unsigned head = *cq_head_;
+        const unsigned tail = uring_load_acquire(cq_tail_);
+        const std::size_t reaped = tail - head;
+        for (; head != tail; ++head) {
+            const io_uring_cqe &cqe = cqes_[head & *cq_mask_];
+            file_request *r = reinterpret_cast<file_request *>(
+                static_cast<std::uintptr_t>(cqe.user_data));
+            file_service_impl::complete(*r, cqe.res);
+            completed.push_back(r->handler);
+        }
+        uring_store_release(cq_head_, head);
+
+        if (!completed.empty())
+            port_.post(completed.data(), completed.size());
+        completed.clear();
+
+        lock.lock();
+        inflight_ -= reaped;
+        flush(completed);
+        if (inflight_ == 0 && pending_.empty())
+            drained_.notify_all();
+    }
+}
+
+void io_uring_backend::unmap()
+{
+    if (sqes_ != nullptr)
+        ::munmap(sqes_, sqes_size_);
+    if (cq_ring_ != nullptr && cq_ring_ != sq_ring_)
+        ::munmap(cq_ring_, cq_ring_size_);
+    if (sq_ring_ != nullptr)
+        ::munmap(sq_ring_, sq_ring_size_);
+}
+
+} // namespace detail
+
+} // namespace cport
+
+#endif // __IO_URING_BACKEND_IPP__
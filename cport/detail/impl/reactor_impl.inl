@@ -0,0 +1,115 @@
+#ifndef __REACTOR_IMPL_INL__
+#define __REACTOR_IMPL_INL__
+
+//
+// reactor_impl.inl
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/detail/completion_handler.hpp>
+#include <cport/detail/completion_port_impl.hpp>
+#include <type_traits>
+
+namespace cport {
+
+namespace detail {
+
+// Invokes the handler of a persistent registration and re-arms it.
+template <typename Handler>
+class reactor_rearm_handler {
+public:
+    reactor_rearm_handler(const Handler &h, const std::shared_ptr<reactor_impl> &r,
+        std::uint64_t id)
+        : handler_(h), reactor_(r), id_(id)
+    {
+    }
+
+    void operator()(const generic_error &e)
+    {
+        // Re-armed even if the handler throws
+        struct rearm_guard {
+            const std::shared_ptr<reactor_impl> &reactor;
+            std::uint64_t id;
+            ~rearm_guard()
+            {
+                if (reactor)
+                    reactor->rearm(id);
+            }
+        };
+
+        rearm_guard guard = { reactor_, id_ };
+        handler_(e);
+    }
+
+private:
+    Handler handler_;
+    std::shared_ptr<reactor_impl> reactor_;
+    std::uint64_t id_;
+};
+
+template <typename Handler>
+inline reactor_op_impl<Handler>::reactor_op_impl(Handler&& h)
+    : handler_(std::move(h))
+{
+}
+
+template <typename Handler>
+inline reactor_op_impl<Handler>::reactor_op_impl(const Handler& h)
+    : handler_(h)
+{
+}
+
+template <typename Handler>
+inline completion_handler_base* reactor_op_impl<Handler>::create(
+    memory_resource &mr, const std::shared_ptr<reactor_impl> &r, std::uint64_t id,
+    std::size_t seqno, const error_code &e)
+{
+    return create_completion_handler(mr,
+        reactor_rearm_handler<Handler>(handler_, r, id), seqno, e);
+}
+
+template <typename Handler>
+inline reactor_handle reactor_impl::async_wait(int fd, int events, Handler&& h)
+{
+    const std::size_t seqno = port_.next_operation_id();
+    if (seqno == 0)
+        return reactor_handle();
+
+    return add(fd, events, create_completion_handler(port_.resource(),
+        std::forward<Handler>(h), seqno, error_code()), std::unique_ptr<reactor_op>(), seqno);
+}
+
+template <typename Handler>
+inline reactor_handle reactor_impl::watch(int fd, int events, Handler&& h)
+{
+    typedef typename std::decay<Handler>::type handler_type;
+
+    const std::size_t seqno = port_.next_operation_id();
+    if (seqno == 0)
+        return reactor_handle();
+
+    return add(fd, events, nullptr, std::unique_ptr<reactor_op>(
+        new reactor_op_impl<handler_type>(std::forward<Handler>(h))), seqno);
+}
+
+inline std::size_t reactor_impl::registrations() const
+{
+    std::unique_lock<std::mutex> lock(guard_);
+    return registrations_;
+}
+
+inline std::uint64_t reactor_impl::make_id(std::size_t index, std::uint32_t generation)
+{
+    return (static_cast<std::uint64_t>(generation) << 32)
+        | static_cast<std::uint32_t>(index);
+}
+
+} // namespace detail
+
+} // namespace cport
+
+#endif // __REACTOR_IMPL_INL__
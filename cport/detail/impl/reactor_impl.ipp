@@ -0,0 +1,305 @@
+#ifndef __REACTOR_IMPL_IPP__
+#define __REACTOR_IMPL_IPP__
+
+//
+// reactor_impl.ipp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/detail/reactor_impl.hpp>
+#include <cport/detail/completion_port_impl.hpp>
+#include <cerrno>
+#include <system_error>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace cport {
+
+namespace detail {
+
+reactor_impl::reactor_impl(completion_port_impl &port)
+    : port_(port)
+    , epoll_fd_(::epoll_create1(EPOLL_CLOEXEC))
+    , wake_fd_(-1)
+    , stopped_(false)
+    , error_(0)
+    , registrations_(0)
+{
+    if (epoll_fd_ < 0)
+        throw std::system_error(errno, std::system_category(), "epoll_create1");
+
+    wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.u64 = 0;
+    if (wake_fd_ < 0 || ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev) < 0) {
+        const int err = errno;
+        if (wake_fd_ >= 0)
+            ::close(wake_fd_);
+        ::close(epoll_fd_);
+        throw std::system_error(err, std::system_category(), "eventfd");
+    }
+
+    thread_ = std::thread(&reactor_impl::thread_routine, this);
+}
+
+reactor_impl::~reactor_impl()
+{
+    shutdown();
+    ::close(wake_fd_);
+    ::close(epoll_fd_);
+}
+
+void reactor_impl::shutdown()
+{
+    {
+        std::unique_lock<std::mutex> lock(guard_);
+        if (stopped_)
+            return;
+        stopped_ = true;
+    }
+
+    const std::uint64_t value = 1;
+    while (::write(wake_fd_, &value, sizeof(value)) < 0 && errno == EINTR)
+        ;
+    thread_.join();
+
+    std::vector<completion_handler_base *> canceled;
+    {
+        std::unique_lock<std::mutex> lock(guard_);
+        abort_all(operation_aborted_error(), canceled);
+    }
+    port_.post(canceled.data(), canceled.size());
+}
+
+reactor_handle reactor_impl::add(int fd, int events, completion_handler_base *h,
+    std::unique_ptr<reactor_op> op, std::size_t seqno)
+{
+    std::unique_lock<std::mutex> lock(guard_);
+    std::size_t index = 0;
+    if (free_nodes_.empty()) {
+        index = nodes_.size();
+        nodes_.emplace_back();
+        nodes_.back().generation = 1;
+    }
+    else {
+        index = free_nodes_.back();
+        free_nodes_.pop_back();
+    }
+
+    reactor_node &n = nodes_[index];
+    n.fd = fd;
+    n.events = ((events & read_event) ? std::uint32_t(EPOLLIN) : 0)
+        | ((events & write_event) ? std::uint32_t(EPOLLOUT) : 0);
+    n.armed = true;
+    n.seqno = seqno;
+    n.handler = h;
+    n.op = std::move(op);
+    ++registrations_;
+
+    const std::uint64_t id = make_id(index, n.generation);
+    epoll_event ev = {};
+    ev.events = n.events | EPOLLONESHOT;
+    ev.data.u64 = id;
+    // Nothing waits for the events after epoll_wait() failed
+    if (error_ != 0 || ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        const int err = error_ != 0 ? error_ : errno;
+        completion_handler_base *failed = abort_handler(n,
+            generic_error(err, std::system_category().message(err)));
+        release_node(id);
+        lock.unlock();
+
+        port_.post(&failed, 1);
+        return reactor_handle();
+    }
+    return reactor_handle(id);
+}
+
+bool reactor_impl::cancel(const reactor_handle &r)
+{
+    std::unique_lock<std::mutex> lock(guard_);
+    reactor_node *n = find(r.id_);
+    if (n == nullptr || n->canceled)
+        return false;
+
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, n->fd, nullptr);
+    if (n->op && !n->armed) {
+        // The handler is posted or running, rearm() aborts the registration
+        n->canceled = true;
+        n->abort_error = operation_aborted_error();
+        --registrations_;
+        return true;
+    }
+
+    completion_handler_base *h = abort_handler(*n, operation_aborted_error());
+    release_node(r.id_);
+    lock.unlock();
+
+    port_.post(&h, 1);
+    return true;
+}
+
+void reactor_impl::rearm(std::uint64_t id)
+{
+    std::unique_lock<std::mutex> lock(guard_);
+    reactor_node *n = find(id);
+    if (n == nullptr || n->armed)
+        return;
+
+    if (n->canceled) {
+        completion_handler_base *h = abort_handler(*n, n->abort_error);
+        release_node(id);
+        lock.unlock();
+
+        port_.post(&h, 1);
+        return;
+    }
+
+    if (stopped_)
+        return;
+
+    epoll_event ev = {};
+    ev.events = n->events | EPOLLONESHOT;
+    ev.data.u64 = id;
+    if (::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, n->fd, &ev) == 0) {
+        n->armed = true;
+        return;
+    }
+
+    // The descriptor was closed, the registration ends with the error
+    const int err = errno;
+    completion_handler_base *h = abort_handler(*n,
+        generic_error(err, std::system_category().message(err)));
+    release_node(id);
+    lock.unlock();
+
+    port_.post(&h, 1);
+}
+
+reactor_node* reactor_impl::find(std::uint64_t id)
+{
+    const std::size_t index = static_cast<std::uint32_t>(id);
+    if (index >= nodes_.size())
+        return nullptr;
+
+    reactor_node &n = nodes_[index];
+    if (n.generation != static_cast<std::uint32_t>(id >> 32)
+        || (n.handler == nullptr && !n.op))
+        return nullptr;
+    return &n;
+}
+
+void reactor_impl::release_node(std::uint64_t id)
+{
+    const std::size_t index = static_cast<std::uint32_t>(id);
+    reactor_node &n = nodes_[index];
+    // A canceled registration is not counted already
+    if (!n.canceled)
+        --registrations_;
+    n.armed = false;
+    n.canceled = false;
+    n.abort_error = error_code();
+    n.handler = nullptr;
+    n.op.reset();
+    // Zero is reserved for invalid identifiers
+    if (++n.generation == 0)
+        n.generation = 1;
+    free_nodes_.push_back(index);
+}
+
+void reactor_impl::abort_all(const error_code &e,
+    std::vector<completion_handler_base *> &aborted)
+{
+    for (std::size_t i = 0; i < nodes_.size(); ++i) {
+        const std::uint64_t id = make_id(i, nodes_[i].generation);
+        reactor_node *n = find(id);
+        if (n == nullptr || n->canceled)
+            continue;
+
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, n->fd, nullptr);
+        if (n->op && !n->armed) {
+            // Not concurrently with the posted handler
+            n->canceled = true;
+            n->abort_error = e;
+            --registrations_;
+            continue;
+        }
+        aborted.push_back(abort_handler(*n, e));
+        release_node(id);
+    }
+}
+
+completion_handler_base* reactor_impl::abort_handler(reactor_node &n,
+    const error_code &e)
+{
+    if (completion_handler_base *h = n.handler) {
+        n.handler = nullptr;
+        h->set_error(e);
+        return h;
+    }
+    return n.op->create(port_.resource(), std::shared_ptr<reactor_impl>(), 0,
+        n.seqno, e);
+}
+
+void reactor_impl::thread_routine()
+{
+    enum { max_events = 64 };
+    epoll_event events[max_events];
+    std::vector<completion_handler_base *> ready;
+
+    for (;;) {
+        const int count = ::epoll_wait(epoll_fd_, events, max_events, -1);
+        const int err = count < 0 ? errno : 0;
+
+        std::unique_lock<std::mutex> lock(guard_);
+        if (stopped_)
+            break;
+
+        if (err != 0 && err != EINTR) {
+            // No registration completes any more, end them with the error
+            error_ = err;
+            abort_all(generic_error(err, std::system_category().message(err)), ready);
+            lock.unlock();
+
+            port_.post(ready.data(), ready.size());
+            break;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            const std::uint64_t id = events[i].data.u64;
+            reactor_node *n = find(id);
+            if (n == nullptr || !n->armed)
+                continue;
+
+            if (n->op) {
+                // Re-armed after the handler is invoked
+                n->armed = false;
+                // Posted even if the port is stopped, so that the registration
+                //  is re-armed or aborted after it
+                ready.push_back(n->op->create(port_.resource(), shared_from_this(), id,
+                    completion_port_impl::direct_seqno(), error_code()));
+            }
+            else {
+                ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, n->fd, nullptr);
+                ready.push_back(n->handler);
+                n->handler = nullptr;
+                release_node(id);
+            }
+        }
+        lock.unlock();
+
+        port_.post(ready.data(), ready.size());
+        ready.clear();
+    }
+}
+
+} // namespace detail
+
+} // namespace cport
+
+#endif // __REACTOR_IMPL_IPP__
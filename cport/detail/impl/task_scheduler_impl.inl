@@ -22,7 +22,8 @@ inline task_t task_scheduler_impl::async(TaskHandler&& th, CompletionHandler&& c
     const operation_id id = port_.next_operation_id();
     if (id.valid())
     {
-        enqueue_task(create_task_handler(std::forward<TaskHandler>(th),
+        trace(trace_event::async, id);
+        enqueue_task(create_task_handler(resource_, std::forward<TaskHandler>(th),
             std::forward<CompletionHandler>(ch), id));
     }
     return task_t(id);
@@ -30,7 +31,10 @@ inline task_t task_scheduler_impl::async(TaskHandler&& th, CompletionHandler&& c
 
 inline std::size_t task_scheduler_impl::cancel_all()
 {
-    std::unique_lock<std::mutex> lock(guard_);
+    if (policy_ == scheduling_policy::work_stealing)
+        return cancel_all_stealable();
+
+    std::unique_lock<mutex_type> lock(guard_);
     const std::size_t count = pending_tasks_.size();
     cancel_pending_tasks();
     return count;
@@ -38,17 +42,51 @@ inline std::size_t task_scheduler_impl::cancel_all()
 
 inline std::size_t task_scheduler_impl::packaged_tasks() const
 {
-    std::unique_lock<std::mutex> lock(guard_);
-    return pending_tasks_.size();
+    if (policy_ == scheduling_policy::work_stealing) {
+        // The sums are taken one after the other
+        const std::uint64_t removed = queue_counts_.sum(queue_removed);
+        const std::uint64_t pushed = queue_counts_.sum(queue_pushed);
+        return pushed > removed ? static_cast<std::size_t>(pushed - removed) : 0;
+    }
+    return pending_count_;
+}
+
+inline void task_scheduler_impl::set_wait_policy(const wait_policy &wp)
+{
+    waiter_.set_policy(wp);
+}
+
+inline wait_policy task_scheduler_impl::get_wait_policy() const
+{
+    return waiter_.get_policy();
+}
+
+inline wait_stats task_scheduler_impl::get_wait_stats() const
+{
+    return waiter_.get_stats();
 }
 
 inline void task_scheduler_impl::enqueue_task(task_handler_base *h)
 {
-    std::unique_lock<std::mutex> lock(guard_);
-    pending_tasks_.push_back(h);
+#ifdef CPORT_HAS_METRICS
+    h->set_enqueued(std::chrono::steady_clock::now());
+#endif // CPORT_HAS_METRICS
+    trace(trace_event::enqueue, h->id());
 #ifdef CPORT_ENABLE_TASK_STATUS
     h->id().set_status(completion_status::scheduled);
 #endif
+    if (policy_ == scheduling_policy::work_stealing) {
+        push_task(h);
+        return;
+    }
+
+    std::unique_lock<mutex_type> lock(guard_);
+    pending_tasks_.push_back(h);
+    pending_count_ = pending_tasks_.size();
+#ifdef CPORT_HAS_METRICS
+    metrics_.add(metric_enqueued);
+    update_high_water(pending_high_water_, pending_tasks_.size());
+#endif // CPORT_HAS_METRICS
     cond_.notify_one();
 }
 
@@ -57,9 +95,23 @@ inline completion_port_impl& task_scheduler_impl::get_completion_port()
     return port_;
 }
 
+inline memory_resource& task_scheduler_impl::resource() const
+{
+    return resource_;
+}
+
+inline scheduling_policy task_scheduler_impl::policy() const
+{
+    return policy_;
+}
+
 inline void task_scheduler_impl::cancel_pending_task(task_handler_base *h,
-    const generic_error &e)
+    const error_code &e)
 {
+#ifdef CPORT_HAS_METRICS
+    metrics_.add(metric_canceled);
+#endif // CPORT_HAS_METRICS
+    trace(trace_event::cancel, h->id());
 #ifdef CPORT_ENABLE_TASK_STATUS
     h->id().set_status(completion_status::canceled);
 #endif
@@ -68,11 +120,35 @@ inline void task_scheduler_impl::cancel_pending_task(task_handler_base *h,
 
 inline void task_scheduler_impl::stop_threads()
 {
-    std::unique_lock<std::mutex> lock(guard_);
+    std::unique_lock<mutex_type> lock(guard_);
     threads_stopped_ = true;
     cond_.notify_all();
 }
 
+inline void task_scheduler_impl::enter_queues(worker_state &w)
+{
+    for (;;) {
+        // Pairs with the store of paused_ in pause_workers()
+        w.busy.store(true, std::memory_order_seq_cst);
+        if (!paused_.load(std::memory_order_seq_cst))
+            return;
+
+        w.busy.store(false, std::memory_order_release);
+        while (paused_.load(std::memory_order_acquire))
+            std::this_thread::yield();
+    }
+}
+
+inline void task_scheduler_impl::leave_queues(worker_state &w)
+{
+    w.busy.store(false, std::memory_order_release);
+}
+
+inline void task_scheduler_impl::resume_workers()
+{
+    paused_.store(false, std::memory_order_release);
+}
+
 inline void task_scheduler_impl::join_threads()
 {
     threads_.join();
@@ -19,13 +19,28 @@ namespace detail {
 
 task_scheduler_impl::task_scheduler_impl(completion_port_impl &port
         , std::size_t concurrency_hint
-        , worker_context_prototype wcp)
+        , worker_context_prototype wcp
+        , memory_resource *r
+        , scheduling_policy policy)
     : port_(port)
+    , resource_(r != nullptr ? *r : port.resource())
+    , pending_tasks_(resource_allocator<task_handler_base *>(&resource_))
+    , pending_count_(0)
     , threads_stopped_(false)
+    , policy_(policy)
+    , next_worker_(0)
+    , sleepers_(0)
+    , paused_(false)
+    , pending_high_water_(0)
 {
     if (concurrency_hint == 0)
         concurrency_hint = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
 
+    if (policy_ == scheduling_policy::work_stealing) {
+        for (std::size_t i = 0; i < concurrency_hint; ++i)
+            workers_.emplace_back(new worker_state(i, resource_));
+    }
+
     threads_ = util::thread_group(
         std::bind(&task_scheduler_impl::thread_routine, this, wcp),
         concurrency_hint);
@@ -42,7 +57,10 @@ bool task_scheduler_impl::cancel(const task_t &task)
 {
     assert(task);
 
-    std::unique_lock<std::mutex> lock(guard_);
+    if (policy_ == scheduling_policy::work_stealing)
+        return cancel_stealable(task);
+
+    std::unique_lock<mutex_type> lock(guard_);
     if (pending_tasks_.empty())
         return false;
 
@@ -56,6 +74,7 @@ bool task_scheduler_impl::cancel(const task_t &task)
 
     auto_destroy op(*i);
     pending_tasks_.erase(i);
+    pending_count_ = pending_tasks_.size();
     lock.unlock();
     cancel_pending_task(op.get());
     return true;
@@ -63,38 +82,337 @@ bool task_scheduler_impl::cancel(const task_t &task)
 
 void task_scheduler_impl::cancel_pending_tasks()
 {
-    const operation_aborted_error e;
+    const error_code e = operation_aborted_error();
     while (!pending_tasks_.empty()) {
         auto_destroy task(pending_tasks_.front());
         pending_tasks_.pop_front();
+        pending_count_ = pending_tasks_.size();
         cancel_pending_task(task.get(), e);
     }
+
+    // The workers are stopped
+    for (const std::unique_ptr<worker_state> &w : workers_) {
+        w->tasks.drain([this, &e](task_handler_base *h) {
+            auto_destroy task(h);
+            cancel_pending_task(task.get(), e);
+        });
+    }
+}
+
+scheduler_metrics task_scheduler_impl::snapshot() const
+{
+    scheduler_metrics m;
+    m.enqueued = metrics_.sum(metric_enqueued);
+    m.executed = metrics_.sum(metric_executed);
+    m.canceled = metrics_.sum(metric_canceled);
+    m.pending = packaged_tasks();
+    m.pending_high_water = pending_high_water_.load(std::memory_order_relaxed);
+    m.busy_time = std::chrono::nanoseconds(metrics_.sum(metric_busy_time));
+    m.idle_time = std::chrono::nanoseconds(metrics_.sum(metric_idle_time));
+    return m;
+}
+
+task_latency task_scheduler_impl::latency() const
+{
+    task_latency l;
+    l.queueing = queueing_latency_.snapshot();
+    l.execution = execution_latency_.snapshot();
+    l.completion = port_.task_completion_latency().snapshot();
+    return l;
 }
 
 void task_scheduler_impl::thread_routine_loop()
 {
+    if (policy_ == scheduling_policy::work_stealing) {
+        work_stealing_loop();
+        return;
+    }
+
+    // The end of the last task, or the start of the worker
+    std::chrono::steady_clock::time_point idle_since = std::chrono::steady_clock::now();
     for (;;) {
-        std::unique_lock<std::mutex> lock(guard_);
+        std::unique_lock<mutex_type> lock(guard_);
         if (threads_stopped_)
             break;
 
         if (pending_tasks_.empty()) {
-            cond_.wait(lock);
+            lock.unlock();
+            if (waiter_.spin([this]() {
+                    return threads_stopped_ || pending_count_ != 0; }))
+                continue;
+
+            lock.lock();
+            if (!threads_stopped_ && pending_tasks_.empty()) {
+                waiter_.parked();
+                cond_.wait(lock);
+            }
         }
         else {
             auto_destroy task(pending_tasks_.front());
             pending_tasks_.pop_front();
+            pending_count_ = pending_tasks_.size();
             lock.unlock();
+            execute_task(task.get(), idle_since);
+        }
+    }
+#ifdef CPORT_HAS_METRICS
+    metrics_.add(metric_idle_time, std::chrono::duration_cast<
+        std::chrono::nanoseconds>(std::chrono::steady_clock::now() - idle_since).count());
+#endif // CPORT_HAS_METRICS
+}
+
+void task_scheduler_impl::work_stealing_loop()
+{
+    worker_state &w = *workers_[next_worker_.fetch_add(1) % workers_.size()];
+    worker_slot &slot = current_worker();
+    slot.scheduler = this;
+    slot.worker = &w;
+
+    std::chrono::steady_clock::time_point idle_since = std::chrono::steady_clock::now();
+    while (!threads_stopped_) {
+        if (task_handler_base *h = take_task(w)) {
+            auto_destroy task(h);
+            execute_task(task.get(), idle_since);
+            continue;
+        }
+
+        if (waiter_.spin([this]() { return threads_stopped_ || has_tasks(); }))
+            continue;
+
+        std::unique_lock<mutex_type> lock(guard_);
+        // Pairs with the fence in push_task()
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!threads_stopped_ && !has_tasks()) {
+            waiter_.parked();
+            cond_.wait(lock);
+        }
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    slot.scheduler = nullptr;
+    slot.worker = nullptr;
+#ifdef CPORT_HAS_METRICS
+    metrics_.add(metric_idle_time, std::chrono::duration_cast<
+        std::chrono::nanoseconds>(std::chrono::steady_clock::now() - idle_since).count());
+#endif // CPORT_HAS_METRICS
+}
+
+void task_scheduler_impl::execute_task(task_handler_base *task
+    , std::chrono::steady_clock::time_point &idle_since)
+{
+#ifdef CPORT_HAS_METRICS
+    typedef std::chrono::steady_clock clock;
+    const clock::time_point start = clock::now();
+    metrics_.add(metric_idle_time, std::chrono::duration_cast<
+        std::chrono::nanoseconds>(start - idle_since).count());
+    queueing_latency_.record(std::chrono::duration_cast<
+        std::chrono::nanoseconds>(start - task->enqueued()));
+#endif // CPORT_HAS_METRICS
 #ifdef CPORT_ENABLE_TASK_STATUS
-            task->id().set_status(completion_status::executing);
+    task->id().set_status(completion_status::executing);
 #endif
-            task->execute(port_);
+    trace(trace_event::start, task->id());
+    task->execute(port_);
+    trace(trace_event::end, task->id());
 
 #ifdef CPORT_ENABLE_TASK_STATUS
-            task->id().set_status(completion_status::complete);
+    task->id().set_status(completion_status::complete);
 #endif
+#ifdef CPORT_HAS_METRICS
+    idle_since = clock::now();
+    const std::chrono::nanoseconds busy = std::chrono::duration_cast<
+        std::chrono::nanoseconds>(idle_since - start);
+    metrics_.add(metric_busy_time, busy.count());
+    execution_latency_.record(busy);
+    metrics_.add(metric_executed);
+#else
+    (void)idle_since;
+#endif // CPORT_HAS_METRICS
+}
+
+task_scheduler_impl::worker_slot& task_scheduler_impl::current_worker()
+{
+    static thread_local worker_slot slot = { nullptr, nullptr };
+    return slot;
+}
+
+void task_scheduler_impl::push_task(task_handler_base *h)
+{
+#ifdef CPORT_HAS_METRICS
+    metrics_.add(metric_enqueued);
+#endif // CPORT_HAS_METRICS
+    queue_counts_.add(queue_pushed);
+
+    const worker_slot &slot = current_worker();
+    if (slot.scheduler != this) {
+        std::unique_lock<mutex_type> lock(guard_);
+        pending_tasks_.push_back(h);
+        pending_count_ = pending_tasks_.size();
+#ifdef CPORT_HAS_METRICS
+        update_high_water(pending_high_water_, pending_tasks_.size());
+#endif // CPORT_HAS_METRICS
+        // The sleeping workers check for tasks under the lock
+        if (sleepers_.load(std::memory_order_relaxed) != 0)
+            cond_.notify_one();
+        return;
+    }
+
+    // A task scheduled by a worker goes to its own deque
+    worker_state &w = *slot.worker;
+    enter_queues(w);
+    w.tasks.push(h);
+#ifdef CPORT_HAS_METRICS
+    update_high_water(pending_high_water_, w.tasks.size());
+#endif // CPORT_HAS_METRICS
+    leave_queues(w);
+
+    // Wake a sleeping worker to steal the task. Pairs with the fence of
+    //  a worker going to sleep: either the worker sees the task or the
+    //  sleeper is seen here.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers_.load(std::memory_order_relaxed) != 0) {
+        std::unique_lock<mutex_type> lock(guard_);
+        cond_.notify_one();
+    }
+}
+
+task_handler_base* task_scheduler_impl::take_task(worker_state &w)
+{
+    enter_queues(w);
+    task_handler_base *h = w.tasks.pop();
+    if (h == nullptr && pending_count_.load(std::memory_order_relaxed) != 0)
+        h = take_injected_tasks(w);
+    if (h == nullptr)
+        h = steal_task(w);
+    leave_queues(w);
+
+    if (h != nullptr)
+        queue_counts_.add(queue_removed);
+    return h;
+}
+
+task_handler_base* task_scheduler_impl::take_injected_tasks(worker_state &w)
+{
+    std::unique_lock<mutex_type> lock(guard_);
+    if (pending_tasks_.empty())
+        return nullptr;
+
+    // Take a fair share of the queue, up to 32 tasks, to lock it less often
+    const std::size_t count = std::min<std::size_t>(
+        (pending_tasks_.size() + workers_.size() - 1) / workers_.size(), 32);
+    task_handler_base *h = pending_tasks_.front();
+    // The owner pops the newest first, so the tasks run in FIFO order
+    for (std::size_t i = count - 1; i > 0; --i)
+        w.tasks.push(pending_tasks_[i]);
+    pending_tasks_.erase(pending_tasks_.begin(), pending_tasks_.begin() + count);
+    pending_count_ = pending_tasks_.size();
+
+    // Let a sleeping worker steal from the batch
+    if (count > 1 && sleepers_.load(std::memory_order_relaxed) != 0)
+        cond_.notify_one();
+    return h;
+}
+
+task_handler_base* task_scheduler_impl::steal_task(worker_state &w)
+{
+    const std::size_t workers = workers_.size();
+    // Retry while the thieves race for the same tasks
+    for (bool contended = true; contended; ) {
+        contended = false;
+        for (std::size_t i = 1; i < workers; ++i) {
+            worker_state &victim = *workers_[(w.index + i) % workers];
+            if (victim.tasks.empty())
+                continue;
+            if (task_handler_base *h = victim.tasks.steal())
+                return h;
+            contended = true;
         }
     }
+    return nullptr;
+}
+
+bool task_scheduler_impl::has_tasks() const
+{
+    if (pending_count_.load(std::memory_order_relaxed) != 0)
+        return true;
+    for (const std::unique_ptr<worker_state> &w : workers_) {
+        if (!w->tasks.empty())
+            return true;
+    }
+    return false;
+}
+
+void task_scheduler_impl::pause_workers()
+{
+    // Pairs with the store of busy in enter_queues(): either the worker
+    //  sees the pause or its busy flag is seen here
+    paused_.store(true, std::memory_order_seq_cst);
+    for (const std::unique_ptr<worker_state> &w : workers_) {
+        while (w->busy.load(std::memory_order_seq_cst))
+            std::this_thread::yield();
+    }
+}
+
+bool task_scheduler_impl::cancel_stealable(const task_t &task)
+{
+    const auto match = [task](task_handler_base *h) { return task_t(h->id()) == task; };
+
+    task_handler_base *h = nullptr;
+    {
+        std::unique_lock<mutex_type> lock(guard_);
+        auto i = std::find_if(pending_tasks_.begin(), pending_tasks_.end(), match);
+        if (i != pending_tasks_.end()) {
+            h = *i;
+            pending_tasks_.erase(i);
+            pending_count_ = pending_tasks_.size();
+        }
+    }
+
+    // The task left the injection queue only for a deque, search them
+    if (h == nullptr) {
+        std::unique_lock<site_mutex<cancel_guard_site>> lock(cancel_guard_);
+        pause_workers();
+        for (const std::unique_ptr<worker_state> &w : workers_) {
+            if ((h = w->tasks.extract(match)) != nullptr)
+                break;
+        }
+        resume_workers();
+    }
+
+    if (h == nullptr)
+        return false;
+
+    auto_destroy op(h);
+    queue_counts_.add(queue_removed);
+    cancel_pending_task(op.get());
+    return true;
+}
+
+std::size_t task_scheduler_impl::cancel_all_stealable()
+{
+    std::vector<task_handler_base *> tasks;
+    {
+        std::unique_lock<site_mutex<cancel_guard_site>> cancel_lock(cancel_guard_);
+        pause_workers();
+        {
+            std::unique_lock<mutex_type> lock(guard_);
+            tasks.assign(pending_tasks_.begin(), pending_tasks_.end());
+            pending_tasks_.clear();
+            pending_count_ = 0;
+        }
+        for (const std::unique_ptr<worker_state> &w : workers_)
+            w->tasks.drain([&tasks](task_handler_base *h) { tasks.push_back(h); });
+        resume_workers();
+    }
+
+    const error_code e = operation_aborted_error();
+    for (task_handler_base *h : tasks) {
+        auto_destroy task(h);
+        queue_counts_.add(queue_removed);
+        cancel_pending_task(task.get(), e);
+    }
+    return tasks.size();
 }
 
 } // namespace detail
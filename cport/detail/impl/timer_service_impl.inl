@@ -0,0 +1,45 @@
+#ifndef __TIMER_SERVICE_IMPL_INL__
+#define __TIMER_SERVICE_IMPL_INL__
+
+//
+// timer_service_impl.inl
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+namespace cport {
+
+namespace detail {
+
+inline std::size_t timer_service_impl::pending_timers() const
+{
+    std::unique_lock<std::mutex> lock(guard_);
+    return wheel_.size();
+}
+
+inline std::uint64_t timer_service_impl::to_tick(const clock_type::time_point &tp) const
+{
+    if (tp <= start_)
+        return 0;
+
+    // Round up, so a timer never expires before its time point
+    const tick_type ticks = std::chrono::duration_cast<tick_type>(tp - start_);
+    return static_cast<std::uint64_t>(ticks.count())
+        + (start_ + ticks < tp ? 1 : 0);
+}
+
+inline void timer_service_impl::release_node(timer_node *n)
+{
+    n->handler = nullptr;
+    ++n->generation;
+    free_nodes_.push_back(n);
+}
+
+} // namespace detail
+
+} // namespace cport
+
+#endif // __TIMER_SERVICE_IMPL_INL__
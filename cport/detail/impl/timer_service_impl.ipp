@@ -0,0 +1,141 @@
+#ifndef __TIMER_SERVICE_IMPL_IPP__
+#define __TIMER_SERVICE_IMPL_IPP__
+
+//
+// timer_service_impl.ipp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/detail/timer_service_impl.hpp>
+#include <cport/detail/completion_port_impl.hpp>
+#include <cport/error_types.hpp>
+#include <algorithm>
+#include <limits>
+
+namespace cport {
+
+namespace detail {
+
+timer_service_impl::timer_service_impl(completion_port_impl &port)
+    : port_(port)
+    , start_(clock_type::now())
+    , wheel_(0)
+    , wake_tick_(std::numeric_limits<std::uint64_t>::max())
+    , stopped_(false)
+{
+    thread_ = std::thread(&timer_service_impl::thread_routine, this);
+}
+
+timer_service_impl::~timer_service_impl()
+{
+    std::vector<completion_handler_base *> canceled;
+    {
+        std::unique_lock<std::mutex> lock(guard_);
+        stopped_ = true;
+        cond_.notify_one();
+    }
+    thread_.join();
+
+    wheel_.clear([&](timer_node *n) {
+        canceled.push_back(n->handler);
+    });
+
+    const error_code e = operation_aborted_error();
+    for (completion_handler_base *h : canceled)
+        h->set_error(e);
+    port_.post(canceled.data(), canceled.size());
+}
+
+timer_handle timer_service_impl::schedule(completion_handler_base *h,
+    const clock_type::time_point &tp)
+{
+    std::unique_lock<std::mutex> lock(guard_);
+    timer_node *n = acquire_node();
+    n->expiry = to_tick(tp);
+    n->handler = h;
+    wheel_.insert(n);
+
+    // Wake the thread only if it sleeps past the new timer
+    if (std::max(n->expiry, wheel_.next()) < wake_tick_) {
+        wake_tick_ = 0;
+        cond_.notify_one();
+    }
+    return timer_handle(this, n, n->generation);
+}
+
+bool timer_service_impl::cancel(const timer_handle &t)
+{
+    // The node of another service is guarded by its mutex
+    if (!t || t.service_ != this)
+        return false;
+
+    std::unique_lock<std::mutex> lock(guard_);
+    timer_node *n = t.node_;
+    if (n->generation != t.generation_ || n->handler == nullptr)
+        return false;
+
+    wheel_.erase(n);
+    completion_handler_base *h = n->handler;
+    release_node(n);
+    lock.unlock();
+
+    h->set_error(operation_aborted_error());
+    port_.post(&h, 1);
+    return true;
+}
+
+timer_node* timer_service_impl::acquire_node()
+{
+    if (free_nodes_.empty()) {
+        const timer_node n = { nullptr, nullptr, 0, 0, nullptr };
+        nodes_.push_back(n);
+        return &nodes_.back();
+    }
+    timer_node *n = free_nodes_.back();
+    free_nodes_.pop_back();
+    return n;
+}
+
+void timer_service_impl::thread_routine()
+{
+    std::vector<completion_handler_base *> expired;
+
+    std::unique_lock<std::mutex> lock(guard_);
+    while (!stopped_) {
+        const tick_type now = std::chrono::duration_cast<tick_type>(
+            clock_type::now() - start_);
+        wheel_.advance(static_cast<std::uint64_t>(now.count()), [&](timer_node *n) {
+            expired.push_back(n->handler);
+            release_node(n);
+        });
+
+        if (!expired.empty()) {
+            lock.unlock();
+            port_.post(expired.data(), expired.size());
+            expired.clear();
+            lock.lock();
+            continue;
+        }
+
+        if (wheel_.size() == 0) {
+            wake_tick_ = std::numeric_limits<std::uint64_t>::max();
+            cond_.wait(lock);
+        }
+        else {
+            wake_tick_ = wheel_.next_event();
+            cond_.wait_until(lock, start_ + tick_type(
+                static_cast<tick_type::rep>(wake_tick_)));
+        }
+        wake_tick_ = 0;
+    }
+}
+
+} // namespace detail
+
+} // namespace cport
+
+#endif // __TIMER_SERVICE_IMPL_IPP__
@@ -0,0 +1,149 @@
+#ifndef __TRACE_DETAIL_IPP__
+#define __TRACE_DETAIL_IPP__
+
+//
+// trace.ipp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/detail/trace.hpp>
+#include <algorithm>
+#include <chrono>
+
+namespace cport {
+
+namespace detail {
+
+trace_buffer::trace_buffer(std::size_t capacity, std::size_t thread)
+    : mask_(capacity - 1)
+    , thread_(thread)
+    , events_(new event[capacity])
+    , head_(0)
+    , tail_(0)
+{
+}
+
+void trace_buffer::read(std::vector<record> &out) const
+{
+    const std::uint64_t capacity = mask_ + 1;
+    const std::uint64_t head = head_.load(std::memory_order_acquire);
+    const std::uint64_t first = std::max(tail_.load(std::memory_order_relaxed),
+        head > capacity ? head - capacity : 0);
+
+    const std::size_t size = out.size();
+    for (std::uint64_t i = first; i < head; ++i) {
+        const event &ev = events_[i & mask_];
+        record r;
+        r.time = ev.time.load(std::memory_order_relaxed);
+        r.id = ev.id.load(std::memory_order_relaxed);
+        r.type = static_cast<trace_event>(ev.type.load(std::memory_order_relaxed));
+        r.thread = thread_;
+        out.push_back(r);
+    }
+
+    // Drop the events the owner overwrote while they were copied
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const std::uint64_t last = head_.load(std::memory_order_relaxed);
+    if (last > capacity && last - capacity > first) {
+        const std::size_t overwritten = static_cast<std::size_t>(
+            std::min(last - capacity - first, head - first));
+        out.erase(out.begin() + size, out.begin() + size + overwritten);
+    }
+}
+
+trace_buffer& trace_registry::local_buffer()
+{
+    // The plain pointer avoids the initialization guard of the owner
+    static thread_local trace_buffer *buffer = nullptr;
+    if (buffer == nullptr) {
+        static thread_local const owner o;
+        buffer = o.buffer;
+    }
+    return *buffer;
+}
+
+trace_buffer* trace_registry::acquire()
+{
+    std::lock_guard<std::mutex> lock(guard_);
+    std::size_t capacity = 2;
+    while (capacity < capacity_)
+        capacity <<= 1;
+    const std::size_t thread = ++threads_;
+
+    if (retired_.size() >= retired_limit) {
+        trace_buffer *b = retired_.front();
+        retired_.pop_front();
+        if (b->capacity() == capacity) {
+            b->reuse(thread);
+            return b;
+        }
+        destroy(b);
+    }
+    buffers_.emplace_back(new trace_buffer(capacity, thread));
+    return buffers_.back().get();
+}
+
+void trace_registry::retire(trace_buffer *buffer)
+{
+    std::lock_guard<std::mutex> lock(guard_);
+    retired_.push_back(buffer);
+    if (retired_.size() > retired_limit) {
+        destroy(retired_.front());
+        retired_.pop_front();
+    }
+}
+
+void trace_registry::destroy(trace_buffer *buffer)
+{
+    for (auto i = buffers_.begin(); i != buffers_.end(); ++i) {
+        if (i->get() == buffer) {
+            buffers_.erase(i);
+            return;
+        }
+    }
+}
+
+void trace_registry::set_capacity(std::size_t capacity)
+{
+    std::lock_guard<std::mutex> lock(guard_);
+    capacity_ = capacity;
+}
+
+void trace_registry::clear()
+{
+    std::lock_guard<std::mutex> lock(guard_);
+    for (auto &b : buffers_)
+        b->clear();
+}
+
+std::vector<trace_buffer::record> trace_registry::read() const
+{
+    std::vector<trace_buffer::record> records;
+    {
+        std::lock_guard<std::mutex> lock(guard_);
+        for (auto &b : buffers_)
+            b->read(records);
+    }
+    std::stable_sort(records.begin(), records.end(),
+        [](const trace_buffer::record &a, const trace_buffer::record &b) {
+            return a.time < b.time;
+        });
+    return records;
+}
+
+void trace_record(trace_event e, std::uint64_t id)
+{
+    const std::uint64_t time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    trace_registry::instance().local_buffer().push(e, id, time);
+}
+
+} // namespace detail
+
+} // namespace cport
+
+#endif // __TRACE_DETAIL_IPP__
@@ -0,0 +1,117 @@
+#ifndef __IO_URING_BACKEND_HPP__
+#define __IO_URING_BACKEND_HPP__
+
+//
+// io_uring_backend.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/config.hpp>
+#include <cport/detail/file_service_impl.hpp>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace cport {
+
+namespace detail {
+
+// Executes requests through an io_uring instance, using the system calls
+//  directly. Submitting threads fill the submission queue under a lock and
+//  enter the kernel once per batch. A single thread reaps the completions,
+//  posts their handlers, refills the submission queue with the requests
+//  which did not fit in it and retries the entries the kernel refused with
+//  EAGAIN or EBUSY.
+class io_uring_backend : public file_backend {
+public:
+    // Throw std::system_error if io_uring or its read and write operations
+    //  are not available
+    CPORT_DECL_TYPE io_uring_backend(completion_port_impl &port,
+        unsigned entries);
+
+    CPORT_DECL_TYPE ~io_uring_backend();
+
+    CPORT_DECL_TYPE void submit(file_request *const *requests, std::size_t count);
+
+    CPORT_DECL_TYPE void register_buffers(const file_buffer *buffers,
+        std::size_t count);
+
+    CPORT_DECL_TYPE void unregister_buffers();
+
+    CPORT_DECL_TYPE void shutdown();
+
+private:
+    // Throw std::system_error if the kernel can not read or write.
+    CPORT_DECL_TYPE void probe();
+
+    // Move pending requests to the submission queue and submit them. The
+    //  handlers of the requests which failed to submit are appended to failed.
+    CPORT_DECL_TYPE void flush(std::vector<completion_handler_base *> &failed);
+
+    // Complete the entries not consumed by the kernel with the error.
+    CPORT_DECL_TYPE void fail_unsubmitted(int err,
+        std::vector<completion_handler_base *> &failed);
+
+    // Entries in the submission queue not consumed by the kernel yet.
+    CPORT_DECL_TYPE unsigned unsubmitted() const;
+
+    // Return 0 or the error of the call, EINTR is retried.
+    CPORT_DECL_TYPE int enter(unsigned to_submit, unsigned min_complete,
+        unsigned flags);
+
+    CPORT_DECL_TYPE void thread_routine();
+
+    CPORT_DECL_TYPE void unmap();
+
+    completion_port_impl &port_;
+    int ring_fd_;
+    unsigned sq_entries_;
+
+    void *sq_ring_;
+    std::size_t sq_ring_size_;
+    void *cq_ring_;
+    std::size_t cq_ring_size_;
+    io_uring_sqe *sqes_;
+    std::size_t sqes_size_;
+
+    unsigned *sq_head_;
+    unsigned *sq_tail_;
+    unsigned *sq_mask_;
+    unsigned *sq_array_;
+    unsigned *cq_head_;
+    unsigned *cq_tail_;
+    unsigned *cq_mask_;
+    io_uring_cqe *cqes_;
+
+    std::mutex guard_;
+    // Signalled when the last request in flight completes
+    std::condition_variable drained_;
+    // Signalled when requests are added while the reaping thread is idle
+    std::condition_variable work_;
+    bool idle_;
+    // Requests which did not fit in the submission queue
+    std::deque<file_request *> pending_;
+    // Requests in the submission queue or executed by the kernel
+    std::size_t inflight_;
+    bool stopped_;
+    std::thread thread_;
+};
+
+} // namespace detail
+
+} // namespace cport
+
+#ifdef CPORT_HEADER_ONLY_LIB
+#include <cport/detail/impl/io_uring_backend.ipp>
+#endif//CPORT_HEADER_ONLY_LIB
+
+#endif // __IO_URING_BACKEND_HPP__
@@ -0,0 +1,177 @@
+#ifndef __MPMC_QUEUE_HPP__
+#define __MPMC_QUEUE_HPP__
+
+//
+// mpmc_queue.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/config.hpp>
+#include <cport/memory_resource.hpp>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+namespace cport {
+
+namespace detail {
+
+// Multi-producer multi-consumer FIFO of pointers.
+//
+// The fast path is a bounded lock-free ring (D. Vyukov's algorithm). When
+//  the ring is full the elements are appended to a mutex protected overflow
+//  list. While the overflow list is not empty all producers append to it,
+//  so the elements pushed by one thread are always popped in FIFO order.
+//  The ring and the overflow list are allocated from the memory resource.
+template <typename T>
+class mpmc_queue {
+public:
+    // The capacity of the ring is rounded up to a power of two.
+    explicit mpmc_queue(std::size_t capacity = 4096,
+        memory_resource &r = *get_default_resource())
+        : mask_(round_capacity(capacity) - 1)
+        , resource_(r)
+        , buffer_(static_cast<cell *>(r.allocate(sizeof(cell) * (mask_ + 1), alignof(cell))))
+        , enqueue_pos_(0)
+        , dequeue_pos_(0)
+        , overflow_size_(0)
+        , overflow_(resource_allocator<T *>(&r))
+    {
+        for (std::size_t i = 0; i <= mask_; ++i) {
+            new (&buffer_[i]) cell();
+            buffer_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~mpmc_queue()
+    {
+        // The cells are trivially destructible
+        resource_.deallocate(buffer_, sizeof(cell) * (mask_ + 1), alignof(cell));
+    }
+
+    mpmc_queue(const mpmc_queue&) = delete;
+
+    mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+    void push(T *value)
+    {
+        assert(value != nullptr);
+        if (overflow_size_.load(std::memory_order_acquire) == 0
+            && try_push_ring(value))
+            return;
+
+        std::lock_guard<std::mutex> lock(overflow_guard_);
+        overflow_.push_back(value);
+        overflow_size_.fetch_add(1, std::memory_order_release);
+    }
+
+    // Return nullptr if the queue is empty.
+    T* pop()
+    {
+        T *value = try_pop_ring();
+        if (value != nullptr
+            || overflow_size_.load(std::memory_order_acquire) == 0)
+            return value;
+
+        std::lock_guard<std::mutex> lock(overflow_guard_);
+        if (overflow_.empty())
+            return nullptr;
+
+        value = overflow_.front();
+        overflow_.pop_front();
+        overflow_size_.fetch_sub(1, std::memory_order_release);
+        return value;
+    }
+
+private:
+    static std::size_t round_capacity(std::size_t capacity)
+    {
+        std::size_t c = 2;
+        while (c < capacity)
+            c <<= 1;
+        return c;
+    }
+
+    bool try_push_ring(T *value)
+    {
+        cell *c = nullptr;
+        std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            c = &buffer_[pos & mask_];
+            const std::size_t seq = c->sequence.load(std::memory_order_acquire);
+            const std::intptr_t dif = static_cast<std::intptr_t>(seq)
+                - static_cast<std::intptr_t>(pos);
+            if (dif == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                        std::memory_order_relaxed))
+                    break;
+            }
+            else if (dif < 0) {
+                return false;
+            }
+            else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        c->value = value;
+        c->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    T* try_pop_ring()
+    {
+        cell *c = nullptr;
+        std::size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            c = &buffer_[pos & mask_];
+            const std::size_t seq = c->sequence.load(std::memory_order_acquire);
+            const std::intptr_t dif = static_cast<std::intptr_t>(seq)
+                - static_cast<std::intptr_t>(pos + 1);
+            if (dif == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1,
+                        std::memory_order_relaxed))
+                    break;
+            }
+            else if (dif < 0) {
+                return nullptr;
+            }
+            else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        T *value = c->value;
+        c->sequence.store(pos + mask_ + 1, std::memory_order_release);
+        return value;
+    }
+
+    struct cell {
+        std::atomic<std::size_t> sequence;
+        T *value;
+    };
+
+    typedef char cacheline_pad[CPORT_CACHELINE_SIZE];
+
+    const std::size_t mask_;
+    memory_resource &resource_;
+    cell *const buffer_;
+    cacheline_pad pad0_;
+    std::atomic<std::size_t> enqueue_pos_;
+    cacheline_pad pad1_;
+    std::atomic<std::size_t> dequeue_pos_;
+    cacheline_pad pad2_;
+    std::atomic<std::size_t> overflow_size_;
+    std::mutex overflow_guard_;
+    std::deque<T *, resource_allocator<T *>> overflow_;
+};
+
+} // namespace detail
+
+} // namespace cport
+
+#endif // __MPMC_QUEUE_HPP__
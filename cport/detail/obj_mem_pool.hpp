@@ -10,69 +10,474 @@
 // visit http://www.apache.org/licenses/ for more information.
 //
 
-#include <deque>
+#include <cport/config.hpp>
+#include <cport/detail/profiled_mutex.hpp>
+#include <atomic>
+#include <cstddef>
+#include <limits>
 #include <mutex>
+#include <new>
+#include <utility>
 #include <cassert>
 #ifndef CPORT_DISABLE_OBJ_MEMORY_POOL
+
+namespace cport {
+
+namespace detail {
+
+// A batch of free nodes, moved between the threads and a depot at once.
+struct magazine {
+    enum { capacity = CPORT_POOL_MAGAZINE_SIZE };
+
+    magazine()
+        : next(nullptr)
+        , count(0)
+    {
+    }
+
+    bool empty() const
+    {
+        return count == 0;
+    }
+
+    bool full() const
+    {
+        return count == capacity;
+    }
+
+    // The next magazine in a list of the depot
+    magazine *next;
+    std::size_t count;
+    void *objs[capacity];
+};
+
+// The magazines of one size class shared by all threads. The non-empty
+//  ones hold free nodes, the empty ones are kept for reuse.
+class magazine_depot {
+public:
+    magazine_depot()
+        : full_(nullptr)
+        , empty_(nullptr)
+        , nodes_(0)
+    {
+    }
+
+    magazine_depot(const magazine_depot&) = delete;
+
+    magazine_depot& operator=(const magazine_depot&) = delete;
+
+    ~magazine_depot()
+    {
+        while (magazine *m = pop(full_)) {
+            release(*m);
+            delete m;
+        }
+        while (magazine *m = pop(empty_))
+            delete m;
+    }
+
+    // Exchange the empty magazine m for a non-empty one.
+    //  Return false and keep m if there is none.
+    bool exchange_empty(magazine *&m)
+    {
+        std::lock_guard<mutex_type> lock(mutex_);
+        if (full_ == nullptr)
+            return false;
+        push(empty_, m);
+        m = pop(full_);
+        nodes_ -= m->count;
+        return true;
+    }
+
+    // Exchange the full magazine m for an empty one.
+    void exchange_full(magazine *&m)
+    {
+        std::unique_lock<mutex_type> lock(mutex_);
+        nodes_ += m->count;
+        push(full_, m);
+        m = pop(empty_);
+        lock.unlock();
+        if (m == nullptr)
+            m = new magazine();
+    }
+
+    // Take over a magazine of an exiting thread.
+    void put(magazine *m)
+    {
+        std::lock_guard<mutex_type> lock(mutex_);
+        nodes_ += m->count;
+        push(m->empty() ? empty_ : full_, m);
+    }
+
+    // Release the cached nodes. Return their number.
+    std::size_t trim()
+    {
+        std::unique_lock<mutex_type> lock(mutex_);
+        magazine *full = full_;
+        magazine *empty = empty_;
+        const std::size_t nodes = nodes_;
+        full_ = empty_ = nullptr;
+        nodes_ = 0;
+        lock.unlock();
+
+        while (magazine *m = pop(full)) {
+            release(*m);
+            delete m;
+        }
+        while (magazine *m = pop(empty))
+            delete m;
+        return nodes;
+    }
+
+    // Free the nodes of the magazine.
+    static void release(magazine &m)
+    {
+        for (std::size_t i = 0; i < m.count; ++i)
+            ::operator delete(m.objs[i]);
+        m.count = 0;
+    }
+
+private:
+    static void push(magazine *&head, magazine *m)
+    {
+        m->next = head;
+        head = m;
+    }
+
+    static magazine* pop(magazine *&head)
+    {
+        magazine *m = head;
+        if (m != nullptr)
+            head = m->next;
+        return m;
+    }
+
+    struct mutex_site {
+        static const char* name() { return "magazine_depot::mutex_"; }
+    };
+    typedef site_mutex<mutex_site> mutex_type;
+
+    mutex_type mutex_;
+    // The lists of the non-empty and the empty magazines
+    magazine *full_;
+    magazine *empty_;
+    std::size_t nodes_;
+};
+
+// The number of power of two sizes from min up to max.
+constexpr std::size_t count_size_classes(std::size_t min, std::size_t max)
+{
+    return min >= max ? 1 : 1 + count_size_classes(min * 2, max);
+}
+
+// The nodes of all pooled objects, grouped by size class.
+//
+// The sizes are rounded up to a power of two from min_node_size up to
+//  CPORT_POOL_MAX_NODE_SIZE, so the objects of all types of a class share
+//  the same nodes. The larger objects go directly to the heap. The freed
+//  nodes are cached in the magazines of the freeing thread, which are
+//  exchanged with the depot of the class when they become full or empty.
+//  Thus a warm pool serves objects without touching the heap or, most of
+//  the time, any lock.
+//
+// The bytes held by the objects are counted by each thread, the bytes
+//  taken from and returned to the heap are counted globally.
+class slab_allocator {
+public:
+    enum {
+        min_node_size = 64,
+        max_node_size = CPORT_POOL_MAX_NODE_SIZE
+    };
+
+    static slab_allocator& instance()
+    {
+        static slab_allocator allocator;
+        return allocator;
+    }
+
+    void* allocate(std::size_t size)
+    {
+        thread_cache &tc = local_cache();
+        void *p = nullptr;
+        const std::size_t c = size_class(size);
+        if (c < classes) {
+            size = class_size(c);
+            p = tc.get(c);
+            if (p == nullptr)
+                p = allocate_node(size);
+        }
+        else {
+            p = allocate_node(size);
+        }
+        tc.add_live(size);
+        return p;
+    }
+
+    void deallocate(void *p, std::size_t size)
+    {
+        thread_cache &tc = local_cache();
+        const std::size_t c = size_class(size);
+        if (c < classes) {
+            size = class_size(c);
+            tc.put(c, p);
+        }
+        else {
+            release_node(p, size);
+        }
+        tc.add_live(0 - size);
+    }
+
+    // Release all nodes cached in the depots and in the magazines of the
+    //  calling thread. Return the number of released bytes.
+    std::size_t trim()
+    {
+        std::size_t bytes = local_cache().flush();
+        for (std::size_t c = 0; c < classes; ++c) {
+            const std::size_t released = depots_[c].trim() * class_size(c);
+            depot_bytes_.fetch_sub(released);
+            footprint_.fetch_sub(released);
+            bytes += released;
+        }
+        return bytes;
+    }
+
+    // The bytes held by live objects.
+    std::size_t live_bytes() const
+    {
+        std::lock_guard<mutex_type> lock(caches_guard_);
+        std::size_t live = retired_live_;
+        for (const thread_cache *tc = caches_; tc != nullptr; tc = tc->next_)
+            live += tc->live_.load(std::memory_order_relaxed);
+        return live;
+    }
+
+    // The bytes taken from the heap and not yet returned.
+    std::size_t footprint() const
+    {
+        return footprint_.load();
+    }
+
+    std::size_t high_water_bytes() const
+    {
+        return high_water_.load();
+    }
+
+    // The bytes of the free nodes cached in the depots.
+    std::size_t depot_bytes() const
+    {
+        return depot_bytes_.load();
+    }
+
+    void set_cache_limit(std::size_t bytes)
+    {
+        cache_limit_.store(bytes);
+    }
+
+    std::size_t cache_limit() const
+    {
+        return cache_limit_.load();
+    }
+
+private:
+    enum { classes = count_size_classes(min_node_size, max_node_size) };
+
+    static std::size_t size_class(std::size_t size)
+    {
+        std::size_t c = 0;
+        for (std::size_t s = min_node_size; s < size && c < classes; s <<= 1)
+            ++c;
+        return c;
+    }
+
+    static std::size_t class_size(std::size_t c)
+    {
+        return std::size_t(min_node_size) << c;
+    }
+
+    // The magazines of one thread for each class. An object is freed to and
+    //  allocated from the loaded magazine. The previous one is used when the
+    //  loaded one is full or empty, so a thread alternating around a boundary
+    //  does not go to the depot each time.
+    class thread_cache {
+    public:
+        explicit thread_cache(slab_allocator &owner)
+            : owner_(owner)
+            , live_(0)
+            , next_(nullptr)
+        {
+            for (std::size_t c = 0; c < classes; ++c) {
+                loaded_[c] = new magazine();
+                previous_[c] = new magazine();
+            }
+            owner_.attach(this);
+        }
+
+        thread_cache(const thread_cache&) = delete;
+
+        thread_cache& operator=(const thread_cache&) = delete;
+
+        ~thread_cache()
+        {
+            for (std::size_t c = 0; c < classes; ++c) {
+                owner_.depot_bytes_.fetch_add(
+                    (loaded_[c]->count + previous_[c]->count) * class_size(c));
+                owner_.depots_[c].put(loaded_[c]);
+                owner_.depots_[c].put(previous_[c]);
+            }
+            owner_.detach(this);
+        }
+
+        // Return nullptr if neither the thread nor the depot has free nodes.
+        void* get(std::size_t c)
+        {
+            magazine *&loaded = loaded_[c];
+            if (loaded->empty()) {
+                magazine *&previous = previous_[c];
+                if (previous->empty()) {
+                    if (!owner_.depots_[c].exchange_empty(previous))
+                        return nullptr;
+                    owner_.depot_bytes_.fetch_sub(previous->count * class_size(c));
+                }
+                std::swap(loaded, previous);
+            }
+            return loaded->objs[--loaded->count];
+        }
+
+        void put(std::size_t c, void *p)
+        {
+            magazine *&loaded = loaded_[c];
+            if (loaded->full()) {
+                magazine *&previous = previous_[c];
+                if (previous->full()) {
+                    // Over the limit the nodes go back to the heap
+                    const std::size_t bytes = magazine::capacity * class_size(c);
+                    if (owner_.depot_bytes_.load() + bytes > owner_.cache_limit()) {
+                        magazine_depot::release(*previous);
+                        owner_.footprint_.fetch_sub(bytes);
+                    }
+                    else {
+                        owner_.depot_bytes_.fetch_add(bytes);
+                        owner_.depots_[c].exchange_full(previous);
+                    }
+                }
+                std::swap(loaded, previous);
+            }
+            loaded->objs[loaded->count++] = p;
+        }
+
+        void add_live(std::size_t bytes)
+        {
+            // Only this thread updates the counter
+            live_.store(live_.load(std::memory_order_relaxed) + bytes,
+                std::memory_order_relaxed);
+        }
+
+        // Release the nodes of the magazines. Return the released bytes.
+        std::size_t flush()
+        {
+            std::size_t bytes = 0;
+            for (std::size_t c = 0; c < classes; ++c) {
+                bytes += (loaded_[c]->count + previous_[c]->count) * class_size(c);
+                magazine_depot::release(*loaded_[c]);
+                magazine_depot::release(*previous_[c]);
+            }
+            owner_.footprint_.fetch_sub(bytes);
+            return bytes;
+        }
+
+    private:
+        friend class slab_allocator;
+
+        slab_allocator &owner_;
+        magazine *loaded_[classes];
+        magazine *previous_[classes];
+        // Wraps around when the objects are freed by other threads
+        std::atomic<std::size_t> live_;
+        thread_cache *next_;
+    };
+
+    slab_allocator()
+        : caches_(nullptr)
+        , retired_live_(0)
+        , depot_bytes_(0)
+        , footprint_(0)
+        , high_water_(0)
+        , cache_limit_(std::numeric_limits<std::size_t>::max())
+    {
+    }
+
+    thread_cache& local_cache()
+    {
+        static thread_local thread_cache cache(*this);
+        return cache;
+    }
+
+    void* allocate_node(std::size_t size)
+    {
+        void *p = ::operator new(size);
+        const std::size_t footprint = footprint_.fetch_add(size) + size;
+        std::size_t high = high_water_.load(std::memory_order_relaxed);
+        while (high < footprint && !high_water_.compare_exchange_weak(high, footprint))
+            ;
+        return p;
+    }
+
+    void release_node(void *p, std::size_t size)
+    {
+        ::operator delete(p);
+        footprint_.fetch_sub(size);
+    }
+
+    void attach(thread_cache *tc)
+    {
+        std::lock_guard<mutex_type> lock(caches_guard_);
+        tc->next_ = caches_;
+        caches_ = tc;
+    }
+
+    void detach(thread_cache *tc)
+    {
+        std::lock_guard<mutex_type> lock(caches_guard_);
+        retired_live_ += tc->live_.load(std::memory_order_relaxed);
+        thread_cache **p = &caches_;
+        while (*p != tc)
+            p = &(*p)->next_;
+        *p = tc->next_;
+    }
+
+    magazine_depot depots_[classes];
+    struct caches_guard_site {
+        static const char* name() { return "slab_allocator::caches_guard_"; }
+    };
+    typedef site_mutex<caches_guard_site> mutex_type;
+
+    mutable mutex_type caches_guard_;
+    thread_cache *caches_;
+    std::size_t retired_live_;
+    std::atomic<std::size_t> depot_bytes_;
+    std::atomic<std::size_t> footprint_;
+    std::atomic<std::size_t> high_water_;
+    std::atomic<std::size_t> cache_limit_;
+};
+
+} // namespace detail
+
+} // namespace cport
+
+// The objects of the class are stored in the nodes of the slab_allocator.
 #define DECLARE_OBJ_MEMORY_POOL(ClassType) \
-    private: \
-        class ClassType##Pool : private std::deque<void *> \
-        { \
-            std::mutex mutex_; \
-        public: \
-            ~ClassType##Pool() \
-            { \
-                while(!empty()) { \
-                    void *ptr = front(); \
-                    pop_front(); \
-                    ::operator delete(ptr); \
-                } \
-            } \
-            void* get(std::size_t size) \
-            { \
-                assert(sizeof(ClassType) == size); \
-                std::unique_lock<std::mutex> lock(mutex_); \
-                if (empty()) { \
-                    lock.unlock(); \
-                    return ::operator new(size); \
-                } \
-                void *p = front(); \
-                pop_front(); \
-                return p; \
-            } \
-            void push(void *p) \
-            { \
-                std::unique_lock<std::mutex> lock(mutex_); \
-                std::deque<void *>::push_back(p); \
-            } \
-        }; \
-        static ClassType##Pool mem_pool_; \
     public: \
         void* operator new(std::size_t size) \
         { \
-            return mem_pool_.get(size); \
+            return cport::detail::slab_allocator::instance().allocate(size); \
         } \
         \
         void operator delete(void *p) \
         { \
-            mem_pool_.push(p); \
+            cport::detail::slab_allocator::instance().deallocate(p, sizeof(ClassType)); \
         }
-
-#define IMPLEMENT_OBJ_MEMORY_POOL(Class) \
-    Class::Class##Pool Class::mem_pool_
-
-#define IMPLEMENT_OBJ_MEMORY_POOL_T1(Class, T) \
-    template <typename T> \
-    typename Class<T>::Class##Pool Class<T>::mem_pool_
-
-#define IMPLEMENT_OBJ_MEMORY_POOL_T2(Class, T1, T2) \
-    template <typename T1, typename T2> \
-    typename Class<T1, T2>::Class##Pool Class<T1, T2>::mem_pool_
 #else // CPORT_DISABLE_OBJ_MEMORY_POOL
 #define DECLARE_OBJ_MEMORY_POOL(ClassType)
-#define IMPLEMENT_OBJ_MEMORY_POOL(Class)
-#define IMPLEMENT_OBJ_MEMORY_POOL_T1(Class, T)
-#define IMPLEMENT_OBJ_MEMORY_POOL_T2(Class, T1, T2)
 #endif // CPORT_DISABLE_OBJ_MEMORY_POOL
 
 #endif //__OBJ_MEMORY_POOL_HPP__
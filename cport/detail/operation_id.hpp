@@ -11,12 +11,10 @@
 //
 
 #include <cstddef>
+#include <utility>
 #ifdef CPORT_ENABLE_TASK_STATUS
 #include <cport/completion_status.hpp>
-#include <cport/util/event.hpp>
-#include <atomic>
-#include <memory>
-#include <utility>
+#include <cport/detail/task_status.hpp>
 #endif
 
 namespace cport {
@@ -30,40 +28,67 @@ public:
     operation_id(value_type vt = value_type())
         : value_(vt)
 #ifdef CPORT_ENABLE_TASK_STATUS
-        , status_(new atomic_status(completion_status::none))
-        , completion_event_(new util::event())
+        // Only valid identifiers have a status block
+        , status_(vt != value_type() ? task_status_block::create() : nullptr)
 #endif
     {
     }
 
-    operation_id(const operation_id& op) = default;
+    operation_id(const operation_id& op)
+        : value_(op.value_)
+#ifdef CPORT_ENABLE_TASK_STATUS
+        , status_(op.status_)
+#endif
+    {
+#ifdef CPORT_ENABLE_TASK_STATUS
+        if (status_ != nullptr)
+            status_->add_ref();
+#endif
+    }
 
     operation_id(operation_id&& op)
         : value_(op.value_)
 #ifdef CPORT_ENABLE_TASK_STATUS
-        , status_(std::move(op.status_))
-        , completion_event_(std::move(op.completion_event_))
+        , status_(op.status_)
 #endif
     {
         op.value_ = value_type();
+#ifdef CPORT_ENABLE_TASK_STATUS
+        op.status_ = nullptr;
+#endif
     }
 
-    operation_id& operator=(const operation_id& op) = default;
+#ifdef CPORT_ENABLE_TASK_STATUS
+    ~operation_id()
+    {
+        if (status_ != nullptr)
+            status_->release();
+    }
+#endif
+
+    operation_id& operator=(const operation_id& op)
+    {
+        operation_id(op).swap(*this);
+        return *this;
+    }
 
     operation_id& operator=(operation_id&& op)
     {
         if (this != &op)
         {
-            value_ = op.value_;
-            op.value_ = value_type();
-#ifdef CPORT_ENABLE_TASK_STATUS
-            status_ = std::move(op.status_);
-            completion_event_ = std::move(op.completion_event_);
-#endif
+            operation_id(std::move(op)).swap(*this);
         }
         return *this;
     }
 
+    void swap(operation_id& op)
+    {
+        std::swap(value_, op.value_);
+#ifdef CPORT_ENABLE_TASK_STATUS
+        std::swap(status_, op.status_);
+#endif
+    }
+
     bool operator==(const operation_id& op) const
     {
         return value_ == op.value_;
@@ -91,22 +116,21 @@ public:
 #ifdef CPORT_ENABLE_TASK_STATUS
     completion_status get_status() const
     {
-        return status_->load();
+        return status_ != nullptr ? status_->get_status() : completion_status::none;
     }
 
-    void set_status(completion_status s)
+    // The status is shared by all copies of the identifier
+    void set_status(completion_status s) const
     {
-        status_->store(s);
-        if (completion_status::canceled == s
-            || completion_status::complete == s)
-        {
-            completion_event_->notify_all();
-        }
+        if (status_ != nullptr)
+            status_->set_status(s);
     }
 
-    void wait()
+    // Return at once for an invalid identifier
+    void wait() const
     {
-        completion_event_->wait();
+        if (status_ != nullptr)
+            status_->wait();
     }
 #endif
 
@@ -114,12 +138,7 @@ private:
     value_type value_;
 
 #ifdef CPORT_ENABLE_TASK_STATUS
-    typedef std::atomic<completion_status> atomic_status;
-    typedef std::shared_ptr<atomic_status> shared_atomic_status;
-    shared_atomic_status status_;
-
-    typedef std::shared_ptr<util::event> shared_event;
-    shared_event completion_event_;
+    task_status_block *status_;
 #endif
 };
 
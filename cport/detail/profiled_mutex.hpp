@@ -0,0 +1,171 @@
+#ifndef __PROFILED_MUTEX_HPP__
+#define __PROFILED_MUTEX_HPP__
+
+//
+// profiled_mutex.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/config.hpp>
+#include <cport/detail/sharded_counter.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace cport {
+
+namespace detail {
+
+// The lock statistics of all mutexes declared at one place of the library.
+//  The sites are linked in a global list when first used, and are never
+//  destroyed, so the mutexes of static objects could be profiled too.
+class lock_site {
+public:
+    enum {
+        acquisitions,
+        contended,
+        // In nanoseconds
+        wait_time,
+        hold_time,
+        counter_count
+    };
+
+    explicit lock_site(const char *name)
+        : name_(name)
+        , next_(head().load(std::memory_order_relaxed))
+    {
+        while (!head().compare_exchange_weak(next_, this,
+                std::memory_order_release, std::memory_order_relaxed))
+            ;
+    }
+
+    lock_site(const lock_site&) = delete;
+
+    lock_site& operator=(const lock_site&) = delete;
+
+    const char* name() const
+    {
+        return name_;
+    }
+
+    void add(std::size_t counter, std::uint64_t n)
+    {
+        counters_.add(counter, n);
+    }
+
+    std::uint64_t sum(std::size_t counter) const
+    {
+        return counters_.sum(counter);
+    }
+
+    static const lock_site* first()
+    {
+        return head().load(std::memory_order_acquire);
+    }
+
+    const lock_site* next() const
+    {
+        return next_;
+    }
+
+private:
+    static std::atomic<lock_site *>& head()
+    {
+        static std::atomic<lock_site *> site(nullptr);
+        return site;
+    }
+
+    const char *const name_;
+    lock_site *next_;
+    sharded_counters<counter_count> counters_;
+};
+
+// A mutex which accounts its acquisitions, the contended ones, the time
+//  spent waiting for it and the time it is held to the lock site Site.
+//  Site::name() names the site in the reports.
+template <typename Site>
+class profiled_mutex {
+public:
+    typedef std::chrono::steady_clock clock;
+
+    profiled_mutex() = default;
+
+    profiled_mutex(const profiled_mutex&) = delete;
+
+    profiled_mutex& operator=(const profiled_mutex&) = delete;
+
+    void lock()
+    {
+        lock_site &s = site();
+        if (!mutex_.try_lock()) {
+            const clock::time_point start = clock::now();
+            mutex_.lock();
+            acquired_ = clock::now();
+            s.add(lock_site::contended, 1);
+            s.add(lock_site::wait_time, elapsed(start, acquired_));
+        }
+        else {
+            acquired_ = clock::now();
+        }
+        s.add(lock_site::acquisitions, 1);
+    }
+
+    bool try_lock()
+    {
+        if (!mutex_.try_lock())
+            return false;
+        acquired_ = clock::now();
+        site().add(lock_site::acquisitions, 1);
+        return true;
+    }
+
+    void unlock()
+    {
+        const std::uint64_t held = elapsed(acquired_, clock::now());
+        mutex_.unlock();
+        site().add(lock_site::hold_time, held);
+    }
+
+private:
+    static lock_site& site()
+    {
+        static lock_site *const s = new lock_site(Site::name());
+        return *s;
+    }
+
+    static std::uint64_t elapsed(clock::time_point from, clock::time_point to)
+    {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count());
+    }
+
+    std::mutex mutex_;
+    // Written only by the owner of the mutex
+    clock::time_point acquired_;
+};
+
+// The mutex and the condition variable types of the lock site Site. They
+//  are plain std types unless the lock profiling is enabled.
+#ifdef CPORT_HAS_LOCK_PROFILING
+template <typename Site>
+using site_mutex = profiled_mutex<Site>;
+
+typedef std::condition_variable_any site_condition_variable;
+#else
+template <typename Site>
+using site_mutex = std::mutex;
+
+typedef std::condition_variable site_condition_variable;
+#endif // CPORT_HAS_LOCK_PROFILING
+
+} // namespace detail
+
+} // namespace cport
+
+#endif // __PROFILED_MUTEX_HPP__
@@ -0,0 +1,166 @@
+#ifndef __REACTOR_IMPL_HPP__
+#define __REACTOR_IMPL_HPP__
+
+//
+// reactor_impl.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/config.hpp>
+#include <cport/memory_resource.hpp>
+#include <cport/reactor_handle.hpp>
+#include <cport/error_types.hpp>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cport {
+
+namespace detail {
+
+class completion_handler_base;
+class completion_port_impl;
+class reactor_impl;
+
+// Creates a completion handler for each readiness of a persistent registration.
+class reactor_op {
+public:
+    virtual ~reactor_op()
+    {
+    }
+
+    // The created handler keeps the reactor and re-arms the registration
+    //  after it is invoked, unless r is null. It is allocated from the
+    //  resource.
+    virtual completion_handler_base* create(memory_resource &mr,
+        const std::shared_ptr<reactor_impl> &r, std::uint64_t id,
+        std::size_t seqno, const error_code &e) = 0;
+};
+
+template <typename Handler>
+class reactor_op_impl : public reactor_op {
+public:
+    explicit reactor_op_impl(Handler&& h);
+
+    explicit reactor_op_impl(const Handler& h);
+
+    completion_handler_base* create(memory_resource &mr,
+        const std::shared_ptr<reactor_impl> &r, std::uint64_t id,
+        std::size_t seqno, const error_code &e);
+
+private:
+    Handler handler_;
+};
+
+struct reactor_node {
+    int fd;
+    // EPOLLIN and/or EPOLLOUT
+    std::uint32_t events;
+    // Incremented each time the node is released, never 0
+    std::uint32_t generation;
+    // Registered in the epoll set and not yet reported
+    bool armed;
+    // A persistent registration canceled while its handler was posted,
+    //  aborted with abort_error when the handler returns
+    bool canceled;
+    error_code abort_error;
+    // The operation id held by the registration
+    std::size_t seqno;
+    // The handler of a one-shot registration
+    completion_handler_base *handler;
+    // The handler factory of a persistent registration
+    std::unique_ptr<reactor_op> op;
+};
+
+// Owns an epoll set and a thread that posts the handlers of the ready
+//  registrations to the port. Each registration is armed with EPOLLONESHOT,
+//  so it is reported once. A persistent one is re-armed after its handler
+//  is invoked, so its handler never runs concurrently with itself, not even
+//  with its aborted copy: a registration canceled, shut down or failed while
+//  its handler is posted is aborted when the handler returns. The posted
+//  handlers keep the reactor alive for that. If epoll_wait() fails the
+//  thread ends all registrations with the error and the later ones fail
+//  with it.
+class reactor_impl : public std::enable_shared_from_this<reactor_impl> {
+public:
+    enum { read_event = 1, write_event = 2 };
+
+    CPORT_DECL_TYPE explicit reactor_impl(completion_port_impl &port);
+
+    CPORT_DECL_TYPE ~reactor_impl();
+
+    reactor_impl(const reactor_impl&) = delete;
+
+    reactor_impl& operator=(const reactor_impl&) = delete;
+
+    // Called once, before the owner releases the reactor. Stops the thread
+    //  and posts all registrations with operation_aborted error.
+    CPORT_DECL_TYPE void shutdown();
+
+    template <typename Handler>
+    reactor_handle async_wait(int fd, int events, Handler&& h);
+
+    template <typename Handler>
+    reactor_handle watch(int fd, int events, Handler&& h);
+
+    CPORT_DECL_TYPE bool cancel(const reactor_handle &r);
+
+    // Called after the handler of a persistent registration returns.
+    CPORT_DECL_TYPE void rearm(std::uint64_t id);
+
+    std::size_t registrations() const;
+
+private:
+    CPORT_DECL_TYPE reactor_handle add(int fd, int events,
+        completion_handler_base *h, std::unique_ptr<reactor_op> op,
+        std::size_t seqno);
+
+    CPORT_DECL_TYPE reactor_node* find(std::uint64_t id);
+
+    CPORT_DECL_TYPE void release_node(std::uint64_t id);
+
+    // End all registrations with the error. The persistent ones with a
+    //  posted handler are aborted by rearm().
+    CPORT_DECL_TYPE void abort_all(const error_code &e,
+        std::vector<completion_handler_base *> &aborted);
+
+    // Return the handler to post for an aborted or failed registration
+    CPORT_DECL_TYPE completion_handler_base* abort_handler(
+        reactor_node &n, const error_code &e);
+
+    CPORT_DECL_TYPE void thread_routine();
+
+    static std::uint64_t make_id(std::size_t index, std::uint32_t generation);
+
+    completion_port_impl &port_;
+    int epoll_fd_;
+    // Interrupts epoll_wait() on shutdown, registered with id 0
+    int wake_fd_;
+    mutable std::mutex guard_;
+    bool stopped_;
+    // The error of epoll_wait() which ended the thread, 0 if none
+    int error_;
+    std::size_t registrations_;
+    // Nodes are never freed before the reactor, so identifiers stay safe
+    std::deque<reactor_node> nodes_;
+    std::vector<std::size_t> free_nodes_;
+    std::thread thread_;
+};
+
+} // namespace detail
+
+} // namespace cport
+
+#include <cport/detail/impl/reactor_impl.inl>
+#ifdef CPORT_HEADER_ONLY_LIB
+#include <cport/detail/impl/reactor_impl.ipp>
+#endif//CPORT_HEADER_ONLY_LIB
+
+#endif // __REACTOR_IMPL_HPP__
@@ -0,0 +1,106 @@
+#ifndef __RESOURCE_OBJ_HPP__
+#define __RESOURCE_OBJ_HPP__
+
+//
+// resource_obj.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/associated_allocator.hpp>
+#include <cport/memory_resource.hpp>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace cport {
+
+namespace detail {
+
+// Construct an object of type T in storage allocated from the resource.
+//  The object remembers the resource, to release the storage in destroy_obj().
+template <typename T, typename... Args>
+inline T* create_obj(memory_resource &r, Args&&... args)
+{
+    void *p = r.allocate(sizeof(T), alignof(T));
+    T *obj = nullptr;
+    try {
+        obj = new (p) T(std::forward<Args>(args)...);
+    }
+    catch (...) {
+        r.deallocate(p, sizeof(T), alignof(T));
+        throw;
+    }
+    obj->set_resource(&r);
+    return obj;
+}
+
+// Destroy an object created by create_obj().
+template <typename T>
+inline void destroy_obj(T *obj)
+{
+    memory_resource *r = obj->resource();
+    obj->~T();
+    r->deallocate(obj, sizeof(T), alignof(T));
+}
+
+// Create and destroy the object which stores a handler, with the allocator
+//  associated with the handler.
+template <typename Handler,
+    typename Allocator = typename associated_allocator<Handler>::type>
+struct handler_alloc {
+    template <typename T, typename... Args>
+    static T* create(memory_resource &, const Handler &h, Args&&... args)
+    {
+        typename rebind<T>::type a(associated_allocator<Handler>::get(h));
+        T *obj = std::allocator_traits<typename rebind<T>::type>::allocate(a, 1);
+        try {
+            new (obj) T(std::forward<Args>(args)...);
+        }
+        catch (...) {
+            std::allocator_traits<typename rebind<T>::type>::deallocate(a, obj, 1);
+            throw;
+        }
+        return obj;
+    }
+
+    // The allocator is copied from the stored handler before it is destroyed
+    template <typename T>
+    static void destroy(T *obj, const Handler &h)
+    {
+        typename rebind<T>::type a(associated_allocator<Handler>::get(h));
+        obj->~T();
+        std::allocator_traits<typename rebind<T>::type>::deallocate(a, obj, 1);
+    }
+
+private:
+    template <typename T>
+    struct rebind {
+        typedef typename std::allocator_traits<Allocator>::template rebind_alloc<T> type;
+    };
+};
+
+// Without an associated allocator the object is allocated from the resource
+template <typename Handler>
+struct handler_alloc<Handler, void> {
+    template <typename T, typename... Args>
+    static T* create(memory_resource &r, const Handler &, Args&&... args)
+    {
+        return create_obj<T>(r, std::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    static void destroy(T *obj, const Handler &)
+    {
+        destroy_obj(obj);
+    }
+};
+
+} // namespace detail
+
+} // namespace cport
+
+#endif // __RESOURCE_OBJ_HPP__
@@ -0,0 +1,159 @@
+#ifndef __SHARDED_COUNTER_HPP__
+#define __SHARDED_COUNTER_HPP__
+
+//
+// sharded_counter.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/config.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace cport {
+
+namespace detail {
+
+// Assigns the shards of the metric counters to threads. The first
+//  CPORT_METRICS_SHARDS - 1 shards are owned by one live thread each, and
+//  are given back when the thread exits. The threads beyond that share the
+//  last shard.
+class metrics_shard_registry {
+public:
+    enum {
+        shared_shard = CPORT_METRICS_SHARDS - 1,
+        no_shard = CPORT_METRICS_SHARDS
+    };
+
+    static std::size_t thread_shard()
+    {
+        // The plain index avoids the initialization guard of the owner
+        static thread_local std::size_t shard = no_shard;
+        if (shard == no_shard) {
+            static thread_local const owner o;
+            shard = o.shard;
+        }
+        return shard;
+    }
+
+private:
+    struct owner {
+        owner()
+            : shard(instance().acquire())
+        {
+        }
+
+        ~owner()
+        {
+            instance().release(shard);
+        }
+
+        const std::size_t shard;
+    };
+
+    metrics_shard_registry()
+    {
+        for (std::size_t i = 0; i < shared_shard; ++i)
+            used_[i] = false;
+    }
+
+    static metrics_shard_registry& instance()
+    {
+        static metrics_shard_registry registry;
+        return registry;
+    }
+
+    std::size_t acquire()
+    {
+        std::lock_guard<std::mutex> lock(guard_);
+        for (std::size_t i = 0; i < shared_shard; ++i) {
+            if (!used_[i]) {
+                used_[i] = true;
+                return i;
+            }
+        }
+        return shared_shard;
+    }
+
+    void release(std::size_t shard)
+    {
+        if (shard == shared_shard)
+            return;
+        std::lock_guard<std::mutex> lock(guard_);
+        used_[shard] = false;
+    }
+
+    std::mutex guard_;
+    bool used_[shared_shard + 1];
+};
+
+// A set of Count monotonic counters, split in shards to avoid contention.
+//
+// A thread adds to the shard it owns with a relaxed load and store, and
+//  only the threads sharing the last shard use atomic read-modify-write.
+//  All counters of a shard share its cache lines, so a thread updating
+//  several counters touches a single line. Reading a counter sums all
+//  shards; the result is exact only when no thread is adding to it.
+template <std::size_t Count>
+class sharded_counters {
+public:
+    sharded_counters()
+    {
+        for (std::size_t s = 0; s < CPORT_METRICS_SHARDS; ++s)
+            for (std::size_t c = 0; c < Count; ++c)
+                shards_[s].values[c].store(0, std::memory_order_relaxed);
+    }
+
+    sharded_counters(const sharded_counters&) = delete;
+
+    sharded_counters& operator=(const sharded_counters&) = delete;
+
+    void add(std::size_t counter, std::uint64_t n = 1)
+    {
+        const std::size_t s = metrics_shard_registry::thread_shard();
+        std::atomic<std::uint64_t> &value = shards_[s].values[counter];
+        if (s != metrics_shard_registry::shared_shard)
+            value.store(value.load(std::memory_order_relaxed) + n,
+                std::memory_order_relaxed);
+        else
+            value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    std::uint64_t sum(std::size_t counter) const
+    {
+        std::uint64_t value = 0;
+        for (std::size_t s = 0; s < CPORT_METRICS_SHARDS; ++s)
+            value += shards_[s].values[counter].load(std::memory_order_relaxed);
+        return value;
+    }
+
+private:
+    struct shard {
+        std::atomic<std::uint64_t> values[Count];
+        char pad[CPORT_CACHELINE_SIZE];
+    };
+
+    shard shards_[CPORT_METRICS_SHARDS];
+};
+
+// Raise the high-water mark to value. Only the threads which raise it
+//  write to the shared cache line.
+inline void update_high_water(std::atomic<std::size_t> &mark, std::size_t value)
+{
+    std::size_t current = mark.load(std::memory_order_relaxed);
+    while (value > current
+        && !mark.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        ;
+}
+
+} // namespace detail
+
+} // namespace cport
+
+#endif // __SHARDED_COUNTER_HPP__
@@ -12,32 +12,75 @@
 
 #include <cport/error_types.hpp>
 #include <cport/detail/completion_port_impl.hpp>
-#include <cport/detail/obj_mem_pool.hpp>
+#include <cport/detail/resource_obj.hpp>
 #include <cport/detail/task_handler_base.hpp>
+#include <cport/detail/trace.hpp>
 
 namespace cport {
 
 namespace detail {
 
+// Wraps the completion handler of a task, to record the delay from it
+//  being posted to it being invoked and to trace the invocation.
+template <typename Handler>
+class task_completion {
+public:
+    task_completion(const Handler &h, completion_port_impl &port, std::size_t id)
+        : handler_(h)
+        , id_(id)
+#ifdef CPORT_HAS_METRICS
+        , latency_(&port.task_completion_latency())
+        , posted_(std::chrono::steady_clock::now())
+#endif // CPORT_HAS_METRICS
+    {
+        (void)port;
+    }
+
+    template <typename... Args>
+    void operator()(Args&&... args)
+    {
+#ifdef CPORT_HAS_METRICS
+        latency_->record(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - posted_));
+#endif // CPORT_HAS_METRICS
+        struct trace_guard {
+            std::size_t id;
+            ~trace_guard()
+            {
+                trace(trace_event::completion_end, id);
+            }
+        };
+        trace(trace_event::completion_begin, id_);
+        trace_guard guard = { id_ };
+        handler_(std::forward<Args>(args)...);
+    }
+
+    const Handler& handler() const
+    {
+        return handler_;
+    }
+
+private:
+    Handler handler_;
+    std::size_t id_;
+#ifdef CPORT_HAS_METRICS
+    concurrent_histogram *latency_;
+    std::chrono::steady_clock::time_point posted_;
+#endif // CPORT_HAS_METRICS
+};
+
 template <typename TaskHandlerType, typename CompletionHandlerType>
 class task_handler : public task_handler_base {
-    DECLARE_OBJ_MEMORY_POOL(task_handler)
 public:
     task_handler(const TaskHandlerType& op, const CompletionHandlerType& c, const operation_id& id)
-        : task_handler_base(id,
-            task_handler::execute_,
-            task_handler::post_complete_,
-            task_handler::destroy_)
+        : task_handler_base(id, &table_)
         , taskHandler_(op)
         , completionHandler_(c)
     {
     }
 
     task_handler(TaskHandlerType&& op, CompletionHandlerType&& c, const operation_id& id)
-        : task_handler_base(id,
-            task_handler::execute_,
-            task_handler::post_complete_,
-            task_handler::destroy_)
+        : task_handler_base(id, &table_)
         , taskHandler_(std::move(op))
         , completionHandler_(std::move(c))
     {
@@ -52,13 +95,20 @@ public:
     {
         generic_error e;
         taskHandler_(e);
-        post_complete(port, e);
+        // Only a failed task copies its error to the completion handler
+        post_complete(port, e ? error_code(e) : error_code());
     }
 
     template <typename CompletionPort>
-    void post_complete(CompletionPort &port, const generic_error &e)
+    void post_complete(CompletionPort &port, const error_code &e)
     {
+        trace(trace_event::post_complete, id());
+#if defined(CPORT_HAS_METRICS) || defined(CPORT_HAS_TRACING)
+        port.post(task_completion<CompletionHandlerType>(completionHandler_,
+            port, id()), id(), e);
+#else
         port.post(completionHandler_, id(), e);
+#endif
     }
    
 private:
@@ -67,7 +117,9 @@ private:
     static void destroy_(destroyable_obj *base)
     {
         assert(base != nullptr);
-        delete static_cast<this_type *>(base);
+        this_type *h = static_cast<this_type *>(base);
+        handler_alloc<typename std::decay<CompletionHandlerType>::type>::destroy(
+            h, h->completionHandler_);
     }
 
     static void execute_(completion_port_impl &port, task_handler_base *base)
@@ -77,32 +129,54 @@ private:
     }
 
     static void post_complete_(completion_port_impl &port,
-        task_handler_base *base, const generic_error &e)
+        task_handler_base *base, const error_code &e)
     {
         assert(base != nullptr);
         static_cast<this_type *>(base)->post_complete(port, e);
     }
 
+    static const vtable_type table_;
+
     TaskHandlerType taskHandler_;
     CompletionHandlerType completionHandler_;
 };
 
-IMPLEMENT_OBJ_MEMORY_POOL_T2(task_handler, TH, CH);
+template <typename TaskHandlerType, typename CompletionHandlerType>
+const task_handler_base::vtable_type
+task_handler<TaskHandlerType, CompletionHandlerType>::table_ = {
+    { &task_handler<TaskHandlerType, CompletionHandlerType>::destroy_ },
+    &task_handler<TaskHandlerType, CompletionHandlerType>::execute_,
+    &task_handler<TaskHandlerType, CompletionHandlerType>::post_complete_
+};
 
 template <typename taskhandlertype, typename completionhandlertype>
 inline task_handler<typename std::remove_reference<taskhandlertype>::type,
     typename std::remove_reference<completionhandlertype>::type>*
-create_task_handler(taskhandlertype&& th, completionhandlertype&& ch, const operation_id& id)
+create_task_handler(memory_resource &r, taskhandlertype&& th,
+    completionhandlertype&& ch, const operation_id& id)
 {
-    return new task_handler<typename std::remove_reference<taskhandlertype>::type,
-        typename std::remove_reference<completionhandlertype>::type>(
-            std::forward<taskhandlertype>(th),
+    // The node is allocated with the allocator of the completion handler
+    return handler_alloc<typename std::decay<completionhandlertype>::type>::template create<
+        task_handler<typename std::remove_reference<taskhandlertype>::type,
+            typename std::remove_reference<completionhandlertype>::type>>(
+            r, ch, std::forward<taskhandlertype>(th),
             std::forward<completionhandlertype>(ch),
             id);
 }
 
 } // namespace detail
 
+// The completion handler keeps its associated allocator when it is wrapped
+template <typename Handler>
+struct associated_allocator<detail::task_completion<Handler>, void> {
+    typedef typename associated_allocator<Handler>::type type;
+
+    static type get(const detail::task_completion<Handler> &h)
+    {
+        return associated_allocator<Handler>::get(h.handler());
+    }
+};
+
 } // namespace cport
 
 #endif // __TASK_HANDLER_HPP__
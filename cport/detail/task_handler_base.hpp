@@ -10,49 +10,59 @@
 // visit http://www.apache.org/licenses/ for more information.
 //
 
+#include <cport/config.hpp>
 #include <cport/detail/destroyable_obj.hpp>
 #include <cport/detail/operation_id.hpp>
+#include <chrono>
 
 namespace cport {
 
-class generic_error;
+class error_code;
 
 namespace detail {
 
 class completion_port_impl;
 class task_handler_base : public destroyable_obj {
-    typedef std::function<
-        void(completion_port_impl &port,
-             task_handler_base *)> invoke_helper_type;
-
-    typedef std::function<
-        void(completion_port_impl &port,
-             task_handler_base *,
-             const generic_error &)> complete_helper_type;
 public:
+    // One static table per task handler type
+    struct vtable_type {
+        destroyable_obj::vtable_type destroyable;
+        void (*execute)(completion_port_impl &, task_handler_base *);
+        void (*post_complete)(completion_port_impl &, task_handler_base *,
+            const error_code &);
+    };
+
     void execute(completion_port_impl &port)
     {
-        invoke_helper_(port, this);
+        table()->execute(port, this);
     }
 
-    void post_complete(completion_port_impl &port, const generic_error &e)
+    void post_complete(completion_port_impl &port, const error_code &e)
     {
-        complete_helper_(port, this, e);
+        table()->post_complete(port, this, e);
     }
 
-    operation_id id() const
+    const operation_id& id() const
     {
         return id_;
     }
+
+#ifdef CPORT_HAS_METRICS
+    // The time the task was enqueued to the scheduler
+    std::chrono::steady_clock::time_point enqueued() const
+    {
+        return enqueued_;
+    }
+
+    void set_enqueued(const std::chrono::steady_clock::time_point &t)
+    {
+        enqueued_ = t;
+    }
+#endif // CPORT_HAS_METRICS
 protected:
-    task_handler_base(operation_id id,
-        invoke_helper_type invoke_helper,
-        complete_helper_type complete_helper,
-        destroy_helper_type destroy_helper)
-        : destroyable_obj(destroy_helper)
+    task_handler_base(operation_id id, const vtable_type *vtable)
+        : destroyable_obj(&vtable->destroyable)
         , id_(id)
-        , invoke_helper_(invoke_helper)
-        , complete_helper_(complete_helper)
     {
     }
 
@@ -61,9 +71,16 @@ protected:
     }
 
 private:
+    const vtable_type* table() const
+    {
+        // The table of the destroyable base is the first member of vtable_type
+        return reinterpret_cast<const vtable_type *>(vtable());
+    }
+
     operation_id id_;
-    invoke_helper_type invoke_helper_;
-    complete_helper_type complete_helper_;
+#ifdef CPORT_HAS_METRICS
+    std::chrono::steady_clock::time_point enqueued_;
+#endif // CPORT_HAS_METRICS
 };
 
 } // namespace detail
@@ -12,12 +12,23 @@
 
 #include <cport/config.hpp>
 #include <cport/error_types.hpp>
+#include <cport/memory_resource.hpp>
+#include <cport/metrics.hpp>
+#include <cport/scheduling_policy.hpp>
 #include <cport/task_t.hpp>
+#include <cport/wait_policy.hpp>
+#include <cport/detail/adaptive_wait.hpp>
+#include <cport/detail/chase_lev_deque.hpp>
+#include <cport/detail/concurrent_histogram.hpp>
+#include <cport/detail/profiled_mutex.hpp>
+#include <cport/detail/sharded_counter.hpp>
 #include <cport/detail/task_handler.hpp>
 #include <cport/util/thread_group.hpp>
 #include <type_traits>
 #include <condition_variable>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <deque>
 #include <functional>
 #include <memory>
@@ -37,9 +48,13 @@ public:
 
     typedef std::function<void(worker_func_prototype)> worker_context_prototype;
 
+    // Task handlers are allocated from the resource, or from the resource
+    //  of the port if r is nullptr.
     CPORT_DECL_TYPE task_scheduler_impl(completion_port_impl &port
         , std::size_t concurrency_hint
-        , worker_context_prototype wcp);
+        , worker_context_prototype wcp
+        , memory_resource *r = nullptr
+        , scheduling_policy policy = scheduling_policy::shared_queue);
 
     CPORT_DECL_TYPE ~task_scheduler_impl();
 
@@ -52,13 +67,51 @@ public:
 
     std::size_t packaged_tasks() const;
 
+    void set_wait_policy(const wait_policy &wp);
+
+    wait_policy get_wait_policy() const;
+
+    wait_stats get_wait_stats() const;
+
+    CPORT_DECL_TYPE scheduler_metrics snapshot() const;
+
+    CPORT_DECL_TYPE task_latency latency() const;
+
     void enqueue_task(task_handler_base *h);
 
     completion_port_impl& get_completion_port();
 
+    memory_resource& resource() const;
+
+    scheduling_policy policy() const;
+
 private:
+    // The deque of a worker of the work_stealing policy
+    struct worker_state {
+        worker_state(std::size_t i, memory_resource &r)
+            : index(i)
+            , tasks(256, r)
+            , busy(false)
+        {
+        }
+
+        const std::size_t index;
+        chase_lev_deque<task_handler_base> tasks;
+        // Set while the worker uses the deques, see pause_workers()
+        std::atomic<bool> busy;
+        char pad[CPORT_CACHELINE_SIZE];
+    };
+
+    // The worker run by the calling thread, if any
+    struct worker_slot {
+        const task_scheduler_impl *scheduler;
+        worker_state *worker;
+    };
+
+    CPORT_DECL_TYPE static worker_slot& current_worker();
+
     void cancel_pending_task(task_handler_base *h
-        , const generic_error &e = operation_aborted_error());
+        , const error_code &e = operation_aborted_error());
     
     CPORT_DECL_TYPE void cancel_pending_tasks();
 
@@ -70,12 +123,88 @@ private:
 
     CPORT_DECL_TYPE void thread_routine_loop();
 
+    CPORT_DECL_TYPE void work_stealing_loop();
+
+    // Execute the task, accounting the time since idle_since as idle
+    CPORT_DECL_TYPE void execute_task(task_handler_base *task
+        , std::chrono::steady_clock::time_point &idle_since);
+
+    CPORT_DECL_TYPE void push_task(task_handler_base *h);
+
+    // Take a task from the own deque, the injection queue or the deque
+    //  of another worker
+    CPORT_DECL_TYPE task_handler_base* take_task(worker_state &w);
+
+    CPORT_DECL_TYPE task_handler_base* take_injected_tasks(worker_state &w);
+
+    CPORT_DECL_TYPE task_handler_base* steal_task(worker_state &w);
+
+    CPORT_DECL_TYPE bool has_tasks() const;
+
+    void enter_queues(worker_state &w);
+
+    void leave_queues(worker_state &w);
+
+    // Wait until no worker uses the deques, and keep them from using the
+    //  deques until resume_workers() is called
+    CPORT_DECL_TYPE void pause_workers();
+
+    void resume_workers();
+
+    CPORT_DECL_TYPE bool cancel_stealable(const task_t &task);
+
+    CPORT_DECL_TYPE std::size_t cancel_all_stealable();
+
     completion_port_impl &port_;
+    memory_resource &resource_;
     util::thread_group threads_;
-    mutable std::mutex guard_;
-    std::deque<task_handler_base *> pending_tasks_;
-    std::condition_variable cond_;
-    bool threads_stopped_;
+    struct guard_site {
+        static const char* name() { return "task_scheduler_impl::guard_"; }
+    };
+    typedef site_mutex<guard_site> mutex_type;
+    mutable mutex_type guard_;
+    // All tasks of the shared_queue policy, or the injection queue of
+    //  the work_stealing policy
+    std::deque<task_handler_base *, resource_allocator<task_handler_base *>> pending_tasks_;
+    // Mirrors pending_tasks_.size(), so idle workers can poll it unlocked
+    std::atomic<std::size_t> pending_count_;
+    site_condition_variable cond_;
+    std::atomic<bool> threads_stopped_;
+    adaptive_wait waiter_;
+
+    const scheduling_policy policy_;
+    // Empty for the shared_queue policy
+    std::vector<std::unique_ptr<worker_state>> workers_;
+    std::atomic<std::size_t> next_worker_;
+    // Workers blocked on cond_
+    std::atomic<std::size_t> sleepers_;
+    std::atomic<bool> paused_;
+    struct cancel_guard_site {
+        static const char* name() { return "task_scheduler_impl::cancel_guard_"; }
+    };
+    // Serializes the pauses of the workers
+    site_mutex<cancel_guard_site> cancel_guard_;
+    enum {
+        queue_pushed,
+        queue_removed,
+        queue_count
+    };
+    // The tasks of the work_stealing policy are the pushed less the removed
+    sharded_counters<queue_count> queue_counts_;
+
+    enum {
+        metric_enqueued,
+        metric_executed,
+        metric_canceled,
+        // In nanoseconds
+        metric_busy_time,
+        metric_idle_time,
+        metric_count
+    };
+    sharded_counters<metric_count> metrics_;
+    std::atomic<std::size_t> pending_high_water_;
+    concurrent_histogram queueing_latency_;
+    concurrent_histogram execution_latency_;
 };
 
 } // namespace detail
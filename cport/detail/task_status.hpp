@@ -0,0 +1,106 @@
+#ifndef __TASK_STATUS_HPP__
+#define __TASK_STATUS_HPP__
+
+//
+// task_status.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/completion_status.hpp>
+#include <cport/detail/futex.hpp>
+#include <cport/detail/obj_mem_pool.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace cport {
+
+namespace detail {
+
+// The status of a task, shared by the copies of its operation id.
+//
+// A single state word holds the completion status and a flag telling
+//  that threads are blocked on it. The blocks are reference counted
+//  intrusively and stored in the pooled nodes.
+class task_status_block {
+    DECLARE_OBJ_MEMORY_POOL(task_status_block)
+public:
+    static task_status_block* create()
+    {
+        return new task_status_block();
+    }
+
+    void add_ref()
+    {
+        refs_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void release()
+    {
+        if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete this;
+    }
+
+    completion_status get_status() const
+    {
+        return static_cast<completion_status>(
+            state_.load(std::memory_order_acquire) & status_mask);
+    }
+
+    void set_status(completion_status s)
+    {
+        std::uint32_t state = state_.load(std::memory_order_relaxed);
+        while (!state_.compare_exchange_weak(state,
+            static_cast<std::uint32_t>(s) | (state & waiters),
+            std::memory_order_acq_rel, std::memory_order_relaxed))
+            ;
+        if (is_final(s) && (state & waiters) != 0)
+            futex_wake_all(state_);
+    }
+
+    void wait()
+    {
+        std::uint32_t state = state_.load(std::memory_order_acquire);
+        while (!is_final(static_cast<completion_status>(state & status_mask))) {
+            if ((state & waiters) == 0) {
+                if (!state_.compare_exchange_weak(state, state | waiters,
+                    std::memory_order_acq_rel, std::memory_order_acquire))
+                    continue;
+                state |= waiters;
+            }
+            futex_wait(state_, state);
+            state = state_.load(std::memory_order_acquire);
+        }
+    }
+
+private:
+    enum : std::uint32_t {
+        status_mask = 0xFF,
+        waiters = 0x100
+    };
+
+    task_status_block()
+        : refs_(1)
+        , state_(static_cast<std::uint32_t>(completion_status::none))
+    {
+    }
+
+    static bool is_final(completion_status s)
+    {
+        return completion_status::canceled == s
+            || completion_status::complete == s;
+    }
+
+    std::atomic<std::uint32_t> refs_;
+    std::atomic<std::uint32_t> state_;
+};
+
+} // namespace detail
+
+} // namespace cport
+
+#endif // __TASK_STATUS_HPP__
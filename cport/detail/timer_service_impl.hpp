@@ -0,0 +1,86 @@
+#ifndef __TIMER_SERVICE_IMPL_HPP__
+#define __TIMER_SERVICE_IMPL_HPP__
+
+//
+// timer_service_impl.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/config.hpp>
+#include <cport/timer_handle.hpp>
+#include <cport/detail/timer_wheel.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cport {
+
+namespace detail {
+
+class completion_handler_base;
+class completion_port_impl;
+
+// Owns a timing wheel and a thread that posts the handlers of the expired
+//  timers to the port. The wheel advances in ticks of one millisecond.
+class timer_service_impl {
+public:
+    typedef std::chrono::steady_clock clock_type;
+
+    typedef std::chrono::milliseconds tick_type;
+
+    CPORT_DECL_TYPE explicit timer_service_impl(completion_port_impl &port);
+
+    // Cancel all pending timers and stop the thread.
+    CPORT_DECL_TYPE ~timer_service_impl();
+
+    timer_service_impl(const timer_service_impl&) = delete;
+
+    timer_service_impl& operator=(const timer_service_impl&) = delete;
+
+    CPORT_DECL_TYPE timer_handle schedule(completion_handler_base *h,
+        const clock_type::time_point &tp);
+
+    CPORT_DECL_TYPE bool cancel(const timer_handle &t);
+
+    std::size_t pending_timers() const;
+
+private:
+    std::uint64_t to_tick(const clock_type::time_point &tp) const;
+
+    CPORT_DECL_TYPE timer_node* acquire_node();
+
+    void release_node(timer_node *n);
+
+    CPORT_DECL_TYPE void thread_routine();
+
+    completion_port_impl &port_;
+    const clock_type::time_point start_;
+    mutable std::mutex guard_;
+    std::condition_variable cond_;
+    timer_wheel wheel_;
+    // The tick the thread sleeps until
+    std::uint64_t wake_tick_;
+    bool stopped_;
+    // Nodes are never freed before the service, so handles stay safe
+    std::deque<timer_node> nodes_;
+    std::vector<timer_node *> free_nodes_;
+    std::thread thread_;
+};
+
+} // namespace detail
+
+} // namespace cport
+
+#include <cport/detail/impl/timer_service_impl.inl>
+#ifdef CPORT_HEADER_ONLY_LIB
+#include <cport/detail/impl/timer_service_impl.ipp>
+#endif//CPORT_HEADER_ONLY_LIB
+
+#endif // __TIMER_SERVICE_IMPL_HPP__
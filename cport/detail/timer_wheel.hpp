@@ -0,0 +1,285 @@
+#ifndef __TIMER_WHEEL_HPP__
+#define __TIMER_WHEEL_HPP__
+
+//
+// timer_wheel.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace cport {
+
+namespace detail {
+
+class completion_handler_base;
+
+struct timer_node {
+    timer_node *prev;
+    timer_node *next;
+    // The tick at which the timer expires
+    std::uint64_t expiry;
+    // Incremented each time the node is released, to invalidate the handles
+    std::size_t generation;
+    // The handler to post when the timer expires. nullptr if not armed.
+    completion_handler_base *handler;
+};
+
+// A hierarchical timing wheel with O(1) insert and erase.
+//
+// The root level has 256 slots of one tick each. Each of the four upper
+//  levels has 64 slots, each slot spanning the whole level below it. When
+//  the root level wraps, the current slot of the next level is cascaded
+//  into the lower levels. Timers further than 2^32 ticks are parked in the
+//  last level and re-inserted until they are due.
+class timer_wheel {
+public:
+    explicit timer_wheel(std::uint64_t tick = 0)
+        : next_(tick)
+        , size_(0)
+    {
+        for (std::size_t i = 0; i < root_slots; ++i)
+            init(root_[i]);
+        for (std::size_t l = 0; l < levels; ++l)
+            for (std::size_t i = 0; i < level_slots; ++i)
+                init(wheel_[l][i]);
+    }
+
+    timer_wheel(const timer_wheel&) = delete;
+
+    timer_wheel& operator=(const timer_wheel&) = delete;
+
+    // The next tick to be processed by advance().
+    std::uint64_t next() const
+    {
+        return next_;
+    }
+
+    std::size_t size() const
+    {
+        return size_;
+    }
+
+    // Timers which are already due expire on the next processed tick.
+    void insert(timer_node *n)
+    {
+        link(n);
+        ++size_;
+    }
+
+    void erase(timer_node *n)
+    {
+        assert(size_ > 0);
+        unlink(n);
+        --size_;
+    }
+
+    // Process all ticks up to and including tick, calling f for each
+    //  expired node. The node is already removed when f is called.
+    template <typename Func>
+    void advance(std::uint64_t tick, Func f)
+    {
+        if (size_ == 0) {
+            if (tick >= next_)
+                next_ = tick + 1;
+            return;
+        }
+
+        while (next_ <= tick) {
+            // Skip the ticks with nothing to expire or cascade
+            const std::uint64_t event = next_event();
+            if (event > next_) {
+                next_ = std::min(event, tick + 1);
+                continue;
+            }
+
+            const std::size_t index = next_ & root_mask;
+            if (index == 0) {
+                for (std::size_t l = 0; l < levels; ++l) {
+                    if (cascade(l, level_index(l, next_)) != 0)
+                        break;
+                }
+            }
+            const std::uint64_t current = next_++;
+
+            timer_node list;
+            splice(root_[index], list);
+            while (list.next != &list) {
+                timer_node *n = list.next;
+                unlink(n);
+                if (n->expiry > current) {
+                    // Clamped timer, not yet due
+                    link(n);
+                }
+                else {
+                    --size_;
+                    f(n);
+                }
+            }
+        }
+    }
+
+    // Return the earliest tick at which advance() may expire a timer or
+    //  cascade a non-empty slot of an upper level.
+    std::uint64_t next_event() const
+    {
+        std::uint64_t event = std::numeric_limits<std::uint64_t>::max();
+
+        // The root level holds the timers due in the next root_slots ticks
+        for (std::uint64_t t = next_; t < next_ + root_slots; ++t) {
+            if (!empty(root_[t & root_mask])) {
+                event = t;
+                break;
+            }
+        }
+
+        // A slot of level l is cascaded when the lower bits of the tick are zero
+        for (std::size_t l = 0; l < levels; ++l) {
+            const unsigned shift = root_bits + l * level_bits;
+            const std::uint64_t step = std::uint64_t(1) << shift;
+            std::uint64_t t = ((next_ + step - 1) >> shift) << shift;
+            for (std::size_t j = 0; j < level_slots && t < event; ++j, t += step) {
+                if (!empty(wheel_[l][level_index(l, t)])) {
+                    event = t;
+                    break;
+                }
+            }
+        }
+        return event;
+    }
+
+    // Remove all nodes, calling f for each one.
+    template <typename Func>
+    void clear(Func f)
+    {
+        for (std::size_t i = 0; i < root_slots; ++i)
+            clear(root_[i], f);
+        for (std::size_t l = 0; l < levels; ++l)
+            for (std::size_t i = 0; i < level_slots; ++i)
+                clear(wheel_[l][i], f);
+    }
+
+private:
+    enum {
+        root_bits = 8,
+        level_bits = 6,
+        levels = 4,
+        root_slots = 1 << root_bits,
+        level_slots = 1 << level_bits,
+        root_mask = root_slots - 1,
+        level_mask = level_slots - 1
+    };
+
+    static void init(timer_node &head)
+    {
+        head.prev = head.next = &head;
+    }
+
+    static bool empty(const timer_node &head)
+    {
+        return head.next == &head;
+    }
+
+    static std::size_t level_index(std::size_t level, std::uint64_t tick)
+    {
+        return static_cast<std::size_t>(
+            (tick >> (root_bits + level * level_bits)) & level_mask);
+    }
+
+    static void push_back(timer_node &head, timer_node *n)
+    {
+        n->next = &head;
+        n->prev = head.prev;
+        head.prev->next = n;
+        head.prev = n;
+    }
+
+    // Move all nodes from the list head to the empty list to.
+    static void splice(timer_node &head, timer_node &to)
+    {
+        init(to);
+        if (head.next != &head) {
+            to.next = head.next;
+            to.prev = head.prev;
+            to.next->prev = &to;
+            to.prev->next = &to;
+            init(head);
+        }
+    }
+
+    static void unlink(timer_node *n)
+    {
+        n->prev->next = n->next;
+        n->next->prev = n->prev;
+        n->prev = n->next = nullptr;
+    }
+
+    void link(timer_node *n)
+    {
+        std::uint64_t expiry = n->expiry;
+        if (expiry < next_) {
+            push_back(root_[next_ & root_mask], n);
+            return;
+        }
+
+        std::uint64_t delta = expiry - next_;
+        if (delta < root_slots) {
+            push_back(root_[expiry & root_mask], n);
+            return;
+        }
+
+        for (std::size_t l = 0; l + 1 < levels; ++l) {
+            if (delta < (std::uint64_t(1) << (root_bits + (l + 1) * level_bits))) {
+                push_back(wheel_[l][level_index(l, expiry)], n);
+                return;
+            }
+        }
+
+        const std::uint64_t max_delta = (std::uint64_t(1) << 32) - 1;
+        if (delta > max_delta)
+            expiry = next_ + max_delta;
+        push_back(wheel_[levels - 1][level_index(levels - 1, expiry)], n);
+    }
+
+    std::size_t cascade(std::size_t level, std::size_t index)
+    {
+        timer_node list;
+        splice(wheel_[level][index], list);
+        while (list.next != &list) {
+            timer_node *n = list.next;
+            unlink(n);
+            link(n);
+        }
+        return index;
+    }
+
+    template <typename Func>
+    void clear(timer_node &head, Func &f)
+    {
+        while (head.next != &head) {
+            timer_node *n = head.next;
+            unlink(n);
+            --size_;
+            f(n);
+        }
+    }
+
+    std::uint64_t next_;
+    std::size_t size_;
+    timer_node root_[root_slots];
+    timer_node wheel_[levels][level_slots];
+};
+
+} // namespace detail
+
+} // namespace cport
+
+#endif // __TIMER_WHEEL_HPP__
@@ -0,0 +1,202 @@
+#ifndef __TRACE_DETAIL_HPP__
+#define __TRACE_DETAIL_HPP__
+
+//
+// trace.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/config.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace cport {
+
+namespace detail {
+
+// The lifecycle events of a task
+enum class trace_event : std::uint32_t {
+    async,
+    enqueue,
+    start,
+    end,
+    post_complete,
+    completion_begin,
+    completion_end,
+    cancel,
+    channel_handoff
+};
+
+// Set while the trace_recorder is started. The flag is constant
+//  initialized, so testing it is a load and a well predicted branch.
+inline std::atomic<bool>& trace_flag()
+{
+    static std::atomic<bool> enabled(false);
+    return enabled;
+}
+
+inline bool trace_enabled()
+{
+    return trace_flag().load(std::memory_order_relaxed);
+}
+
+// A ring of the events of one thread. Only the owner thread writes to
+//  it, the readers skip the events overwritten while they were read.
+class trace_buffer {
+public:
+    struct event {
+        // Nanoseconds of the steady clock
+        std::atomic<std::uint64_t> time;
+        std::atomic<std::uint64_t> id;
+        std::atomic<std::uint32_t> type;
+    };
+
+    struct record {
+        std::uint64_t time;
+        std::uint64_t id;
+        trace_event type;
+        std::size_t thread;
+    };
+
+    CPORT_DECL_TYPE trace_buffer(std::size_t capacity, std::size_t thread);
+
+    trace_buffer(const trace_buffer&) = delete;
+
+    trace_buffer& operator=(const trace_buffer&) = delete;
+
+    void push(trace_event e, std::uint64_t id, std::uint64_t time)
+    {
+        const std::uint64_t head = head_.load(std::memory_order_relaxed);
+        event &ev = events_[head & mask_];
+        ev.time.store(time, std::memory_order_relaxed);
+        ev.id.store(id, std::memory_order_relaxed);
+        ev.type.store(static_cast<std::uint32_t>(e), std::memory_order_relaxed);
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    // Append the events which are not overwritten to out
+    CPORT_DECL_TYPE void read(std::vector<record> &out) const;
+
+    // Events before the current head are not read any more
+    void clear()
+    {
+        tail_.store(head_.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+
+    // Called under the lock of the registry, before the thread writes
+    void reuse(std::size_t thread)
+    {
+        clear();
+        thread_ = thread;
+    }
+
+    std::size_t capacity() const
+    {
+        return static_cast<std::size_t>(mask_ + 1);
+    }
+
+    std::size_t thread() const
+    {
+        return thread_;
+    }
+
+private:
+    const std::uint64_t mask_;
+    std::size_t thread_;
+    std::unique_ptr<event[]> events_;
+    std::atomic<std::uint64_t> head_;
+    std::atomic<std::uint64_t> tail_;
+};
+
+// Owns the buffers of the threads which recorded events. The buffer of an
+//  exited thread is kept for reading, up to retired_limit of them. Beyond
+//  that a new thread reuses the buffer of the thread which exited first, so
+//  threads which come and go do not grow the memory without bound.
+class trace_registry {
+public:
+    enum { retired_limit = 16 };
+
+    static trace_registry& instance()
+    {
+        static trace_registry registry;
+        return registry;
+    }
+
+    // The buffer of the calling thread, created on first use
+    CPORT_DECL_TYPE trace_buffer& local_buffer();
+
+    CPORT_DECL_TYPE void set_capacity(std::size_t capacity);
+
+    CPORT_DECL_TYPE void clear();
+
+    CPORT_DECL_TYPE std::vector<trace_buffer::record> read() const;
+
+private:
+    // Retires the buffer of the thread when the thread exits
+    struct owner {
+        owner()
+            : buffer(instance().acquire())
+        {
+        }
+
+        ~owner()
+        {
+            instance().retire(buffer);
+        }
+
+        trace_buffer *const buffer;
+    };
+
+    trace_registry()
+        : capacity_(65536)
+        , threads_(0)
+    {
+    }
+
+    CPORT_DECL_TYPE trace_buffer* acquire();
+
+    CPORT_DECL_TYPE void retire(trace_buffer *buffer);
+
+    CPORT_DECL_TYPE void destroy(trace_buffer *buffer);
+
+    mutable std::mutex guard_;
+    std::size_t capacity_;
+    // The number of threads which recorded events
+    std::size_t threads_;
+    std::vector<std::unique_ptr<trace_buffer>> buffers_;
+    // The buffers of the exited threads, the oldest first
+    std::deque<trace_buffer *> retired_;
+};
+
+// Append the event to the buffer of the calling thread.
+CPORT_DECL_TYPE void trace_record(trace_event e, std::uint64_t id);
+
+inline void trace(trace_event e, std::uint64_t id)
+{
+#ifdef CPORT_HAS_TRACING
+    if (trace_enabled())
+        trace_record(e, id);
+#else
+    (void)e;
+    (void)id;
+#endif // CPORT_HAS_TRACING
+}
+
+} // namespace detail
+
+} // namespace cport
+
+#ifdef CPORT_HEADER_ONLY_LIB
+#include <cport/detail/impl/trace.ipp>
+#endif//CPORT_HEADER_ONLY_LIB
+
+#endif // __TRACE_DETAIL_HPP__
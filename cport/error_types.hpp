@@ -10,7 +10,9 @@
 // visit http://www.apache.org/licenses/ for more information.
 //
 
+#include <memory>
 #include <stdexcept>
+#include <string>
 
 namespace cport {
 
@@ -55,6 +57,102 @@ enum {
     operation_aborted = 0xEEEEFFFF
 };
 
+/// A compact error carried by the handlers on the completion path
+/**
+ * It holds the error code and, only when it represents an error or carries
+ *  a message, an owned generic_error with the message. Creating, copying
+ *  and destroying an object which represents no error and has no message
+ *  does not touch the string machinery or any reference counter.
+ */
+class error_code {
+public:
+    /// Construct an object that represents no error.
+    error_code() noexcept
+        : code_(generic_error::none)
+    {
+    }
+
+    /// Construct an object with specific error code and error message.
+    error_code(int errcode, const std::string &errmsg)
+        : code_(errcode)
+        , error_(errcode != generic_error::none || !errmsg.empty()
+            ? new generic_error(errcode, errmsg) : nullptr)
+    {
+    }
+
+    /// Construct an object from a generic_error.
+    error_code(const generic_error &e)
+        : code_(e.code())
+        , error_(e || *e.what() != '\0' ? new generic_error(e) : nullptr)
+    {
+    }
+
+    error_code(const error_code &rhs)
+        : code_(rhs.code_)
+        , error_(rhs.error_ ? new generic_error(*rhs.error_) : nullptr)
+    {
+    }
+
+    error_code(error_code &&rhs) noexcept
+        : code_(rhs.code_)
+        , error_(std::move(rhs.error_))
+    {
+        rhs.code_ = generic_error::none;
+    }
+
+    error_code& operator=(const error_code &rhs)
+    {
+        error_code(rhs).swap(*this);
+        return *this;
+    }
+
+    error_code& operator=(error_code &&rhs) noexcept
+    {
+        error_code(std::move(rhs)).swap(*this);
+        return *this;
+    }
+
+    void swap(error_code &rhs) noexcept
+    {
+        std::swap(code_, rhs.code_);
+        error_.swap(rhs.error_);
+    }
+
+    /// Return error code.
+    int code() const
+    {
+        return code_;
+    }
+
+    /// Return true if the object represents an error.
+    explicit operator bool() const
+    {
+        return generic_error::none != code_;
+    }
+
+    /// Return the error as generic_error.
+    /**
+     * An object which represents no error and has no message returns a
+     *  shared immutable instance, so no generic_error is constructed or
+     *  copied.
+     */
+    const generic_error& error() const
+    {
+        return error_ ? *error_ : no_error();
+    }
+
+    /// Return a shared generic_error which represents no error.
+    static const generic_error& no_error()
+    {
+        static const generic_error e;
+        return e;
+    }
+
+private:
+    int code_;
+    std::unique_ptr<generic_error> error_;
+};
+
 /// Defines a type used to report that an operation was aborted. 
 struct operation_aborted_error : generic_error {
     operation_aborted_error() 
@@ -0,0 +1,119 @@
+#ifndef __FILE_BATCH_HPP__
+#define __FILE_BATCH_HPP__
+
+//
+// file_batch.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/file_service.hpp>
+
+#ifdef CPORT_HAS_FILE_SERVICE
+
+#include <vector>
+
+namespace cport {
+
+/// Accumulates file requests and submits them to a file_service at once.
+/**
+ * With io_uring all requests of a commit are submitted with a single
+ *  system call. Each request is counted as an enqueued operation of the
+ *  port when added, so the port's wait() blocks until it is committed.
+ *
+ * The batch is not thread-safe. It commits on destruction.
+ *
+ * @see file_service
+ */
+class file_batch {
+public:
+    /// Construct an empty batch associated with a file service.
+    /**
+     * @param fs The file service to submit the requests to.
+     *
+     * @param capacity_hint The expected number of requests per commit.
+     */
+    explicit file_batch(file_service &fs, std::size_t capacity_hint = 0);
+
+    /// Commit the requests left and destruct the batch.
+    ~file_batch();
+
+    /// Disable copy constructor.
+    file_batch(const file_batch&) = delete;
+
+    /// Disable assignment operator.
+    file_batch& operator=(const file_batch&) = delete;
+
+    /// Add a read to be submitted on commit.
+    /**
+     * @returns false if the port is stopped and nothing was added.
+     *
+     * @see file_service::async_read
+     */
+    template <typename Handler>
+    bool read(int fd, void *data, std::size_t size, std::uint64_t offset,
+        Handler&& h);
+
+    /// Add a write to be submitted on commit.
+    /**
+     * @returns false if the port is stopped and nothing was added.
+     *
+     * @see file_service::async_write
+     */
+    template <typename Handler>
+    bool write(int fd, const void *data, std::size_t size, std::uint64_t offset,
+        Handler&& h);
+
+    /// Add a read to a registered buffer to be submitted on commit.
+    /**
+     * @returns false if the port is stopped and nothing was added.
+     *
+     * @see file_service::async_read_fixed
+     */
+    template <typename Handler>
+    bool read_fixed(int fd, std::size_t buffer_index, void *data,
+        std::size_t size, std::uint64_t offset, Handler&& h);
+
+    /// Add a write from a registered buffer to be submitted on commit.
+    /**
+     * @returns false if the port is stopped and nothing was added.
+     *
+     * @see file_service::async_write_fixed
+     */
+    template <typename Handler>
+    bool write_fixed(int fd, std::size_t buffer_index, const void *data,
+        std::size_t size, std::uint64_t offset, Handler&& h);
+
+    /// Submit all accumulated requests.
+    /**
+     * @returns The number of requests submitted.
+     */
+    std::size_t commit();
+
+    /// Get the number of accumulated requests.
+    std::size_t size() const;
+
+    /// Test if there are no accumulated requests.
+    bool empty() const;
+
+private:
+    template <typename Handler>
+    bool add(int op, int fd, void *data, std::size_t size,
+        std::uint64_t offset, int buffer_index, Handler&& h);
+
+    void reserve_one();
+
+    file_service::impl_type &impl_;
+    std::vector<detail::file_request *> requests_;
+};
+
+} // namespace cport
+
+#include <cport/impl/file_batch.inl>
+
+#endif // CPORT_HAS_FILE_SERVICE
+
+#endif //__FILE_BATCH_HPP__
@@ -0,0 +1,200 @@
+#ifndef __FILE_SERVICE_HPP__
+#define __FILE_SERVICE_HPP__
+
+//
+// file_service.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/config.hpp>
+
+#ifdef CPORT_HAS_FILE_SERVICE
+
+#include <cport/detail/file_service_impl.hpp>
+#include <cport/detail/impl_accessor.hpp>
+#include <cstdint>
+
+namespace cport {
+
+class completion_port;
+
+/// Reads and writes files asynchronously.
+/**
+ * Requests are executed through io_uring when the system supports it,
+ *  otherwise by a dedicated pool of threads doing blocking pread() and
+ *  pwrite() calls. Either way no thread of the port or of a task_scheduler
+ *  is blocked on the disk. When a request completes, its handler is posted
+ *  to the completion_port with the number of bytes transferred:
+ *
+ * @code
+ * void handler(const cport::generic_error &e, std::size_t transferred);
+ * @endcode
+ *
+ * Each request is counted as an enqueued operation of the port, so wait()
+ *  blocks until it completes. A transfer could be shorter than requested,
+ *  exactly as with pread() and pwrite(). Use file_batch to submit many
+ *  requests with a single system call.
+ *
+ * @note Available on POSIX systems. The io_uring backend is available on Linux,
+ *  unless CPORT_DISABLE_IO_URING is defined.
+ */
+class file_service {
+public:
+    /// The kinds of backends executing the requests.
+    enum backend_type {
+        /// io_uring if available, otherwise a pool of threads.
+        automatic = detail::file_service_impl::automatic,
+        /// io_uring.
+        uring = detail::file_service_impl::uring,
+        /// A pool of threads doing blocking calls.
+        thread_pool = detail::file_service_impl::thread_pool
+    };
+
+    /// Construct a service which posts completed requests to a port.
+    /**
+     * @param port The completion port to post the handlers to.
+     *
+     * @param queue_depth The maximum number of requests executed at once.
+     *  Other requests wait in a queue of the service.
+     *
+     * @param backend The backend to execute the requests.
+     *
+     * @throw std::system_error if the backend can not be created.
+     */
+    CPORT_DECL_TYPE explicit file_service(completion_port &port,
+        std::size_t queue_depth = 256, backend_type backend = automatic);
+
+    /// Destruct the service.
+    /**
+     * Blocks until all submitted requests complete and their handlers
+     *  are posted.
+     */
+    CPORT_DECL_TYPE ~file_service();
+
+    /// Disable copy constructor.
+    file_service(const file_service&) = delete;
+
+    /// Disable assignment operator.
+    file_service& operator=(const file_service&) = delete;
+
+    /// Get the backend executing the requests, never automatic.
+    backend_type backend() const;
+
+    /// Read from a file at an offset.
+    /**
+     * @param fd The file descriptor.
+     *
+     * @param data The buffer to read to. It must stay valid until the
+     *  handler is invoked.
+     *
+     * @param size The size of the buffer.
+     *
+     * @param offset The offset in the file.
+     *
+     * @param h The completion handler to be invoked.
+     *
+     * @returns false if the port is stopped and nothing was submitted.
+     */
+    template <typename Handler>
+    bool async_read(int fd, void *data, std::size_t size,
+        std::uint64_t offset, Handler&& h);
+
+    /// Write to a file at an offset.
+    /**
+     * @param fd The file descriptor.
+     *
+     * @param data The data to write. It must stay valid until the
+     *  handler is invoked.
+     *
+     * @param size The size of the data.
+     *
+     * @param offset The offset in the file.
+     *
+     * @param h The completion handler to be invoked.
+     *
+     * @returns false if the port is stopped and nothing was submitted.
+     */
+    template <typename Handler>
+    bool async_write(int fd, const void *data, std::size_t size,
+        std::uint64_t offset, Handler&& h);
+
+    /// Read from a file to a registered buffer.
+    /**
+     * The data must be within the registered buffer, otherwise the
+     *  handler is posted with EINVAL error.
+     *
+     * @param buffer_index The index of the registered buffer.
+     *
+     * @see async_read, register_buffers
+     */
+    template <typename Handler>
+    bool async_read_fixed(int fd, std::size_t buffer_index, void *data,
+        std::size_t size, std::uint64_t offset, Handler&& h);
+
+    /// Write to a file from a registered buffer.
+    /**
+     * The data must be within the registered buffer, otherwise the
+     *  handler is posted with EINVAL error.
+     *
+     * @param buffer_index The index of the registered buffer.
+     *
+     * @see async_write, register_buffers
+     */
+    template <typename Handler>
+    bool async_write_fixed(int fd, std::size_t buffer_index, const void *data,
+        std::size_t size, std::uint64_t offset, Handler&& h);
+
+    /// Register buffers for the fixed reads and writes.
+    /**
+     * With io_uring the buffers are mapped by the kernel once, instead of
+     *  on each request. Replaces the buffers registered before. Must not be
+     *  called while fixed requests are in progress.
+     *
+     * @param buffers The buffers to register. They must stay valid until
+     *  unregistered or the service is destroyed.
+     *
+     * @param count The number of buffers.
+     *
+     * @throw std::system_error if the buffers can not be registered.
+     */
+    void register_buffers(const file_buffer *buffers, std::size_t count);
+
+    /// Unregister all registered buffers.
+    void unregister_buffers();
+
+    /// The implementation type.
+    typedef detail::file_service_impl impl_type;
+protected:
+    /// Get a const reference to the implementation type
+    const impl_type& impl() const;
+
+    /// Get a reference to the implementation type
+    impl_type& impl();
+private:
+    template<typename T>
+    friend const typename T::impl_type& detail::get_impl(const T&);
+
+    template<typename T>
+    friend typename T::impl_type& detail::get_impl(T&);
+
+    template <typename Handler>
+    bool submit(int op, int fd, void *data, std::size_t size,
+        std::uint64_t offset, int buffer_index, Handler&& h);
+
+    impl_type impl_;
+};
+
+} // namespace cport
+
+#include <cport/impl/file_service.inl>
+#ifdef CPORT_HEADER_ONLY_LIB
+#include <cport/impl/file_service.ipp>
+#endif//CPORT_HEADER_ONLY_LIB
+
+#endif // CPORT_HAS_FILE_SERVICE
+
+#endif//__FILE_SERVICE_HPP__
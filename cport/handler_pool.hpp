@@ -0,0 +1,75 @@
+#ifndef __HANDLER_POOL_HPP__
+#define __HANDLER_POOL_HPP__
+
+//
+// handler_pool.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/config.hpp>
+#include <cstddef>
+
+namespace cport {
+
+/// Statistics of the memory of the pooled handlers.
+struct handler_pool_stats {
+    /// The bytes held by live handlers and tasks.
+    std::size_t live_bytes;
+
+    /// The bytes of the free nodes kept by the pool for reuse.
+    std::size_t cached_bytes;
+
+    /// The largest number of bytes held by the pool at once.
+    std::size_t high_water_bytes;
+};
+
+/// Controls the memory pool shared by the handlers of all ports and schedulers.
+/**
+ * The completion and task handlers are stored in nodes of power of two
+ *  size classes, up to CPORT_POOL_MAX_NODE_SIZE bytes. The nodes freed by a
+ *  thread are cached in its own magazines and in a depot shared by all
+ *  threads, so the handlers of all types of a size class reuse the same
+ *  memory. The larger handlers are allocated from the heap.
+ *
+ * When the pool is disabled by CPORT_DISABLE_OBJ_MEMORY_POOL all statistics
+ *  are zero and the other methods have no effect.
+ */
+class handler_pool {
+public:
+    /// Get the current statistics.
+    CPORT_DECL_TYPE static handler_pool_stats stats();
+
+    /// Return the cached nodes to the heap.
+    /**
+     * Releases the nodes in the shared depot and in the magazines of the
+     *  calling thread. The magazines of the other threads are not affected.
+     *
+     * @return The number of released bytes.
+     */
+    CPORT_DECL_TYPE static std::size_t trim();
+
+    /// Limit the bytes of the free nodes cached in the shared depot.
+    /**
+     * A magazine freed by a thread beyond the limit is returned to the heap.
+     *  Each thread may still cache a few magazines of its own. The limit
+     *  does not release the nodes already cached, see trim().
+     *
+     * @param bytes The limit. No limit by default.
+     */
+    CPORT_DECL_TYPE static void set_cache_limit(std::size_t bytes);
+
+    /// Get the limit of the bytes cached in the shared depot.
+    CPORT_DECL_TYPE static std::size_t cache_limit();
+};
+
+} // namespace cport
+
+#ifdef CPORT_HEADER_ONLY_LIB
+#include <cport/impl/handler_pool.ipp>
+#endif//CPORT_HEADER_ONLY_LIB
+
+#endif // __HANDLER_POOL_HPP__
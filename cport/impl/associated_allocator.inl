@@ -0,0 +1,59 @@
+#ifndef __ASSOCIATED_ALLOCATOR_INL__
+#define __ASSOCIATED_ALLOCATOR_INL__
+
+//
+// associated_allocator.inl
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+namespace cport {
+
+template <typename Handler, typename Allocator>
+template <typename H>
+inline allocator_binder<Handler, Allocator>::allocator_binder(const Allocator &a, H&& h)
+    : allocator_(a)
+    , handler_(std::forward<H>(h))
+{
+}
+
+template <typename Handler, typename Allocator>
+inline typename allocator_binder<Handler, Allocator>::allocator_type
+allocator_binder<Handler, Allocator>::get_allocator() const
+{
+    return allocator_;
+}
+
+template <typename Handler, typename Allocator>
+inline Handler& allocator_binder<Handler, Allocator>::get()
+{
+    return handler_;
+}
+
+template <typename Handler, typename Allocator>
+inline const Handler& allocator_binder<Handler, Allocator>::get() const
+{
+    return handler_;
+}
+
+template <typename Handler, typename Allocator>
+template <typename... Args>
+inline void allocator_binder<Handler, Allocator>::operator()(Args&&... args)
+{
+    handler_(std::forward<Args>(args)...);
+}
+
+template <typename Allocator, typename Handler>
+inline allocator_binder<typename std::decay<Handler>::type, Allocator>
+bind_allocator(const Allocator &a, Handler&& h)
+{
+    return allocator_binder<typename std::decay<Handler>::type, Allocator>(
+        a, std::forward<Handler>(h));
+}
+
+} // namespace cport
+
+#endif // __ASSOCIATED_ALLOCATOR_INL__
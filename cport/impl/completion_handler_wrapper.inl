@@ -16,6 +16,7 @@
 #include <cport/detail/impl_accessor.hpp>
 #include <cport/detail/null_handler_t.hpp>
 #include <algorithm>
+#include <functional>
 
 namespace cport {
 
@@ -72,8 +73,7 @@ inline completion_handler_wrapper<Handler>::~completion_handler_wrapper()
 {
     if (op_id_.valid())
     {
-        const generic_error e;
-        port_impl_->post(detail::null_handler_t(), op_id_, e);
+        port_impl_->post(detail::null_handler_t(), op_id_, error_code());
     }
 }
 
@@ -95,8 +95,7 @@ inline completion_handler_wrapper<Handler>::operator bool() const
 template <typename Handler>
 inline void completion_handler_wrapper<Handler>::operator()()
 {
-    const generic_error e;
-    operator()(e);
+    operator()(error_code::no_error());
 }
 
 template <typename Handler>
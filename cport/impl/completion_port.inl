@@ -11,6 +11,10 @@
 //
 
 #include <cport/error_types.hpp>
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <vector>
 
 namespace cport {
 
@@ -23,19 +27,76 @@ inline void completion_port::dispatch(Handler&& h, const generic_error& e)
 template <typename Handler>
 inline void completion_port::dispatch(Handler&& h)
 {
-    dispatch(h, generic_error());
+    impl().dispatch(std::forward<Handler>(h), error_code());
 }
 
 template <typename Handler>
 inline void completion_port::post(Handler&& h, const generic_error& e)
 {
-    impl().post(std::forward<Handler>(h), impl_.next_operation_id(), e);
+    impl().post(std::forward<Handler>(h), impl_.post_seqno(), e);
 }
 
 template <typename Handler>
 inline void completion_port::post(Handler&& h)
 {
-    post(std::forward<Handler>(h), generic_error());
+    impl().post(std::forward<Handler>(h), impl_.post_seqno(), error_code());
+}
+
+template <typename Handler>
+inline void completion_port::post(Handler&& h, const generic_error& e, std::size_t priority)
+{
+    impl().post(std::forward<Handler>(h), impl_.post_seqno(), e, priority);
+}
+
+template <typename Handler>
+inline void completion_port::post(Handler&& h, std::size_t priority)
+{
+    impl().post(std::forward<Handler>(h), impl_.post_seqno(), error_code(),
+        priority);
+}
+
+template <typename InputIterator>
+inline std::size_t completion_port::post_range(InputIterator first, InputIterator last)
+{
+    typedef typename std::iterator_traits<InputIterator>::value_type handler_type;
+    std::vector<detail::completion_handler_base *> handlers;
+    const error_code e;
+    try {
+        for (; first != last; ++first) {
+            // Make room first, so the operation id can not be lost
+            if (handlers.size() == handlers.capacity())
+                handlers.reserve(std::max<std::size_t>(16, handlers.capacity() * 2));
+            // A copy which throws must not take an operation id
+            handler_type h(*first);
+            handlers.push_back(detail::create_completion_handler(impl_.resource(),
+                std::move(h), impl_.next_operation_id(), e));
+        }
+    }
+    catch (...) {
+        impl().post(handlers.data(), handlers.size());
+        throw;
+    }
+    impl().post(handlers.data(), handlers.size());
+    return handlers.size();
+}
+
+template <typename Rep, typename Period, typename Handler>
+inline timer_handle completion_port::post_after(const std::chrono::duration<Rep, Period> &d, Handler&& h)
+{
+    return impl().post_at(std::forward<Handler>(h), std::chrono::steady_clock::now()
+        + std::chrono::duration_cast<std::chrono::steady_clock::duration>(d));
+}
+
+template <typename Clock, typename Duration, typename Handler>
+inline timer_handle completion_port::post_at(const std::chrono::time_point<Clock, Duration> &tp, Handler&& h)
+{
+    // A time point in the past expires immediately
+    return post_after(tp - Clock::now(), std::forward<Handler>(h));
+}
+
+inline bool completion_port::cancel(const timer_handle &t)
+{
+    return impl().cancel(t);
 }
 
 template <typename Handler>
@@ -47,7 +108,7 @@ inline void completion_port::call(Handler&& h, const generic_error& e)
 template <typename Handler>
 inline void completion_port::call(Handler&& h)
 {
-    impl().call(std::forward<Handler>(h), generic_error());
+    impl().call(std::forward<Handler>(h), error_code::no_error());
 }
 
 inline std::size_t completion_port::wait()
@@ -82,6 +143,71 @@ inline bool completion_port::run_one()
     return impl().run_one();
 }
 
+inline std::size_t completion_port::run_batch(std::size_t max)
+{
+    return impl().run_batch(max);
+}
+
+template <typename Rep, typename Period>
+inline std::size_t completion_port::wait_for(const std::chrono::duration<Rep, Period> &d)
+{
+    return wait_until(std::chrono::steady_clock::now() + d);
+}
+
+template <typename Clock, typename Duration>
+inline std::size_t completion_port::wait_until(const std::chrono::time_point<Clock, Duration> &tp)
+{
+    std::size_t count = 0;
+    while (wait_one_until(tp)) {
+        if (count < std::numeric_limits<std::size_t>::max()) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+template <typename Rep, typename Period>
+inline bool completion_port::wait_one_for(const std::chrono::duration<Rep, Period> &d)
+{
+    return wait_one_until(std::chrono::steady_clock::now() + d);
+}
+
+template <typename Clock, typename Duration>
+inline bool completion_port::wait_one_until(const std::chrono::time_point<Clock, Duration> &tp)
+{
+    return impl().wait_one_until(tp);
+}
+
+template <typename Rep, typename Period>
+inline std::size_t completion_port::run_for(const std::chrono::duration<Rep, Period> &d)
+{
+    return run_until(std::chrono::steady_clock::now() + d);
+}
+
+template <typename Clock, typename Duration>
+inline std::size_t completion_port::run_until(const std::chrono::time_point<Clock, Duration> &tp)
+{
+    std::size_t count = 0;
+    while (run_one_until(tp)) {
+        if (count < std::numeric_limits<std::size_t>::max()) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+template <typename Rep, typename Period>
+inline bool completion_port::run_one_for(const std::chrono::duration<Rep, Period> &d)
+{
+    return run_one_until(std::chrono::steady_clock::now() + d);
+}
+
+template <typename Clock, typename Duration>
+inline bool completion_port::run_one_until(const std::chrono::time_point<Clock, Duration> &tp)
+{
+    return impl().run_one_until(tp);
+}
+
 inline std::size_t completion_port::pull()
 {
     std::size_t count = 0;
@@ -98,6 +224,11 @@ inline bool completion_port::pull_one()
     return impl().pull_one();
 }
 
+inline std::size_t completion_port::pull_n(std::size_t max)
+{
+    return impl().pull_n(max);
+}
+
 inline void completion_port::stop()
 {
     impl().stop();
@@ -118,11 +249,68 @@ inline std::size_t completion_port::ready_handlers() const
     return impl().ready_handlers();
 }
 
+inline std::size_t completion_port::ready_handlers(std::size_t priority) const
+{
+    return impl().ready_handlers(priority);
+}
+
 inline std::size_t completion_port::blocked_threads() const
 {
     return impl().blocked_threads();
 }
 
+inline std::size_t completion_port::shards() const
+{
+    return impl().shards();
+}
+
+inline std::size_t completion_port::priority_levels() const
+{
+    return impl().priority_levels();
+}
+
+inline void completion_port::set_priority_aging(std::size_t limit)
+{
+    impl().set_priority_aging(limit);
+}
+
+inline std::size_t completion_port::get_priority_aging() const
+{
+    return impl().get_priority_aging();
+}
+
+inline void completion_port::set_wait_policy(const wait_policy &wp)
+{
+    impl().set_wait_policy(wp);
+}
+
+inline wait_policy completion_port::get_wait_policy() const
+{
+    return impl().get_wait_policy();
+}
+
+inline wait_stats completion_port::get_wait_stats() const
+{
+    return impl().get_wait_stats();
+}
+
+inline memory_resource* completion_port::get_memory_resource() const
+{
+    return &impl().resource();
+}
+
+inline port_metrics completion_port::snapshot() const
+{
+    return impl().snapshot();
+}
+
+#ifdef CPORT_HAS_EVENTFD
+inline completion_port::native_handle_type completion_port::native_handle()
+{
+    return impl().native_handle();
+}
+#endif // CPORT_HAS_EVENTFD
+
 inline const completion_port::impl_type& completion_port::impl() const
 {
     return impl_;
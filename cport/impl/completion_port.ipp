@@ -18,6 +18,27 @@ completion_port::completion_port()
 {
 }
 
+completion_port::completion_port(std::size_t shards)
+    : impl_(shards)
+{
+}
+
+completion_port::completion_port(std::size_t shards, std::size_t priority_levels)
+    : impl_(shards, priority_levels)
+{
+}
+
+completion_port::completion_port(memory_resource &r)
+    : impl_(1, 1, &r)
+{
+}
+
+completion_port::completion_port(std::size_t shards, std::size_t priority_levels,
+    memory_resource &r)
+    : impl_(shards, priority_levels, &r)
+{
+}
+
 completion_port::~completion_port()
 {
 }
@@ -0,0 +1,103 @@
+#ifndef __FILE_BATCH_INL__
+#define __FILE_BATCH_INL__
+
+//
+// file_batch.inl
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/detail/impl_accessor.hpp>
+#include <algorithm>
+
+namespace cport {
+
+inline file_batch::file_batch(file_service &fs, std::size_t capacity_hint)
+    : impl_(detail::get_impl(fs))
+{
+    requests_.reserve(capacity_hint);
+}
+
+inline file_batch::~file_batch()
+{
+    commit();
+}
+
+template <typename Handler>
+inline bool file_batch::read(int fd, void *data, std::size_t size,
+    std::uint64_t offset, Handler&& h)
+{
+    return add(detail::file_request::read_op, fd, data, size, offset, -1,
+        std::forward<Handler>(h));
+}
+
+template <typename Handler>
+inline bool file_batch::write(int fd, const void *data, std::size_t size,
+    std::uint64_t offset, Handler&& h)
+{
+    return add(detail::file_request::write_op, fd, const_cast<void *>(data),
+        size, offset, -1, std::forward<Handler>(h));
+}
+
+template <typename Handler>
+inline bool file_batch::read_fixed(int fd, std::size_t buffer_index, void *data,
+    std::size_t size, std::uint64_t offset, Handler&& h)
+{
+    return add(detail::file_request::read_op, fd, data, size, offset,
+        static_cast<int>(buffer_index), std::forward<Handler>(h));
+}
+
+template <typename Handler>
+inline bool file_batch::write_fixed(int fd, std::size_t buffer_index,
+    const void *data, std::size_t size, std::uint64_t offset, Handler&& h)
+{
+    return add(detail::file_request::write_op, fd, const_cast<void *>(data),
+        size, offset, static_cast<int>(buffer_index), std::forward<Handler>(h));
+}
+
+inline std::size_t file_batch::commit()
+{
+    const std::size_t count = requests_.size();
+    if (count != 0)
+        impl_.submit(requests_.data(), count);
+    requests_.clear();
+    return count;
+}
+
+inline std::size_t file_batch::size() const
+{
+    return requests_.size();
+}
+
+inline bool file_batch::empty() const
+{
+    return requests_.empty();
+}
+
+template <typename Handler>
+inline bool file_batch::add(int op, int fd, void *data, std::size_t size,
+    std::uint64_t offset, int buffer_index, Handler&& h)
+{
+    // Make room first, so the operation id can not be lost
+    reserve_one();
+    detail::file_request *r = impl_.create(op, fd, data, size, offset,
+        buffer_index, std::forward<Handler>(h));
+    if (r == nullptr)
+        return false;
+
+    requests_.push_back(r);
+    return true;
+}
+
+inline void file_batch::reserve_one()
+{
+    if (requests_.size() == requests_.capacity())
+        requests_.reserve(std::max<std::size_t>(16, requests_.capacity() * 2));
+}
+
+} // namespace cport
+
+#endif //__FILE_BATCH_INL__
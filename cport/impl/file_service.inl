@@ -0,0 +1,88 @@
+#ifndef __FILE_SERVICE_INL__
+#define __FILE_SERVICE_INL__
+
+//
+// file_service.inl
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+namespace cport {
+
+inline file_service::backend_type file_service::backend() const
+{
+    return static_cast<backend_type>(impl().backend());
+}
+
+template <typename Handler>
+inline bool file_service::async_read(int fd, void *data, std::size_t size,
+    std::uint64_t offset, Handler&& h)
+{
+    return submit(detail::file_request::read_op, fd, data, size, offset, -1,
+        std::forward<Handler>(h));
+}
+
+template <typename Handler>
+inline bool file_service::async_write(int fd, const void *data, std::size_t size,
+    std::uint64_t offset, Handler&& h)
+{
+    return submit(detail::file_request::write_op, fd, const_cast<void *>(data),
+        size, offset, -1, std::forward<Handler>(h));
+}
+
+template <typename Handler>
+inline bool file_service::async_read_fixed(int fd, std::size_t buffer_index,
+    void *data, std::size_t size, std::uint64_t offset, Handler&& h)
+{
+    return submit(detail::file_request::read_op, fd, data, size, offset,
+        static_cast<int>(buffer_index), std::forward<Handler>(h));
+}
+
+template <typename Handler>
+inline bool file_service::async_write_fixed(int fd, std::size_t buffer_index,
+    const void *data, std::size_t size, std::uint64_t offset, Handler&& h)
+{
+    return submit(detail::file_request::write_op, fd, const_cast<void *>(data),
+        size, offset, static_cast<int>(buffer_index), std::forward<Handler>(h));
+}
+
+inline void file_service::register_buffers(const file_buffer *buffers,
+    std::size_t count)
+{
+    impl().register_buffers(buffers, count);
+}
+
+inline void file_service::unregister_buffers()
+{
+    impl().unregister_buffers();
+}
+
+template <typename Handler>
+inline bool file_service::submit(int op, int fd, void *data, std::size_t size,
+    std::uint64_t offset, int buffer_index, Handler&& h)
+{
+    detail::file_request *r = impl().create(op, fd, data, size, offset,
+        buffer_index, std::forward<Handler>(h));
+    if (r == nullptr)
+        return false;
+
+    impl().submit(&r, 1);
+    return true;
+}
+
+inline const file_service::impl_type& file_service::impl() const
+{
+    return impl_;
+}
+
+inline file_service::impl_type& file_service::impl()
+{
+    return impl_;
+}
+
+} // namespace cport
+
+#endif//__FILE_SERVICE_INL__
@@ -0,0 +1,31 @@
+#ifndef __FILE_SERVICE_IPP__
+#define __FILE_SERVICE_IPP__
+
+//
+// file_service.ipp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/file_service.hpp>
+#include <cport/completion_port.hpp>
+
+namespace cport {
+
+file_service::file_service(completion_port &port, std::size_t queue_depth,
+    backend_type backend)
+    : impl_(detail::get_impl(port), queue_depth,
+        static_cast<impl_type::backend_type>(backend))
+{
+}
+
+file_service::~file_service()
+{
+}
+
+} // namespace cport
+
+#endif//__FILE_SERVICE_IPP__
@@ -0,0 +1,73 @@
+#ifndef __HANDLER_POOL_IPP__
+#define __HANDLER_POOL_IPP__
+
+//
+// handler_pool.ipp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/handler_pool.hpp>
+#include <cport/detail/obj_mem_pool.hpp>
+
+namespace cport {
+
+#ifndef CPORT_DISABLE_OBJ_MEMORY_POOL
+
+handler_pool_stats handler_pool::stats()
+{
+    const detail::slab_allocator &a = detail::slab_allocator::instance();
+    handler_pool_stats s;
+    s.live_bytes = a.live_bytes();
+    const std::size_t footprint = a.footprint();
+    // The counters are not read at once
+    s.cached_bytes = footprint > s.live_bytes ? footprint - s.live_bytes : 0;
+    s.high_water_bytes = a.high_water_bytes();
+    return s;
+}
+
+std::size_t handler_pool::trim()
+{
+    return detail::slab_allocator::instance().trim();
+}
+
+void handler_pool::set_cache_limit(std::size_t bytes)
+{
+    detail::slab_allocator::instance().set_cache_limit(bytes);
+}
+
+std::size_t handler_pool::cache_limit()
+{
+    return detail::slab_allocator::instance().cache_limit();
+}
+
+#else // CPORT_DISABLE_OBJ_MEMORY_POOL
+
+handler_pool_stats handler_pool::stats()
+{
+    const handler_pool_stats s = { 0, 0, 0 };
+    return s;
+}
+
+std::size_t handler_pool::trim()
+{
+    return 0;
+}
+
+void handler_pool::set_cache_limit(std::size_t)
+{
+}
+
+std::size_t handler_pool::cache_limit()
+{
+    return 0;
+}
+
+#endif // CPORT_DISABLE_OBJ_MEMORY_POOL
+
+} // namespace cport
+
+#endif // __HANDLER_POOL_IPP__
@@ -0,0 +1,42 @@
+#ifndef __LATENCY_HISTOGRAM_INL__
+#define __LATENCY_HISTOGRAM_INL__
+
+//
+// latency_histogram.inl
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+namespace cport {
+
+inline std::uint64_t latency_histogram::count() const
+{
+    return count_;
+}
+
+inline std::chrono::nanoseconds latency_histogram::min() const
+{
+    return std::chrono::nanoseconds(count_ != 0 ? min_ : 0);
+}
+
+inline std::chrono::nanoseconds latency_histogram::max() const
+{
+    return std::chrono::nanoseconds(max_);
+}
+
+inline const std::vector<std::uint64_t>& latency_histogram::buckets() const
+{
+    return buckets_;
+}
+
+inline std::chrono::nanoseconds latency_histogram::bucket_value(std::size_t bucket)
+{
+    return std::chrono::nanoseconds(detail::histogram_buckets::upper_value(bucket));
+}
+
+} // namespace cport
+
+#endif // __LATENCY_HISTOGRAM_INL__
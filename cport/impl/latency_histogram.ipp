@@ -0,0 +1,91 @@
+#ifndef __LATENCY_HISTOGRAM_IPP__
+#define __LATENCY_HISTOGRAM_IPP__
+
+//
+// latency_histogram.ipp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/latency_histogram.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace cport {
+
+latency_histogram::latency_histogram()
+    : buckets_(detail::histogram_buckets::count, 0)
+    , count_(0)
+    , min_(std::numeric_limits<std::uint64_t>::max())
+    , max_(0)
+{
+}
+
+std::chrono::nanoseconds latency_histogram::mean() const
+{
+    if (count_ == 0)
+        return std::chrono::nanoseconds(0);
+
+    // Each latency is taken at the middle of its bucket
+    double sum = 0;
+    for (std::size_t i = 0; i < buckets_.size(); ++i) {
+        if (buckets_[i] != 0) {
+            const double value = (detail::histogram_buckets::lower_value(i)
+                + detail::histogram_buckets::upper_value(i)) / 2.0;
+            sum += value * buckets_[i];
+        }
+    }
+    return std::chrono::nanoseconds(static_cast<std::int64_t>(sum / count_));
+}
+
+std::chrono::nanoseconds latency_histogram::percentile(double p) const
+{
+    if (count_ == 0)
+        return std::chrono::nanoseconds(0);
+
+    if (p <= 0)
+        return min();
+
+    p = std::min(p, 100.0);
+    const std::uint64_t rank = std::max<std::uint64_t>(1,
+        static_cast<std::uint64_t>(std::ceil(p / 100.0 * count_)));
+
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < buckets_.size(); ++i) {
+        seen += buckets_[i];
+        if (seen >= rank) {
+            const std::uint64_t value = detail::histogram_buckets::upper_value(i);
+            return std::chrono::nanoseconds(std::min(std::max(value, min_), max_));
+        }
+    }
+    return std::chrono::nanoseconds(max_);
+}
+
+void latency_histogram::record(std::chrono::nanoseconds latency)
+{
+    const std::uint64_t v = latency.count() > 0
+        ? static_cast<std::uint64_t>(latency.count()) : 0;
+    ++buckets_[detail::histogram_buckets::index(v)];
+    ++count_;
+    min_ = std::min(min_, v);
+    max_ = std::max(max_, v);
+}
+
+void latency_histogram::merge(const latency_histogram &other)
+{
+    if (other.count_ == 0)
+        return;
+    for (std::size_t i = 0; i < buckets_.size(); ++i)
+        buckets_[i] += other.buckets_[i];
+    count_ += other.count_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+}
+
+} // namespace cport
+
+#endif // __LATENCY_HISTOGRAM_IPP__
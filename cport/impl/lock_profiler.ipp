@@ -0,0 +1,72 @@
+#ifndef __LOCK_PROFILER_IPP__
+#define __LOCK_PROFILER_IPP__
+
+//
+// lock_profiler.ipp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/lock_profiler.hpp>
+#include <algorithm>
+#include <iomanip>
+
+namespace cport {
+
+CPORT_DECL_TYPE std::vector<lock_stats> lock_profiler::snapshot()
+{
+    typedef detail::lock_site site;
+    std::vector<lock_stats> sites;
+    for (const site *s = site::first(); s != nullptr; s = s->next()) {
+        lock_stats stats;
+        stats.site = s->name();
+        stats.acquisitions = s->sum(site::acquisitions);
+        stats.contended = s->sum(site::contended);
+        stats.wait_time = std::chrono::nanoseconds(s->sum(site::wait_time));
+        stats.hold_time = std::chrono::nanoseconds(s->sum(site::hold_time));
+        sites.push_back(stats);
+    }
+
+    std::stable_sort(sites.begin(), sites.end(),
+        [](const lock_stats &a, const lock_stats &b) {
+            return a.wait_time > b.wait_time;
+        });
+    return sites;
+}
+
+CPORT_DECL_TYPE void lock_profiler::write_report(std::ostream &os)
+{
+    const std::vector<lock_stats> sites = snapshot();
+    const std::ios_base::fmtflags flags = os.flags();
+
+    os << std::left << std::setw(34) << "site" << std::right
+        << std::setw(14) << "acquisitions"
+        << std::setw(12) << "contended"
+        << std::setw(9) << "%"
+        << std::setw(14) << "wait us"
+        << std::setw(12) << "avg wait ns"
+        << std::setw(14) << "hold us"
+        << std::setw(12) << "avg hold ns" << '\n';
+
+    for (const lock_stats &s : sites) {
+        const std::uint64_t acquisitions = std::max<std::uint64_t>(s.acquisitions, 1);
+        const std::uint64_t contended = std::max<std::uint64_t>(s.contended, 1);
+        os << std::left << std::setw(34) << s.site << std::right
+            << std::setw(14) << s.acquisitions
+            << std::setw(12) << s.contended
+            << std::setw(9) << std::fixed << std::setprecision(2)
+            << 100.0 * s.contended / acquisitions
+            << std::setw(14) << s.wait_time.count() / 1000
+            << std::setw(12) << s.wait_time.count() / contended
+            << std::setw(14) << s.hold_time.count() / 1000
+            << std::setw(12) << s.hold_time.count() / acquisitions << '\n';
+    }
+    os.flags(flags);
+}
+
+} // namespace cport
+
+#endif // __LOCK_PROFILER_IPP__
@@ -0,0 +1,121 @@
+#ifndef __MEMORY_RESOURCE_IPP__
+#define __MEMORY_RESOURCE_IPP__
+
+//
+// memory_resource.ipp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/memory_resource.hpp>
+#include <cport/detail/obj_mem_pool.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+namespace cport {
+
+namespace detail {
+
+// The default resource, backed by the handler pool.
+class pool_resource : public memory_resource {
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        assert(alignment <= alignof(std::max_align_t));
+        (void)alignment;
+#ifndef CPORT_DISABLE_OBJ_MEMORY_POOL
+        return slab_allocator::instance().allocate(bytes);
+#else
+        return ::operator new(bytes);
+#endif // CPORT_DISABLE_OBJ_MEMORY_POOL
+    }
+
+    void do_deallocate(void *p, std::size_t bytes, std::size_t) override
+    {
+#ifndef CPORT_DISABLE_OBJ_MEMORY_POOL
+        slab_allocator::instance().deallocate(p, bytes);
+#else
+        (void)bytes;
+        ::operator delete(p);
+#endif // CPORT_DISABLE_OBJ_MEMORY_POOL
+    }
+};
+
+} // namespace detail
+
+memory_resource* get_default_resource()
+{
+    static detail::pool_resource resource;
+    return &resource;
+}
+
+monotonic_buffer_resource::monotonic_buffer_resource(std::size_t initial_size,
+    memory_resource *upstream)
+    : upstream_(upstream)
+    , chunks_(nullptr)
+    , current_(nullptr)
+    , available_(0)
+    , next_size_(std::max<std::size_t>(initial_size, 64))
+    , upstream_bytes_(0)
+{
+}
+
+monotonic_buffer_resource::~monotonic_buffer_resource()
+{
+    release();
+}
+
+void monotonic_buffer_resource::release()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (chunk *c = chunks_) {
+        chunks_ = c->next;
+        upstream_->deallocate(c, c->size);
+    }
+    current_ = nullptr;
+    available_ = 0;
+    upstream_bytes_ = 0;
+}
+
+std::size_t monotonic_buffer_resource::upstream_bytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return upstream_bytes_;
+}
+
+void* monotonic_buffer_resource::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t padding = (alignment - reinterpret_cast<std::uintptr_t>(current_) % alignment) % alignment;
+    if (current_ == nullptr || padding + bytes > available_) {
+        // The chunks grow geometrically, a large block gets a chunk of its own
+        const std::size_t header = (sizeof(chunk) + alignof(std::max_align_t) - 1)
+            / alignof(std::max_align_t) * alignof(std::max_align_t);
+        const std::size_t size = std::max(next_size_, header + bytes + alignment);
+        chunk *c = static_cast<chunk *>(upstream_->allocate(size));
+        c->next = chunks_;
+        c->size = size;
+        chunks_ = c;
+        upstream_bytes_ += size;
+        next_size_ = next_size_ * 2;
+        current_ = reinterpret_cast<char *>(c) + header;
+        available_ = size - header;
+        padding = (alignment - reinterpret_cast<std::uintptr_t>(current_) % alignment) % alignment;
+    }
+    void *p = current_ + padding;
+    current_ += padding + bytes;
+    available_ -= padding + bytes;
+    return p;
+}
+
+void monotonic_buffer_resource::do_deallocate(void *, std::size_t, std::size_t)
+{
+}
+
+} // namespace cport
+
+#endif // __MEMORY_RESOURCE_IPP__
@@ -0,0 +1,99 @@
+#ifndef __POST_BATCH_INL__
+#define __POST_BATCH_INL__
+
+//
+// post_batch.inl
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/error_types.hpp>
+#include <cport/detail/completion_handler.hpp>
+#include <cport/detail/impl_accessor.hpp>
+#include <algorithm>
+
+namespace cport {
+
+inline post_batch::post_batch(completion_port &port, std::size_t capacity_hint)
+    : port_impl_(detail::get_impl(port))
+{
+    handlers_.reserve(capacity_hint);
+}
+
+inline post_batch::~post_batch()
+{
+    commit();
+}
+
+template <typename Handler>
+inline void post_batch::dispatch(Handler&& h, const generic_error& e)
+{
+    dispatch_handler(std::forward<Handler>(h), e);
+}
+
+template <typename Handler>
+inline void post_batch::dispatch_handler(Handler&& h, const error_code& e)
+{
+    reserve_one();
+    handlers_.push_back(detail::create_completion_handler(
+        port_impl_.resource(), std::forward<Handler>(h), 0, e));
+}
+
+template <typename Handler>
+inline void post_batch::dispatch(Handler&& h)
+{
+    dispatch_handler(std::forward<Handler>(h), error_code());
+}
+
+template <typename Handler>
+inline void post_batch::post(Handler&& h, const generic_error& e)
+{
+    post_handler(std::forward<Handler>(h), e);
+}
+
+template <typename Handler>
+inline void post_batch::post_handler(Handler&& h, const error_code& e)
+{
+    // Make room first, so the operation id can not be lost
+    reserve_one();
+    handlers_.push_back(detail::create_completion_handler(
+        port_impl_.resource(), std::forward<Handler>(h),
+        port_impl_.next_operation_id(), e));
+}
+
+template <typename Handler>
+inline void post_batch::post(Handler&& h)
+{
+    post_handler(std::forward<Handler>(h), error_code());
+}
+
+inline std::size_t post_batch::commit()
+{
+    const std::size_t count = handlers_.size();
+    port_impl_.post(handlers_.data(), count);
+    handlers_.clear();
+    return count;
+}
+
+inline std::size_t post_batch::size() const
+{
+    return handlers_.size();
+}
+
+inline bool post_batch::empty() const
+{
+    return handlers_.empty();
+}
+
+inline void post_batch::reserve_one()
+{
+    if (handlers_.size() == handlers_.capacity())
+        handlers_.reserve(std::max<std::size_t>(16, handlers_.capacity() * 2));
+}
+
+} // namespace cport
+
+#endif //__POST_BATCH_INL__
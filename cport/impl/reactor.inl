@@ -0,0 +1,49 @@
+#ifndef __REACTOR_INL__
+#define __REACTOR_INL__
+
+//
+// reactor.inl
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+namespace cport {
+
+template <typename Handler>
+inline reactor_handle reactor::async_wait(int fd, int events, Handler&& h)
+{
+    return impl().async_wait(fd, events, std::forward<Handler>(h));
+}
+
+template <typename Handler>
+inline reactor_handle reactor::watch(int fd, int events, Handler&& h)
+{
+    return impl().watch(fd, events, std::forward<Handler>(h));
+}
+
+inline bool reactor::cancel(const reactor_handle &r)
+{
+    return impl().cancel(r);
+}
+
+inline std::size_t reactor::registrations() const
+{
+    return impl().registrations();
+}
+
+inline const reactor::impl_type& reactor::impl() const
+{
+    return *impl_;
+}
+
+inline reactor::impl_type& reactor::impl()
+{
+    return *impl_;
+}
+
+} // namespace cport
+
+#endif//__REACTOR_INL__
@@ -0,0 +1,31 @@
+#ifndef __REACTOR_IPP__
+#define __REACTOR_IPP__
+
+//
+// reactor.ipp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/reactor.hpp>
+#include <cport/completion_port.hpp>
+
+namespace cport {
+
+reactor::reactor(completion_port &port)
+    : impl_(std::make_shared<impl_type>(detail::get_impl(port)))
+{
+}
+
+reactor::~reactor()
+{
+    // The handlers may still hold the implementation
+    impl_->shutdown();
+}
+
+} // namespace cport
+
+#endif//__REACTOR_IPP__
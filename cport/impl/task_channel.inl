@@ -14,14 +14,41 @@
 #include <cport/task_scheduler.hpp>
 #include <cport/detail/impl_accessor.hpp>
 #include <cport/detail/task_handler_base.hpp>
+#include <cport/detail/trace.hpp>
 #include <type_traits>
 #include <iterator>
 
 namespace cport {
 
+namespace detail {
+
+struct task_channel_deleter {
+    void operator()(task_channel *p) const
+    {
+        p->~task_channel();
+        resource->deallocate(p, sizeof(task_channel), alignof(task_channel));
+    }
+
+    memory_resource *resource;
+};
+
+} // namespace detail
+
 inline task_channel::shared_ptr task_channel::make_shared(task_scheduler &ts)
 {
-    return shared_ptr(new task_channel(ts));
+    memory_resource *r = ts.get_memory_resource();
+    void *p = r->allocate(sizeof(task_channel), alignof(task_channel));
+    task_channel *channel = nullptr;
+    try {
+        channel = new (p) task_channel(ts);
+    }
+    catch (...) {
+        r->deallocate(p, sizeof(task_channel), alignof(task_channel));
+        throw;
+    }
+    // The control block is allocated from the resource as well
+    detail::task_channel_deleter d = { r };
+    return shared_ptr(channel, d, resource_allocator<task_channel>(r));
 }
 
 inline task_scheduler& task_channel::scheduler() const
@@ -57,13 +84,13 @@ inline task_t task_channel::enqueue_back(Handler&& h)
 
 inline std::size_t task_channel::enqueued_tasks() const
 {
-    std::unique_lock<std::mutex> lock(mutex_);
+    std::unique_lock<mutex_type> lock(mutex_);
     return pending_tasks_.size();
 }
 
 inline task_t task_channel::current_task() const
 {
-    std::unique_lock<std::mutex> lock(mutex_);
+    std::unique_lock<mutex_type> lock(mutex_);
     return current_task_;
 }
 
@@ -80,7 +107,7 @@ inline task_t task_channel::enqueue_task(TaskHandler&& th, CompletionHandler&& c
         using  CompletionHandlerP =
             util::protected_t<typename std::remove_reference<CompletionHandler>::type>;
 
-        auto wrapper = detail::create_task_handler(
+        auto wrapper = detail::create_task_handler(ts.resource(),
             std::bind(&task_channel::task_handler_proxy<TaskHandlerP>,
                 shared_from_this(),
                 placeholders::error,
@@ -90,8 +117,9 @@ inline task_t task_channel::enqueue_task(TaskHandler&& th, CompletionHandler&& c
                 placeholders::error,
                 CompletionHandlerP(std::forward<CompletionHandler>(ch))),
             opid);
+        detail::trace(detail::trace_event::async, opid);
 
-        std::unique_lock<std::mutex> lock(mutex_);
+        std::unique_lock<mutex_type> lock(mutex_);
         if (current_task_) 
             *it++ = wrapper;
         else
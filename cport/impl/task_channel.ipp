@@ -38,7 +38,9 @@ struct find_task_pred {
 } // namespace detail
 
 task_channel::task_channel(task_scheduler &ts)
-: ts_(ts)
+: pending_tasks_(task_deque::allocator_type(ts.get_memory_resource()))
+, canceled_tasks_(task_deque::allocator_type(ts.get_memory_resource()))
+, ts_(ts)
 {
 }
 
@@ -46,7 +48,7 @@ bool task_channel::cancel(const task_t &task)
 {
     bool canceled = false;
 
-    std::unique_lock<std::mutex> lock(mutex_);
+    std::unique_lock<mutex_type> lock(mutex_);
 
     if (task == current_task_)
     {
@@ -68,6 +70,7 @@ bool task_channel::cancel(const task_t &task)
 
         if (it != pending_tasks_.end())
         {
+            detail::trace(detail::trace_event::cancel, (*it)->id());
             canceled_tasks_.push_back(*it);
             pending_tasks_.erase(it);
             canceled = true;
@@ -80,7 +83,7 @@ std::size_t task_channel::cancel_all()
 {
     std::size_t count = 0;
 
-    std::unique_lock<std::mutex> lock(mutex_);
+    std::unique_lock<mutex_type> lock(mutex_);
 
     if (current_task_)
     {
@@ -92,6 +95,9 @@ std::size_t task_channel::cancel_all()
         }
     }
 
+    for (const detail::task_handler_base *h : pending_tasks_)
+        detail::trace(detail::trace_event::cancel, h->id());
+
     std::copy(pending_tasks_.begin(), pending_tasks_.end()
         , std::back_insert_iterator<task_deque>(canceled_tasks_));
 
@@ -100,7 +106,7 @@ std::size_t task_channel::cancel_all()
     return count;
 }
 
-void task_channel::enqueue_task(detail::task_handler_base *h, std::unique_lock<std::mutex> &lock)
+void task_channel::enqueue_task(detail::task_handler_base *h, std::unique_lock<mutex_type> &lock)
 {
     assert(lock.owns_lock());
     current_task_ = task_t(h->id());
@@ -108,7 +114,7 @@ void task_channel::enqueue_task(detail::task_handler_base *h, std::unique_lock<s
     detail::get_impl(ts_).enqueue_task(h);
 }
 
-void task_channel::complete_task(detail::task_handler_base *h, std::unique_lock<std::mutex> &lock)
+void task_channel::complete_task(detail::task_handler_base *h, std::unique_lock<mutex_type> &lock)
 {
     assert(lock.owns_lock());
     current_task_ = task_t(h->id());
@@ -119,7 +125,7 @@ void task_channel::complete_task(detail::task_handler_base *h, std::unique_lock<
 void task_channel::enqueue_next_task()
 {
     // First handle canceled tasks
-    std::unique_lock<std::mutex> lock(mutex_);
+    std::unique_lock<mutex_type> lock(mutex_);
 
     if (!canceled_tasks_.empty())
     {
@@ -133,6 +139,7 @@ void task_channel::enqueue_next_task()
     {
         detail::task_handler_base *h = pending_tasks_.front();
         pending_tasks_.pop_front();
+        detail::trace(detail::trace_event::channel_handoff, h->id());
         enqueue_task(h, lock);
         return;
     }
@@ -49,7 +49,7 @@ inline task_t task_channel_group<Key>::enqueue_back(const key_type& key, TaskHan
 template <typename Key>
 inline task_channel::shared_ptr task_channel_group<Key>::get_channel(const key_type &key)
 {
-    std::unique_lock<std::mutex> lock(mtx_);
+    std::unique_lock<mutex_type> lock(mtx_);
 
     auto i = groups_.find(key);
 
@@ -72,7 +72,7 @@ inline task_channel::shared_ptr task_channel_group<Key>::erase(const key_type& k
 {
     task_channel::shared_ptr channel;
 
-    std::unique_lock<std::mutex> lock(mtx_);
+    std::unique_lock<mutex_type> lock(mtx_);
 
     auto i = groups_.find(key);
 
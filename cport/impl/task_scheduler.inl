@@ -46,6 +46,41 @@ inline std::size_t task_scheduler::packaged_tasks() const
     return impl().packaged_tasks();
 }
 
+inline void task_scheduler::set_wait_policy(const wait_policy &wp)
+{
+    impl().set_wait_policy(wp);
+}
+
+inline wait_policy task_scheduler::get_wait_policy() const
+{
+    return impl().get_wait_policy();
+}
+
+inline wait_stats task_scheduler::get_wait_stats() const
+{
+    return impl().get_wait_stats();
+}
+
+inline memory_resource* task_scheduler::get_memory_resource() const
+{
+    return &impl().resource();
+}
+
+inline scheduling_policy task_scheduler::get_scheduling_policy() const
+{
+    return impl().policy();
+}
+
+inline scheduler_metrics task_scheduler::snapshot() const
+{
+    return impl().snapshot();
+}
+
+inline task_latency task_scheduler::latency() const
+{
+    return impl().latency();
+}
+
 inline const task_scheduler::impl_type& task_scheduler::impl() const
 {
     return impl_;
@@ -40,6 +40,27 @@ task_scheduler::task_scheduler(completion_port &port,
 {
 }
 
+task_scheduler::task_scheduler(completion_port &port,
+    std::size_t concurrency_hint, worker_context_prototype wcp,
+    memory_resource &r)
+    : impl_(detail::get_impl(port), concurrency_hint, wcp, &r), cp_(port)
+{
+}
+
+task_scheduler::task_scheduler(completion_port &port,
+    std::size_t concurrency_hint, scheduling_policy policy)
+    : impl_(detail::get_impl(port), concurrency_hint, detail::default_context,
+        nullptr, policy), cp_(port)
+{
+}
+
+task_scheduler::task_scheduler(completion_port &port,
+    std::size_t concurrency_hint, worker_context_prototype wcp,
+    memory_resource &r, scheduling_policy policy)
+    : impl_(detail::get_impl(port), concurrency_hint, wcp, &r, policy), cp_(port)
+{
+}
+
 
 } // namespace cport
 
@@ -0,0 +1,127 @@
+#ifndef __TRACE_IPP__
+#define __TRACE_IPP__
+
+//
+// trace.ipp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/trace.hpp>
+#include <set>
+
+namespace cport {
+
+namespace detail {
+
+inline const char* trace_event_name(trace_event e)
+{
+    switch (e) {
+    case trace_event::async: return "async";
+    case trace_event::enqueue: return "enqueue";
+    case trace_event::start: return "execute";
+    case trace_event::end: return "execute";
+    case trace_event::post_complete: return "post_complete";
+    case trace_event::completion_begin: return "completion";
+    case trace_event::completion_end: return "completion";
+    case trace_event::cancel: return "cancel";
+    case trace_event::channel_handoff: return "channel_handoff";
+    }
+    return "unknown";
+}
+
+// Write the time in microseconds, relative to the first event
+inline void write_trace_time(std::ostream &os, std::uint64_t ns)
+{
+    const char fraction[] = {
+        static_cast<char>('0' + ns / 100 % 10),
+        static_cast<char>('0' + ns / 10 % 10),
+        static_cast<char>('0' + ns % 10),
+        '\0'
+    };
+    os << ns / 1000 << '.' << fraction;
+}
+
+} // namespace detail
+
+void trace_recorder::start(std::size_t events_per_thread)
+{
+    detail::trace_registry::instance().set_capacity(events_per_thread);
+    detail::trace_flag().store(true, std::memory_order_relaxed);
+}
+
+void trace_recorder::stop()
+{
+    detail::trace_flag().store(false, std::memory_order_relaxed);
+}
+
+void trace_recorder::clear()
+{
+    detail::trace_registry::instance().clear();
+}
+
+std::size_t trace_recorder::write_chrome_trace(std::ostream &os)
+{
+    using detail::trace_event;
+
+    const std::vector<detail::trace_buffer::record> records =
+        detail::trace_registry::instance().read();
+    const std::uint64_t origin = records.empty() ? 0 : records.front().time;
+
+    os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    const char *separator = "\n";
+
+    std::set<std::size_t> threads;
+    for (const auto &r : records) {
+        if (threads.insert(r.thread).second) {
+            os << separator << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+               << r.thread << ",\"args\":{\"name\":\"cport thread " << r.thread << "\"}}";
+            separator = ",\n";
+        }
+    }
+
+    for (const auto &r : records) {
+        const char *phase = "i";
+        switch (r.type) {
+        case trace_event::start:
+        case trace_event::completion_begin:
+            phase = "B";
+            break;
+        case trace_event::end:
+        case trace_event::completion_end:
+            phase = "E";
+            break;
+        default:
+            break;
+        }
+
+        os << separator << "{\"name\":\"" << detail::trace_event_name(r.type)
+           << "\",\"cat\":\"task\",\"ph\":\"" << phase << '"';
+        if (phase[0] == 'i')
+            os << ",\"s\":\"t\"";
+        os << ",\"ts\":";
+        detail::write_trace_time(os, r.time - origin);
+        os << ",\"pid\":1,\"tid\":" << r.thread
+           << ",\"args\":{\"id\":" << r.id << "}}";
+        separator = ",\n";
+
+        // Each task has an async track from its submission to the end of
+        //  its completion handler
+        if (r.type == trace_event::async || r.type == trace_event::completion_end) {
+            os << ",\n{\"name\":\"task\",\"cat\":\"task\",\"ph\":\""
+               << (r.type == trace_event::async ? 'b' : 'e')
+               << "\",\"id\":" << r.id << ",\"ts\":";
+            detail::write_trace_time(os, r.time - origin);
+            os << ",\"pid\":1,\"tid\":" << r.thread << '}';
+        }
+    }
+    os << "\n]}\n";
+    return records.size();
+}
+
+} // namespace cport
+
+#endif // __TRACE_IPP__
@@ -0,0 +1,88 @@
+#ifndef __LATENCY_HISTOGRAM_HPP__
+#define __LATENCY_HISTOGRAM_HPP__
+
+//
+// latency_histogram.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/config.hpp>
+#include <cport/detail/histogram_buckets.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cport {
+
+namespace detail {
+class concurrent_histogram;
+}
+
+/// A snapshot of a histogram of latencies.
+/**
+ * The latencies are counted in logarithmic buckets with linear sub-buckets,
+ *  as in HdrHistogram. A reported value is within 3.1% of the recorded
+ *  one. min() and max() are exact. Latencies above about 18 minutes are
+ *  counted as 18 minutes.
+ */
+class latency_histogram {
+public:
+    /// Construct an empty histogram.
+    CPORT_DECL_TYPE latency_histogram();
+
+    /// Get the number of recorded latencies.
+    std::uint64_t count() const;
+
+    /// Get the lowest recorded latency, 0 if the histogram is empty.
+    std::chrono::nanoseconds min() const;
+
+    /// Get the highest recorded latency, 0 if the histogram is empty.
+    std::chrono::nanoseconds max() const;
+
+    /// Get the mean of the recorded latencies, 0 if the histogram is empty.
+    CPORT_DECL_TYPE std::chrono::nanoseconds mean() const;
+
+    /// Get the latency at a percentile.
+    /**
+     * @param p The percentile, from 0 to 100. For example 99.9
+     *
+     * @returns The highest latency in the bucket which contains the
+     *  percentile, limited by max(), or min() for the percentile 0.
+     *  0 if the histogram is empty.
+     */
+    CPORT_DECL_TYPE std::chrono::nanoseconds percentile(double p) const;
+
+    /// Add a latency.
+    CPORT_DECL_TYPE void record(std::chrono::nanoseconds latency);
+
+    /// Add the latencies recorded by another histogram.
+    CPORT_DECL_TYPE void merge(const latency_histogram &other);
+
+    /// Get the number of latencies in each bucket.
+    const std::vector<std::uint64_t>& buckets() const;
+
+    /// Get the highest latency which falls in a bucket.
+    static std::chrono::nanoseconds bucket_value(std::size_t bucket);
+
+private:
+    friend class detail::concurrent_histogram;
+
+    std::vector<std::uint64_t> buckets_;
+    std::uint64_t count_;
+    std::uint64_t min_;
+    std::uint64_t max_;
+};
+
+} // namespace cport
+
+#include <cport/impl/latency_histogram.inl>
+#ifdef CPORT_HEADER_ONLY_LIB
+#include <cport/impl/latency_histogram.ipp>
+#endif//CPORT_HEADER_ONLY_LIB
+
+#endif // __LATENCY_HISTOGRAM_HPP__
@@ -0,0 +1,89 @@
+#ifndef __LOCK_PROFILER_HPP__
+#define __LOCK_PROFILER_HPP__
+
+//
+// lock_profiler.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/config.hpp>
+#include <cport/detail/profiled_mutex.hpp>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace cport {
+
+/// The lock statistics of the internal mutexes declared at one place.
+/**
+ * All instances of a mutex member are accounted to the same site, e.g. the
+ *  guards of all task channels to "task_channel::mutex_". The counters are
+ *  monotonic since the first use of the site.
+ */
+struct lock_stats {
+    /// The name of the site.
+    const char *site;
+
+    /// The number of times the mutexes were locked.
+    std::uint64_t acquisitions;
+
+    /// The number of acquisitions which had to wait for another owner.
+    std::uint64_t contended;
+
+    /// The total time spent waiting for the mutexes.
+    std::chrono::nanoseconds wait_time;
+
+    /// The total time the mutexes were held.
+    /**
+     * The time a thread waits on a condition variable with the mutex is
+     *  not included.
+     */
+    std::chrono::nanoseconds hold_time;
+};
+
+/// Reports the contention of the internal mutexes of the library.
+/**
+ * The profiled sites are the guards of completion_port, task_scheduler,
+ *  task_channel, task_channel_group and of the depots of the handler pool.
+ *
+ * The profiling is enabled by building the library and its users with
+ *  CPORT_ENABLE_LOCK_PROFILING. It reads the steady clock on each lock and
+ *  unlock, so it is meant for diagnostic builds. Otherwise the sites are
+ *  plain std::mutex and the reports are empty.
+ */
+class lock_profiler {
+public:
+    /// Test if the library is built with the lock profiling.
+    static bool enabled();
+
+    /// Take a snapshot of the sites used so far.
+    /**
+     * @returns The statistics of the sites, the longest total wait first.
+     */
+    CPORT_DECL_TYPE static std::vector<lock_stats> snapshot();
+
+    /// Write a snapshot as a text table, one site per line.
+    CPORT_DECL_TYPE static void write_report(std::ostream &os);
+};
+
+inline bool lock_profiler::enabled()
+{
+#ifdef CPORT_HAS_LOCK_PROFILING
+    return true;
+#else
+    return false;
+#endif // CPORT_HAS_LOCK_PROFILING
+}
+
+} // namespace cport
+
+#ifdef CPORT_HEADER_ONLY_LIB
+#include <cport/impl/lock_profiler.ipp>
+#endif//CPORT_HEADER_ONLY_LIB
+
+#endif // __LOCK_PROFILER_HPP__
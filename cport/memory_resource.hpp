@@ -0,0 +1,186 @@
+#ifndef __MEMORY_RESOURCE_HPP__
+#define __MEMORY_RESOURCE_HPP__
+
+//
+// memory_resource.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/config.hpp>
+#include <cstddef>
+#include <mutex>
+#include <new>
+
+namespace cport {
+
+/// An interface of memory resources, modeled after std::pmr::memory_resource.
+/**
+ * A completion_port and a task_scheduler allocate their handlers and
+ *  queues from a memory resource. The resource is used by all threads
+ *  which post handlers, schedule tasks or run the port, so its
+ *  implementation must be thread-safe.
+ */
+class memory_resource {
+public:
+    virtual ~memory_resource()
+    {
+    }
+
+    /// Allocate storage of at least bytes with the specified alignment.
+    void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t))
+    {
+        return do_allocate(bytes, alignment);
+    }
+
+    /// Deallocate storage returned by allocate() with the same arguments.
+    void deallocate(void *p, std::size_t bytes, std::size_t alignment = alignof(std::max_align_t))
+    {
+        do_deallocate(p, bytes, alignment);
+    }
+
+    /// Return true if the storage allocated from one resource can be
+    ///  deallocated by the other.
+    bool is_equal(const memory_resource &other) const
+    {
+        return this == &other || do_is_equal(other);
+    }
+
+private:
+    virtual void* do_allocate(std::size_t bytes, std::size_t alignment) = 0;
+
+    virtual void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) = 0;
+
+    virtual bool do_is_equal(const memory_resource &other) const
+    {
+        return this == &other;
+    }
+};
+
+/// Get the default memory resource.
+/**
+ * It allocates from the handler_pool, unless the pool is disabled by
+ *  CPORT_DISABLE_OBJ_MEMORY_POOL, and from the global operator new
+ *  otherwise. The ports and schedulers constructed without a resource
+ *  use it.
+ */
+CPORT_DECL_TYPE memory_resource* get_default_resource();
+
+/// A memory resource which releases its memory only when destroyed.
+/**
+ * The memory is allocated from an upstream resource in growing chunks, and
+ *  handed out by bumping a pointer. Deallocation has no effect. It suits a
+ *  port or a scheduler whose handlers are all created and destroyed within
+ *  the lifetime of a request, an arena of the whole subsystem.
+ */
+class monotonic_buffer_resource : public memory_resource {
+public:
+    /// Construct the resource.
+    /**
+     * @param initial_size The size of the first chunk taken from upstream.
+     *
+     * @param upstream The resource to take the chunks from.
+     */
+    CPORT_DECL_TYPE explicit monotonic_buffer_resource(
+        std::size_t initial_size = 4096,
+        memory_resource *upstream = get_default_resource());
+
+    /// Release all memory.
+    CPORT_DECL_TYPE ~monotonic_buffer_resource();
+
+    monotonic_buffer_resource(const monotonic_buffer_resource&) = delete;
+
+    monotonic_buffer_resource& operator=(const monotonic_buffer_resource&) = delete;
+
+    /// Return all chunks to the upstream resource.
+    /**
+     * The memory allocated from the resource must no longer be in use.
+     */
+    CPORT_DECL_TYPE void release();
+
+    /// Get the upstream resource.
+    memory_resource* upstream_resource() const
+    {
+        return upstream_;
+    }
+
+    /// Get the bytes taken from the upstream resource.
+    CPORT_DECL_TYPE std::size_t upstream_bytes() const;
+
+private:
+    struct chunk {
+        chunk *next;
+        std::size_t size;
+    };
+
+    CPORT_DECL_TYPE void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+
+    CPORT_DECL_TYPE void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override;
+
+    memory_resource *upstream_;
+    mutable std::mutex mutex_;
+    chunk *chunks_;
+    char *current_;
+    std::size_t available_;
+    std::size_t next_size_;
+    std::size_t upstream_bytes_;
+};
+
+/// An allocator of the standard containers which uses a memory_resource.
+template <typename T>
+class resource_allocator {
+public:
+    typedef T value_type;
+
+    resource_allocator(memory_resource *r = get_default_resource()) noexcept
+        : resource_(r)
+    {
+    }
+
+    template <typename U>
+    resource_allocator(const resource_allocator<U> &other) noexcept
+        : resource_(other.resource())
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T *>(resource_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *p, std::size_t n)
+    {
+        resource_->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    memory_resource* resource() const noexcept
+    {
+        return resource_;
+    }
+
+private:
+    memory_resource *resource_;
+};
+
+template <typename T, typename U>
+inline bool operator==(const resource_allocator<T> &a, const resource_allocator<U> &b)
+{
+    return a.resource()->is_equal(*b.resource());
+}
+
+template <typename T, typename U>
+inline bool operator!=(const resource_allocator<T> &a, const resource_allocator<U> &b)
+{
+    return !(a == b);
+}
+
+} // namespace cport
+
+#ifdef CPORT_HEADER_ONLY_LIB
+#include <cport/impl/memory_resource.ipp>
+#endif//CPORT_HEADER_ONLY_LIB
+
+#endif // __MEMORY_RESOURCE_HPP__
@@ -0,0 +1,106 @@
+#ifndef __METRICS_HPP__
+#define __METRICS_HPP__
+
+//
+// metrics.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/latency_histogram.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace cport {
+
+/// A snapshot of the runtime metrics of a completion_port.
+/**
+ * The counters are updated with relaxed atomic operations on per-thread
+ *  shards, and are summed when the snapshot is taken. They are monotonic
+ *  since the port is constructed. While other threads use the port the
+ *  values are approximate: a handler may be counted as completed before it
+ *  is counted as posted.
+ *
+ * All counters are zero if the library is built with CPORT_DISABLE_METRICS,
+ *  only the number of ready handlers is read from the queues.
+ */
+struct port_metrics {
+    /// The number of handlers posted, including the expired timers.
+    std::uint64_t posted;
+
+    /// The number of handlers dispatched.
+    std::uint64_t dispatched;
+
+    /// The number of handlers invoked.
+    std::uint64_t completed;
+
+    /// The number of ready handlers when the snapshot was taken.
+    std::size_t ready;
+
+    /// The highest number of ready handlers, of one shard in a sharded port.
+    std::size_t ready_high_water;
+};
+
+/// A snapshot of the runtime metrics of a task_scheduler.
+/**
+ * @see port_metrics
+ */
+struct scheduler_metrics {
+    /// The number of tasks enqueued.
+    std::uint64_t enqueued;
+
+    /// The number of tasks executed.
+    std::uint64_t executed;
+
+    /// The number of tasks canceled before they were executed.
+    std::uint64_t canceled;
+
+    /// The number of packaged tasks when the snapshot was taken.
+    std::size_t pending;
+
+    /// The highest number of packaged tasks.
+    std::size_t pending_high_water;
+
+    /// The time the worker threads spent executing tasks.
+    std::chrono::nanoseconds busy_time;
+
+    /// The time the worker threads spent waiting for tasks.
+    /**
+     * A wait is accounted for when it ends, so the current waits of idle
+     *  workers are not included.
+     */
+    std::chrono::nanoseconds idle_time;
+};
+
+/// The latencies of the tasks of a task_scheduler.
+/**
+ * Comparing the delays tells whether the tail latency of the tasks comes
+ *  from too few workers, from the tasks themselves, or from too few
+ *  threads running the completion port.
+ *
+ * The histograms are empty if the library is built with
+ *  CPORT_DISABLE_METRICS.
+ */
+struct task_latency {
+    /// From the task being enqueued to a worker picking it up.
+    latency_histogram queueing;
+
+    /// The execution of the task handlers, including posting their
+    ///  completion handlers.
+    latency_histogram execution;
+
+    /// From the completion handler being posted to it being invoked.
+    /**
+     * The delay is recorded by the completion port, for the tasks of all
+     *  schedulers using the port, including the canceled ones.
+     */
+    latency_histogram completion;
+};
+
+} // namespace cport
+
+#endif // __METRICS_HPP__
@@ -0,0 +1,111 @@
+#ifndef __POST_BATCH_HPP__
+#define __POST_BATCH_HPP__
+
+//
+// post_batch.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/completion_port.hpp>
+#include <vector>
+
+namespace cport {
+
+class error_code;
+class generic_error;
+
+/// Accumulates completion handlers and posts them to a port at once.
+/**
+ * Handlers added to the batch are not visible to the threads processing
+ *  the port until commit() is called. A commit inserts all accumulated
+ *  handlers in a single step and wakes at most one blocked thread per
+ *  handler. Each handler posted through the batch is counted as an enqueued
+ *  operation when added, so the port's wait() blocks until it is committed.
+ *
+ * The batch is not thread-safe. It commits on destruction.
+ */
+class post_batch {
+public:
+    /// Construct an empty batch associated with a port.
+    /**
+     * @param port The completion port to post the handlers to.
+     *
+     * @param capacity_hint The expected number of handlers per commit.
+     */
+    explicit post_batch(completion_port &port, std::size_t capacity_hint = 0);
+
+    /// Commit the handlers left and destruct the batch.
+    ~post_batch();
+
+    /// Disable copy constructor.
+    post_batch(const post_batch&) = delete;
+
+    /// Disable assignment operator.
+    post_batch& operator=(const post_batch&) = delete;
+
+    /// Add a completion handler to be dispatched on commit.
+    /**
+     * @param h A completion handler to be invoked.
+     *
+     * @param e An error to be passed when the handler is invoked.
+     */
+    template <typename Handler>
+    void dispatch(Handler&& h, const generic_error& e);
+
+    /// Add a completion handler to be dispatched on commit.
+    /**
+     * @param h A completion handler to be invoked.
+     */
+    template <typename Handler>
+    void dispatch(Handler&& h);
+
+    /// Add a completion handler to be posted on commit.
+    /**
+     * @param h A completion handler to be invoked.
+     *
+     * @param e An error to be passed when the handler is invoked.
+     */
+    template <typename Handler>
+    void post(Handler&& h, const generic_error& e);
+
+    /// Add a completion handler to be posted on commit.
+    /**
+     * @param h A completion handler to be invoked.
+     */
+    template <typename Handler>
+    void post(Handler&& h);
+
+    /// Post all accumulated handlers to the port.
+    /**
+     * @returns The number of handlers posted.
+     */
+    std::size_t commit();
+
+    /// Get the number of accumulated handlers.
+    std::size_t size() const;
+
+    /// Test if there are no accumulated handlers.
+    bool empty() const;
+
+private:
+    template <typename Handler>
+    void dispatch_handler(Handler&& h, const error_code& e);
+
+    template <typename Handler>
+    void post_handler(Handler&& h, const error_code& e);
+
+    void reserve_one();
+
+    completion_port::impl_type &port_impl_;
+    std::vector<detail::completion_handler_base *> handlers_;
+};
+
+} // namespace cport
+
+#include <cport/impl/post_batch.inl>
+
+#endif //__POST_BATCH_HPP__
@@ -0,0 +1,158 @@
+#ifndef __REACTOR_HPP__
+#define __REACTOR_HPP__
+
+//
+// reactor.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/config.hpp>
+
+#ifdef CPORT_HAS_EPOLL
+
+#include <cport/reactor_handle.hpp>
+#include <cport/detail/reactor_impl.hpp>
+#include <cport/detail/impl_accessor.hpp>
+#include <memory>
+
+namespace cport {
+
+class completion_port;
+
+/// Posts completion handlers when file descriptors become ready for I/O.
+/**
+ * The reactor registers file descriptors (sockets, pipes, eventfds, ...) in
+ *  an epoll set, served by a thread of its own. When a descriptor becomes
+ *  readable or writable, the completion handler of the registration is posted
+ *  to the completion_port, so non-blocking I/O is driven by the threads
+ *  running the port. Each registration is counted as an enqueued operation
+ *  of the port, so wait() blocks until it completes or is canceled.
+ *
+ * A descriptor could be registered only once at a time and it must stay
+ *  open until the registration completes or is canceled.
+ *
+ * If waiting for the events fails, all registrations are posted with the
+ *  system error and the later ones fail with it.
+ *
+ * @note Available on Linux only, unless CPORT_DISABLE_EPOLL is defined.
+ */
+class reactor {
+public:
+    /// Events a descriptor is registered for.
+    enum event_type {
+        /// The descriptor is readable, closed by the peer or has an error.
+        read = detail::reactor_impl::read_event,
+        /// The descriptor is writable or has an error.
+        write = detail::reactor_impl::write_event
+    };
+
+    /// Construct a reactor which posts handlers to a completion port.
+    /**
+     * @throw std::system_error if the epoll set can not be created.
+     */
+    CPORT_DECL_TYPE explicit reactor(completion_port &port);
+
+    /// Destruct the reactor.
+    /**
+     * The handlers of all registrations are posted with
+     *  operation_aborted error.
+     */
+    CPORT_DECL_TYPE ~reactor();
+
+    /// Disable copy constructor.
+    reactor(const reactor&) = delete;
+
+    /// Disable assignment operator.
+    reactor& operator=(const reactor&) = delete;
+
+    /// Wait once for a descriptor to become ready.
+    /**
+     * The handler is posted once, with no error when the descriptor becomes
+     *  ready for any of the events, or with operation_aborted error if the
+     *  registration is canceled. If the descriptor can not be registered the
+     *  handler is posted with the system error.
+     *
+     * @param fd The file descriptor.
+     *
+     * @param events A combination of read and write.
+     *
+     * @param h The completion handler to be invoked.
+     *
+     * @returns A registration identifier, invalid if the port is stopped
+     *  or the descriptor can not be registered.
+     */
+    template <typename Handler>
+    reactor_handle async_wait(int fd, int events, Handler&& h);
+
+    /// Watch a descriptor until the registration is canceled.
+    /**
+     * A copy of the handler is posted with no error each time the descriptor
+     *  is ready for any of the events. The descriptor is watched again only
+     *  after the handler returns, so the handler is never invoked concurrently
+     *  with itself and it should consume the data it was invoked for.
+     *  When the registration is canceled the handler is posted a last time
+     *  with operation_aborted error.
+     *
+     * @param fd The file descriptor.
+     *
+     * @param events A combination of read and write.
+     *
+     * @param h The completion handler to be invoked. Must be copy constructible.
+     *
+     * @returns A registration identifier, invalid if the port is stopped
+     *  or the descriptor can not be registered.
+     */
+    template <typename Handler>
+    reactor_handle watch(int fd, int events, Handler&& h);
+
+    /// Cancel a registration.
+    /**
+     * The completion handler is posted with operation_aborted error.
+     *  The method call has no effect if a one-shot registration has
+     *  already completed. If the handler of a watched descriptor is posted
+     *  or running, its aborted copy is posted after it returns, so the two
+     *  never run concurrently. The descriptor is not watched any more when
+     *  the method returns.
+     *
+     * @param r An identifier of the registration to be canceled.
+     *
+     * @returns true if the registration was canceled.
+     */
+    bool cancel(const reactor_handle &r);
+
+    /// Get the number of registrations which are not completed or canceled.
+    std::size_t registrations() const;
+
+    /// The implementation type.
+    typedef detail::reactor_impl impl_type;
+protected:
+    /// Get a const reference to the implementation type
+    const impl_type& impl() const;
+
+    /// Get a reference to the implementation type
+    impl_type& impl();
+private:
+    template<typename T>
+    friend const typename T::impl_type& detail::get_impl(const T&);
+
+    template<typename T>
+    friend typename T::impl_type& detail::get_impl(T&);
+
+    // Shared with the handlers of persistent registrations, which re-arm them
+    std::shared_ptr<impl_type> impl_;
+};
+
+} // namespace cport
+
+#include <cport/impl/reactor.inl>
+#ifdef CPORT_HEADER_ONLY_LIB
+#include <cport/impl/reactor.ipp>
+#endif//CPORT_HEADER_ONLY_LIB
+
+#endif // CPORT_HAS_EPOLL
+
+#endif//__REACTOR_HPP__
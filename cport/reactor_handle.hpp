@@ -0,0 +1,64 @@
+#ifndef __REACTOR_HANDLE_HPP__
+#define __REACTOR_HANDLE_HPP__
+
+//
+// reactor_handle.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cstdint>
+
+namespace cport {
+
+namespace detail {
+class reactor_impl;
+}
+
+/// Identifies a file descriptor registration made by a reactor.
+class reactor_handle {
+public:
+    /// Construct an invalid registration identifier.
+    reactor_handle()
+        : id_(0)
+    {
+    }
+
+    /// Return true if both objects identify the same registration.
+    bool operator==(const reactor_handle &r) const
+    {
+        return id_ == r.id_;
+    }
+
+    /// Return true if the objects identify different registrations.
+    bool operator!=(const reactor_handle &r) const
+    {
+        return !(*this == r);
+    }
+
+    /// Return true if the object identifies a registration.
+    /**
+     * The identifier stays valid after the registration completes or is canceled.
+     */
+    explicit operator bool() const
+    {
+        return id_ != 0;
+    }
+
+private:
+    friend class detail::reactor_impl;
+
+    explicit reactor_handle(std::uint64_t id)
+        : id_(id)
+    {
+    }
+
+    std::uint64_t id_;
+};
+
+} // namespace cport
+
+#endif //__REACTOR_HANDLE_HPP__
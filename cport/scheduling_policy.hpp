@@ -0,0 +1,41 @@
+#ifndef __SCHEDULING_POLICY_HPP__
+#define __SCHEDULING_POLICY_HPP__
+
+//
+// scheduling_policy.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+namespace cport {
+
+/// Describes how the workers of a task_scheduler obtain the tasks.
+enum class scheduling_policy {
+    /// All tasks are queued to one FIFO queue, guarded by a mutex.
+    /**
+     * The tasks start in the order they are scheduled. Above a few cores
+     *  the submission and the pickup of the tasks serialize on the mutex.
+     */
+    shared_queue,
+
+    /// Each worker has its own work-stealing deque.
+    /**
+     * The tasks scheduled by the workers themselves are pushed to the
+     *  deque of the worker, without locking, and the worker runs them
+     *  newest first. The tasks scheduled by other threads are pushed to
+     *  a shared injection queue, which the workers drain in batches in
+     *  FIFO order. An idle worker steals the oldest tasks of the others.
+     *
+     * The start order of the tasks is not specified. Canceling a task
+     *  briefly stops the workers from taking tasks while the deques are
+     *  searched.
+     */
+    work_stealing
+};
+
+} // namespace cport
+
+#endif //__SCHEDULING_POLICY_HPP__
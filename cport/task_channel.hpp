@@ -11,8 +11,10 @@
 //
 
 #include <cport/config.hpp>
+#include <cport/memory_resource.hpp>
 #include <cport/task_t.hpp>
 #include <cport/placeholders.hpp>
+#include <cport/detail/profiled_mutex.hpp>
 #include <deque>
 #include <mutex>
 #include <memory>
@@ -46,6 +48,7 @@ public:
      *  schedule task in sequential order.
      *
      * @returns A task_channel object wrapped in a std::shared_ptr.
+     *  The object is allocated from the memory resource of the scheduler.
      */
     static shared_ptr make_shared(task_scheduler &ts);
 
@@ -137,13 +140,17 @@ public:
     task_t current_task() const;
 
 private:
+    struct mutex_site {
+        static const char* name() { return "task_channel::mutex_"; }
+    };
+    typedef detail::site_mutex<mutex_site> mutex_type;
 
     template <typename TaskHandler, typename CompletionHandler, typename InsertIterator>
     task_t enqueue_task(TaskHandler&& th, CompletionHandler&& ch, InsertIterator& it);
 
-    CPORT_DECL_TYPE void enqueue_task(detail::task_handler_base *h, std::unique_lock<std::mutex> &lock);
+    CPORT_DECL_TYPE void enqueue_task(detail::task_handler_base *h, std::unique_lock<mutex_type> &lock);
 
-    CPORT_DECL_TYPE void complete_task(detail::task_handler_base *h, std::unique_lock<std::mutex> &lock);
+    CPORT_DECL_TYPE void complete_task(detail::task_handler_base *h, std::unique_lock<mutex_type> &lock);
 
     CPORT_DECL_TYPE void enqueue_next_task();
 
@@ -153,8 +160,9 @@ private:
     template <typename Handler>
     void completion_handler_proxy(const generic_error &e, Handler h);
 
-    mutable std::mutex mutex_;
-    typedef std::deque<detail::task_handler_base *> task_deque;
+    mutable mutex_type mutex_;
+    typedef std::deque<detail::task_handler_base *,
+        resource_allocator<detail::task_handler_base *>> task_deque;
     task_deque pending_tasks_;
     task_deque canceled_tasks_;
     task_t current_task_;
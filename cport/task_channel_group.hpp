@@ -11,6 +11,7 @@
 //
 
 #include <cport/task_channel.hpp>
+#include <cport/detail/profiled_mutex.hpp>
 #include <mutex>
 #include <unordered_map>
 
@@ -49,9 +50,14 @@ public:
     task_channel::shared_ptr erase(const key_type& key);
 
 private:
+    struct mtx_site {
+        static const char* name() { return "task_channel_group::mtx_"; }
+    };
+    typedef detail::site_mutex<mtx_site> mutex_type;
+
     task_scheduler& ts_;
     std::unordered_map<key_type, task_channel::shared_ptr> groups_;
-    std::mutex mtx_;
+    mutex_type mtx_;
 };
 
 } // namespace cport
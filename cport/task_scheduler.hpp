@@ -11,7 +11,11 @@
 //
 
 #include <cport/config.hpp>
+#include <cport/memory_resource.hpp>
+#include <cport/metrics.hpp>
+#include <cport/scheduling_policy.hpp>
 #include <cport/task_t.hpp>
+#include <cport/wait_policy.hpp>
 #include <cport/detail/task_scheduler_impl.hpp>
 #include <cport/detail/impl_accessor.hpp>
 #include <type_traits>
@@ -74,6 +78,54 @@ public:
     CPORT_DECL_TYPE task_scheduler(completion_port &port
         , std::size_t concurrency_hint, worker_context_prototype wcp);
 
+    /// Construct new task_scheduler object which allocates from a memory resource.
+    /**
+    * The task handlers and the queue of packaged tasks are allocated from
+    *  the resource instead of the resource of the port.
+    *
+    * @param port A port to use to dispatch completion handlers.
+    *
+    * @param concurrency_hint A number of worker threads to run.
+    *  0 = number of concurrent threads supported by the system.
+    *
+    * @param wcp A context of each worker thread.
+    *
+    * @param r The memory resource. It must outlive the scheduler.
+    */
+    CPORT_DECL_TYPE task_scheduler(completion_port &port
+        , std::size_t concurrency_hint, worker_context_prototype wcp
+        , memory_resource &r);
+
+    /// Construct new task_scheduler object with a scheduling policy.
+    /**
+    * @param port A port to use to dispatch completion handlers.
+    *
+    * @param concurrency_hint A number of worker threads to run.
+    *  0 = number of concurrent threads supported by the system.
+    *
+    * @param policy How the workers obtain the tasks.
+    */
+    CPORT_DECL_TYPE task_scheduler(completion_port &port
+        , std::size_t concurrency_hint, scheduling_policy policy);
+
+    /// Construct new task_scheduler object with a scheduling policy,
+    ///  which allocates from a memory resource.
+    /**
+    * @param port A port to use to dispatch completion handlers.
+    *
+    * @param concurrency_hint A number of worker threads to run.
+    *  0 = number of concurrent threads supported by the system.
+    *
+    * @param wcp A context of each worker thread.
+    *
+    * @param r The memory resource. It must outlive the scheduler.
+    *
+    * @param policy How the workers obtain the tasks.
+    */
+    CPORT_DECL_TYPE task_scheduler(completion_port &port
+        , std::size_t concurrency_hint, worker_context_prototype wcp
+        , memory_resource &r, scheduling_policy policy);
+
     /// Disable copy constructor.
     task_scheduler(const task_scheduler&) = delete;
 
@@ -113,6 +165,12 @@ public:
      * Completion handler is called with operation_aborted error code.
      *  The method call has no effect if task's handler is already executed.
      *
+     * With scheduling_policy::work_stealing a task which has left the
+     *  injection queue is searched in the deques of all workers. The
+     *  call stops every worker from taking tasks until the search ends.
+     *  Its cost grows with the number of queued tasks and concurrent
+     *  cancels are serialized, so it does not suit frequent cancellation.
+     *
      * @param task An identifier to a task to be canceled.
      *
      * @returns true if the task associated with the task identifier
@@ -125,6 +183,9 @@ public:
      * Completion handler of each task is called
      *  with operation_aborted error code.
      *
+     * With scheduling_policy::work_stealing the workers stop taking tasks
+     *  while their deques are drained.
+     *
      * @returns The number of tasks canceled.
      */
     std::size_t cancel_all();
@@ -133,6 +194,41 @@ public:
     ///  executing are not included.
     std::size_t packaged_tasks() const;
 
+    /// Set how idle worker threads wait for tasks before they are blocked.
+    /**
+     * @param wp The wait policy.
+     */
+    void set_wait_policy(const wait_policy &wp);
+
+    /// Get the current wait policy of the worker threads.
+    wait_policy get_wait_policy() const;
+
+    /// Get the number of worker waits satisfied in each phase of the wait policy.
+    wait_stats get_wait_stats() const;
+
+    /// Get the memory resource the scheduler allocates from.
+    memory_resource* get_memory_resource() const;
+
+    /// Get the scheduling policy of the workers.
+    scheduling_policy get_scheduling_policy() const;
+
+    /// Get a snapshot of the runtime metrics of the scheduler.
+    /**
+     * The method does not lock the queue of the scheduler.
+     *
+     * @see scheduler_metrics
+     */
+    scheduler_metrics snapshot() const;
+
+    /// Get the histograms of the latencies of the tasks.
+    /**
+     * The histograms are recorded without locking and could be queried
+     *  at any time.
+     *
+     * @see task_latency
+     */
+    task_latency latency() const;
+
 protected:
     /// Get a const reference to the implementation type
     const impl_type& impl() const;
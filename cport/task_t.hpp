@@ -68,7 +68,7 @@ public:
     /// Return true if the objects contains a valid operation identifier.
     explicit operator bool() const
     {
-        return *this != task_t();
+        return id_.valid();
     }
 
 #ifdef CPORT_ENABLE_TASK_STATUS
@@ -79,7 +79,7 @@ public:
     }
 
     /// Block the calling thread until the task completes.
-    void wait()
+    void wait() const
     {
         id_.wait();
     }
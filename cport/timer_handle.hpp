@@ -0,0 +1,70 @@
+#ifndef __TIMER_HANDLE_HPP__
+#define __TIMER_HANDLE_HPP__
+
+//
+// timer_handle.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cstddef>
+
+namespace cport {
+
+namespace detail {
+struct timer_node;
+class timer_service_impl;
+}
+
+/// Identifies a completion handler scheduled by post_after() or post_at().
+class timer_handle {
+public:
+    /// Construct an invalid timer identifier.
+    timer_handle()
+        : service_(nullptr), node_(nullptr), generation_(0)
+    {
+    }
+
+    /// Return true if both objects identify the same timer.
+    bool operator==(const timer_handle &t) const
+    {
+        return service_ == t.service_ && node_ == t.node_
+            && generation_ == t.generation_;
+    }
+
+    /// Return true if the objects identify different timers.
+    bool operator!=(const timer_handle &t) const
+    {
+        return !(*this == t);
+    }
+
+    /// Return true if the object identifies a scheduled timer.
+    /**
+     * The identifier stays valid after the timer expires or is canceled.
+     */
+    explicit operator bool() const
+    {
+        return node_ != nullptr;
+    }
+
+private:
+    friend class detail::timer_service_impl;
+
+    timer_handle(detail::timer_service_impl *service, detail::timer_node *node,
+        std::size_t generation)
+        : service_(service), node_(node), generation_(generation)
+    {
+    }
+
+    // The service which owns the node, a handle of another port is ignored
+    detail::timer_service_impl *service_;
+    detail::timer_node *node_;
+    std::size_t generation_;
+};
+
+} // namespace cport
+
+#endif //__TIMER_HANDLE_HPP__
@@ -0,0 +1,80 @@
+#ifndef __TRACE_HPP__
+#define __TRACE_HPP__
+
+//
+// trace.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cport/config.hpp>
+#include <cport/detail/trace.hpp>
+#include <cstddef>
+#include <ostream>
+
+namespace cport {
+
+/// Records the lifecycle events of the tasks of all task schedulers.
+/**
+ * While the recorder is started, each thread appends the events of the
+ *  tasks it handles to its own ring buffer, without locking. The events
+ *  are: async, enqueue, start and end of the execution, post_complete,
+ *  begin and end of the completion handler invocation, cancel and the
+ *  hand-off of a task_channel to its next task. When a buffer is full the
+ *  oldest events of the thread are overwritten. The buffers of the last
+ *  16 threads which exited are kept, the next threads reuse the older ones.
+ *
+ * The events are written as Chrome trace JSON, which could be loaded in
+ *  Perfetto (ui.perfetto.dev) or chrome://tracing. Each thread has a
+ *  track with the executions and completion invocations, and each task
+ *  has an async track from enqueue to the end of its completion handler.
+ *  All events carry the operation id of the task.
+ *
+ * While the recorder is stopped, each event costs a load and a well
+ *  predicted branch. The recording is compiled out if the library is
+ *  built with CPORT_DISABLE_TRACING.
+ */
+class trace_recorder {
+public:
+    /// Start recording.
+    /**
+     * @param events_per_thread The capacity of the buffers of the threads
+     *  which record their first event after the call. Rounded up to a
+     *  power of two.
+     */
+    CPORT_DECL_TYPE static void start(std::size_t events_per_thread = 65536);
+
+    /// Stop recording. The recorded events are kept.
+    CPORT_DECL_TYPE static void stop();
+
+    /// Test if the recorder is started.
+    static bool enabled();
+
+    /// Discard the recorded events.
+    CPORT_DECL_TYPE static void clear();
+
+    /// Write the recorded events as Chrome trace JSON.
+    /**
+     * The recorder could be running. The events overwritten while they
+     *  are written are skipped.
+     *
+     * @returns The number of events written.
+     */
+    CPORT_DECL_TYPE static std::size_t write_chrome_trace(std::ostream &os);
+};
+
+inline bool trace_recorder::enabled()
+{
+    return detail::trace_enabled();
+}
+
+} // namespace cport
+
+#ifdef CPORT_HEADER_ONLY_LIB
+#include <cport/impl/trace.ipp>
+#endif//CPORT_HEADER_ONLY_LIB
+
+#endif // __TRACE_HPP__
@@ -0,0 +1,57 @@
+#ifndef __WAIT_POLICY_HPP__
+#define __WAIT_POLICY_HPP__
+
+//
+// wait_policy.hpp
+//
+// Copyright (c) 2013-2016 Orlin Hristov (orlin dot hristov at gmail dot com)
+//
+// Distributed under the Apache License, Version 2.0
+// visit http://www.apache.org/licenses/ for more information.
+//
+
+#include <cstddef>
+
+namespace cport {
+
+/// Describes how a thread waits for work before it is blocked.
+/**
+ * An idle thread first polls for work spin_count times, executing a CPU
+ *  pause instruction between the polls. Then it polls yield_count times,
+ *  yielding its time slice between the polls. Finally it is blocked until
+ *  notified. The default policy blocks the thread immediately.
+ */
+struct wait_policy {
+    /// Construct a policy.
+    /**
+     * @param spins The number of polls separated by a pause instruction.
+     *
+     * @param yields The number of polls separated by a thread yield.
+     */
+    explicit wait_policy(std::size_t spins = 0, std::size_t yields = 0)
+        : spin_count(spins), yield_count(yields)
+    {
+    }
+
+    /// The number of polls separated by a pause instruction.
+    std::size_t spin_count;
+
+    /// The number of polls separated by a thread yield.
+    std::size_t yield_count;
+};
+
+/// Counts how idle threads obtained work.
+struct wait_stats {
+    /// The number of waits satisfied while spinning.
+    std::size_t spins;
+
+    /// The number of waits satisfied while yielding.
+    std::size_t yields;
+
+    /// The number of times a thread was blocked.
+    std::size_t parks;
+};
+
+} // namespace cport
+
+#endif //__WAIT_POLICY_HPP__
@@ -0,0 +1,664 @@
+#include <cport/completion_port.hpp>
+#include <cport/task_scheduler.hpp>
+#include <cport/task_channel.hpp>
+#include <cport/task_channel_group.hpp>
+#include <cport/util/event.hpp>
+#include <cport/util/thread_group.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// Measures the throughput of the scheduling paths of the library in wall
+//  clock time. Each scenario is run for every combination of the given
+//  parameters, and the results are written as a table, CSV or JSON.
+//
+//  benchmark [--scenarios=async,channel,group,cancel,post,dispatch,
+//      run_batch,pull_n,round_trip,generic_error,error_code]
+//      [--producers=1] [--workers=1] [--runners=1] [--shards=1] [--payload=0]
+//      [--completion=1] [--policy=shared_queue] [--batch=1,2,4,...,256]
+//      [--items=200000] [--repeat=3] [--format=table|csv|json] [--output=file]
+//
+// The parameters accept comma separated lists. The producers submit the
+//  items from their own threads, the workers are the threads of the
+//  task_scheduler and the runners are the threads running the port, which
+//  has the given number of shards (0 for one per hardware thread). The
+//  payload is the size in bytes of the state captured by each handler,
+//  and completion tells whether the tasks have a completion handler. The
+//  policy is the scheduling policy of the task_scheduler, shared_queue or
+//  work_stealing. The post and dispatch scenarios use no scheduler, so
+//  they are run once per producers, runners and payload.
+//
+// The run_batch and pull_n scenarios drain the port in batches of the
+//  batch sizes. In run_batch the runners call run_batch() while the
+//  producers post. In pull_n the items are posted before the clock starts
+//  and the producers drain them with pull_n().
+//
+// The remaining scenarios measure the success path of the completions in
+//  the producer threads, with no runners. round_trip posts a handler which
+//  reads its error and pulls it at once. generic_error and error_code copy
+//  a successful result of the respective type, the generic_error facade
+//  and the compact error_code carried by the port.
+
+namespace {
+
+const char *const all_scenarios[] = {
+    "async", "channel", "group", "cancel", "post", "dispatch",
+    "run_batch", "pull_n", "round_trip", "generic_error", "error_code"
+};
+
+struct config {
+    std::string scenario;
+    std::size_t producers;
+    std::size_t workers;
+    std::size_t runners;
+    std::size_t shards;
+    std::size_t payload;
+    bool completion;
+    std::string policy;
+    std::size_t batch;
+    std::size_t items;
+
+    bool uses_scheduler() const
+    {
+        return scenario == "async" || scenario == "channel"
+            || scenario == "group" || scenario == "cancel";
+    }
+
+    bool uses_runners() const
+    {
+        return uses_scheduler() || scenario == "post" || scenario == "dispatch"
+            || scenario == "run_batch";
+    }
+
+    bool uses_batch() const
+    {
+        return scenario == "run_batch" || scenario == "pull_n";
+    }
+
+    bool uses_port() const
+    {
+        return scenario != "generic_error" && scenario != "error_code";
+    }
+
+    std::tuple<std::string, std::size_t, std::size_t, std::size_t, std::size_t,
+        std::size_t, bool, std::string, std::size_t> key() const
+    {
+        return std::make_tuple(scenario, producers, workers, runners, shards, payload,
+            completion, policy, batch);
+    }
+};
+
+struct result {
+    config c;
+    // Wall clock seconds of all repetitions
+    std::vector<double> seconds;
+
+    double median() const
+    {
+        std::vector<double> s(seconds);
+        std::sort(s.begin(), s.end());
+        return s[s.size() / 2];
+    }
+
+    double best() const
+    {
+        return *std::min_element(seconds.begin(), seconds.end());
+    }
+
+    double items_per_second() const
+    {
+        return c.items / median();
+    }
+};
+
+// The state captured by the handlers
+template <std::size_t Size>
+struct payload {
+    char data[Size];
+};
+
+template <>
+struct payload<0> {
+};
+
+// Signals when all items are processed
+class countdown {
+public:
+    explicit countdown(std::size_t count)
+        : left_(count)
+    {
+    }
+
+    void finish(std::size_t count = 1)
+    {
+        if (left_.fetch_sub(count, std::memory_order_acq_rel) == count)
+            done_.notify_all();
+    }
+
+    void wait()
+    {
+        done_.wait();
+    }
+
+private:
+    std::atomic<std::size_t> left_;
+    cport::util::event done_;
+};
+
+struct fixture {
+    fixture(const config &c)
+        : cp(c.shards)
+        , left(c.items)
+    {
+        if (c.uses_scheduler())
+        {
+            ts.reset(new cport::task_scheduler(cp, c.workers,
+                c.policy == "work_stealing" ? cport::scheduling_policy::work_stealing
+                    : cport::scheduling_policy::shared_queue));
+            group.reset(new cport::task_channel_group<std::size_t>(*ts));
+            for (std::size_t i = 0; i < c.producers; ++i)
+                channels.push_back(cport::task_channel::make_shared(*ts));
+        }
+    }
+
+    cport::completion_port cp;
+    countdown left;
+    std::unique_ptr<cport::task_scheduler> ts;
+    std::unique_ptr<cport::task_channel_group<std::size_t>> group;
+    std::vector<cport::task_channel::shared_ptr> channels;
+};
+
+// Keeps the error codes read by the error scenarios observable
+std::atomic<std::size_t> error_codes(0);
+
+// Copy count successful results of type Error into a small ring of slots
+template <typename Error>
+void copy_errors(countdown &left, std::size_t count)
+{
+    const Error e;
+    std::vector<Error> slots(1024);
+    std::size_t codes = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        Error &slot = slots[i % slots.size()];
+        slot = e;
+        codes += slot.code();
+    }
+    error_codes += codes;
+    left.finish(count);
+}
+
+// Post the items of the pull_n scenario before the clock starts
+template <std::size_t Size>
+void prepare(const config &c, fixture &f)
+{
+    const payload<Size> p = payload<Size>();
+    countdown &left = f.left;
+    if (c.scenario == "pull_n")
+    {
+        for (std::size_t i = 0; i < c.items; ++i)
+            f.cp.post([p, &left](const cport::generic_error&) { left.finish(); });
+    }
+}
+
+// Submit count items of the scenario from the producer with index producer
+template <std::size_t Size>
+void produce(const config &c, fixture &f, std::size_t producer, std::size_t count)
+{
+    const payload<Size> p = payload<Size>();
+    countdown &left = f.left;
+    auto task = [p, &left](cport::generic_error&) { left.finish(); };
+    auto empty_task = [p](cport::generic_error&) {};
+    auto completion = [p, &left](const cport::generic_error&) { left.finish(); };
+
+    if (c.scenario == "async")
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (c.completion)
+                f.ts->async(empty_task, completion);
+            else
+                f.ts->async(task);
+        }
+    }
+    else if (c.scenario == "channel")
+    {
+        cport::task_channel &channel = *f.channels[producer];
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (c.completion)
+                channel.enqueue_back(empty_task, completion);
+            else
+                channel.enqueue_back(task);
+        }
+    }
+    else if (c.scenario == "group")
+    {
+        // 16 channels per producer
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const std::size_t key = producer * 16 + i % 16;
+            if (c.completion)
+                f.group->enqueue_back(key, empty_task, completion);
+            else
+                f.group->enqueue_back(key, task);
+        }
+    }
+    else if (c.scenario == "cancel")
+    {
+        // The tasks which the workers start first are not canceled. The
+        //  completion handlers are invoked for the canceled tasks too.
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            const cport::task_t t = c.completion
+                ? f.ts->async(empty_task, completion) : f.ts->async(task);
+            if (f.ts->cancel(t) && !c.completion)
+                left.finish();
+        }
+    }
+    else if (c.scenario == "post" || c.scenario == "run_batch")
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            f.cp.post(completion);
+    }
+    else if (c.scenario == "dispatch")
+    {
+        for (std::size_t i = 0; i < count; ++i)
+            f.cp.dispatch(completion);
+    }
+    else if (c.scenario == "pull_n")
+    {
+        // The items were posted by prepare()
+        while (f.cp.pull_n(c.batch) > 0)
+        {
+        }
+    }
+    else if (c.scenario == "round_trip")
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            f.cp.post([p, &left](const cport::generic_error &e) {
+                error_codes.fetch_add(e.code(), std::memory_order_relaxed);
+                left.finish();
+            });
+            f.cp.pull();
+        }
+    }
+    else if (c.scenario == "generic_error")
+        copy_errors<cport::generic_error>(left, count);
+    else
+        copy_errors<cport::error_code>(left, count);
+}
+
+template <std::size_t Size>
+double run_once(const config &c)
+{
+    std::chrono::duration<double> elapsed;
+    std::unique_ptr<fixture> f(new fixture(c));
+    prepare<Size>(c, *f);
+    cport::util::thread_group runners;
+    for (std::size_t i = 0; i < c.runners; ++i)
+    {
+        if (c.scenario == "run_batch")
+        {
+            runners.add([&]{
+                while (!f->cp.stopped())
+                    f->cp.run_batch(c.batch);
+            });
+        }
+        else
+            runners.add([&]{ f->cp.run(); });
+    }
+    {
+        cport::util::event start;
+        cport::util::thread_group producers;
+        for (std::size_t i = 0; i < c.producers; ++i)
+        {
+            const std::size_t count = c.items / c.producers
+                + (i == 0 ? c.items % c.producers : 0);
+            producers.add([&, i, count]{
+                start.wait();
+                produce<Size>(c, *f, i, count);
+            });
+        }
+
+        const auto b = std::chrono::steady_clock::now();
+        start.notify_all();
+        f->left.wait();
+        elapsed = std::chrono::steady_clock::now() - b;
+        producers.join();
+    }
+
+    f->channels.clear();
+    f->group.reset();
+    f->ts.reset();
+    f->cp.stop();
+    runners.join();
+    return elapsed.count();
+}
+
+double run_once(const config &c)
+{
+    switch (c.payload)
+    {
+    case 0: return run_once<0>(c);
+    case 8: return run_once<8>(c);
+    case 16: return run_once<16>(c);
+    case 32: return run_once<32>(c);
+    case 64: return run_once<64>(c);
+    case 128: return run_once<128>(c);
+    case 256: return run_once<256>(c);
+    case 512: return run_once<512>(c);
+    case 1024: return run_once<1024>(c);
+    }
+    throw std::invalid_argument("unsupported payload size "
+        + std::to_string(c.payload) + ", expected 0 or a power of two up to 1024");
+}
+
+template <typename T>
+std::vector<T> parse_list(const std::string &value)
+{
+    std::vector<T> list;
+    std::istringstream is(value);
+    std::string item;
+    while (std::getline(is, item, ','))
+    {
+        std::istringstream iss(item);
+        T v;
+        if (!(iss >> v))
+            throw std::invalid_argument("invalid value '" + item + "'");
+        list.push_back(v);
+    }
+    if (list.empty())
+        throw std::invalid_argument("empty list");
+    return list;
+}
+
+// Combine each of the configurations with each of the values
+template <typename T, typename Setter>
+std::vector<config> expand(const std::vector<config> &configs,
+    const std::vector<T> &values, Setter set)
+{
+    std::vector<config> expanded;
+    for (const config &c : configs)
+    {
+        for (std::size_t i = 0; i < values.size(); ++i)
+        {
+            config e = c;
+            set(e, values[i]);
+            expanded.push_back(e);
+        }
+    }
+    return expanded;
+}
+
+void write_table(std::ostream &os, const std::vector<result> &results)
+{
+    os << std::left << std::setw(15) << "scenario" << std::right
+        << std::setw(11) << "producers" << std::setw(9) << "workers"
+        << std::setw(9) << "runners" << std::setw(8) << "shards"
+        << std::setw(9) << "payload"
+        << std::setw(12) << "completion" << std::setw(15) << "policy"
+        << std::setw(7) << "batch" << std::setw(10) << "items"
+        << std::setw(13) << "median s" << std::setw(13) << "best s"
+        << std::setw(14) << "items/s" << '\n';
+    for (const result &r : results)
+    {
+        os << std::left << std::setw(15) << r.c.scenario << std::right
+            << std::setw(11) << r.c.producers << std::setw(9) << r.c.workers
+            << std::setw(9) << r.c.runners << std::setw(8) << r.c.shards
+            << std::setw(9) << r.c.payload
+            << std::setw(12) << r.c.completion << std::setw(15) << r.c.policy
+            << std::setw(7) << r.c.batch << std::setw(10) << r.c.items
+            << std::fixed << std::setprecision(6)
+            << std::setw(13) << r.median() << std::setw(13) << r.best()
+            << std::setprecision(0) << std::setw(14) << r.items_per_second() << '\n';
+    }
+}
+
+void write_csv(std::ostream &os, const std::vector<result> &results)
+{
+    os << "scenario,producers,workers,runners,shards,payload,completion,policy,batch,"
+        "items,repeat,median_seconds,best_seconds,items_per_second\n";
+    for (const result &r : results)
+    {
+        os << r.c.scenario << ',' << r.c.producers << ',' << r.c.workers << ','
+            << r.c.runners << ',' << r.c.shards << ',' << r.c.payload << ','
+            << r.c.completion << ','
+            << r.c.policy << ',' << r.c.batch << ',' << r.c.items << ',' << r.seconds.size() << ','
+            << std::setprecision(9) << r.median() << ',' << r.best() << ','
+            << std::fixed << std::setprecision(0) << r.items_per_second() << '\n';
+        os.unsetf(std::ios_base::floatfield);
+    }
+}
+
+void write_json(std::ostream &os, const std::vector<result> &results)
+{
+    os << "{\"benchmarks\":[";
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        const result &r = results[i];
+        os << (i == 0 ? "\n" : ",\n")
+            << "{\"scenario\":\"" << r.c.scenario << "\""
+            << ",\"producers\":" << r.c.producers
+            << ",\"workers\":" << r.c.workers
+            << ",\"runners\":" << r.c.runners
+            << ",\"shards\":" << r.c.shards
+            << ",\"payload\":" << r.c.payload
+            << ",\"completion\":" << (r.c.completion ? "true" : "false")
+            << ",\"policy\":\"" << r.c.policy << "\""
+            << ",\"batch\":" << r.c.batch
+            << ",\"items\":" << r.c.items
+            << std::setprecision(9)
+            << ",\"median_seconds\":" << r.median()
+            << ",\"best_seconds\":" << r.best()
+            << ",\"seconds\":[";
+        for (std::size_t j = 0; j < r.seconds.size(); ++j)
+            os << (j == 0 ? "" : ",") << r.seconds[j];
+        os << "],\"items_per_second\":" << std::fixed << std::setprecision(0)
+            << r.items_per_second() << "}";
+        os.unsetf(std::ios_base::floatfield);
+    }
+    os << "\n]}\n";
+}
+
+void usage(std::ostream &os)
+{
+    os << "usage: benchmark [--scenarios=async,channel,group,cancel,post,dispatch,\n"
+        "    run_batch,pull_n,round_trip,generic_error,error_code]\n"
+        "    [--producers=N,...] [--workers=N,...] [--runners=N,...] [--shards=N,...]\n"
+        "    [--payload=BYTES,...] [--completion=0,1]\n"
+        "    [--policy=shared_queue,work_stealing] [--batch=N,...]\n"
+        "    [--items=N] [--repeat=N]\n"
+        "    [--format=table|csv|json] [--output=FILE]\n";
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::vector<std::string> scenarios(std::begin(all_scenarios), std::end(all_scenarios));
+    std::vector<std::size_t> producers(1, 1);
+    std::vector<std::size_t> workers(1, 1);
+    std::vector<std::size_t> runners(1, 1);
+    std::vector<std::size_t> shards(1, 1);
+    std::vector<std::size_t> payloads(1, 0);
+    std::vector<bool> completions(1, true);
+    std::vector<std::string> policies(1, "shared_queue");
+    std::vector<std::size_t> batches = { 1, 2, 4, 8, 16, 32, 64, 128, 256 };
+    std::size_t items = 200000;
+    std::size_t repeat = 3;
+    std::string format = "table";
+    std::string output;
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            const std::size_t eq = arg.find('=');
+            const std::string name = arg.substr(0, eq);
+            const std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+
+            if (name == "--help")
+            {
+                usage(std::cout);
+                return 0;
+            }
+            else if (name == "--scenarios")
+                scenarios = parse_list<std::string>(value);
+            else if (name == "--producers")
+                producers = parse_list<std::size_t>(value);
+            else if (name == "--workers")
+                workers = parse_list<std::size_t>(value);
+            else if (name == "--runners")
+                runners = parse_list<std::size_t>(value);
+            else if (name == "--shards")
+                shards = parse_list<std::size_t>(value);
+            else if (name == "--payload")
+                payloads = parse_list<std::size_t>(value);
+            else if (name == "--completion")
+            {
+                completions.clear();
+                for (int v : parse_list<int>(value))
+                    completions.push_back(v != 0);
+            }
+            else if (name == "--policy")
+                policies = parse_list<std::string>(value);
+            else if (name == "--batch")
+                batches = parse_list<std::size_t>(value);
+            else if (name == "--items")
+                items = parse_list<std::size_t>(value).front();
+            else if (name == "--repeat")
+                repeat = parse_list<std::size_t>(value).front();
+            else if (name == "--format")
+                format = value;
+            else if (name == "--output")
+                output = value;
+            else
+                throw std::invalid_argument("unknown option " + arg);
+        }
+
+        for (const std::string &s : scenarios)
+        {
+            if (std::find(std::begin(all_scenarios), std::end(all_scenarios), s)
+                    == std::end(all_scenarios))
+                throw std::invalid_argument("unknown scenario " + s);
+        }
+        for (const std::string &p : policies)
+        {
+            if (p != "shared_queue" && p != "work_stealing")
+                throw std::invalid_argument("unknown policy " + p);
+        }
+        if (format != "table" && format != "csv" && format != "json")
+            throw std::invalid_argument("unknown format " + format);
+        if (std::find(batches.begin(), batches.end(), 0) != batches.end())
+            throw std::invalid_argument("the batch sizes must be positive");
+        if (items == 0 || repeat == 0)
+            throw std::invalid_argument("items and repeat must be positive");
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        usage(std::cerr);
+        return EXIT_FAILURE;
+    }
+
+    // The cartesian product of the parameters, the scenario varying the
+    //  slowest. The parameters unused by a scenario are zeroed and the
+    //  duplicate combinations are skipped.
+    std::vector<config> combinations(1, config());
+    combinations = expand(combinations, scenarios,
+        [](config &c, const std::string &v) { c.scenario = v; });
+    combinations = expand(combinations, producers,
+        [](config &c, std::size_t v) { c.producers = std::max<std::size_t>(v, 1); });
+    combinations = expand(combinations, workers,
+        [](config &c, std::size_t v) { c.workers = std::max<std::size_t>(v, 1); });
+    combinations = expand(combinations, runners,
+        [](config &c, std::size_t v) { c.runners = std::max<std::size_t>(v, 1); });
+    combinations = expand(combinations, shards,
+        [](config &c, std::size_t v) { c.shards = v; });
+    combinations = expand(combinations, payloads,
+        [](config &c, std::size_t v) { c.payload = v; });
+    combinations = expand(combinations, completions,
+        [](config &c, bool v) { c.completion = v; });
+    combinations = expand(combinations, policies,
+        [](config &c, const std::string &v) { c.policy = v; });
+    combinations = expand(combinations, batches,
+        [](config &c, std::size_t v) { c.batch = v; });
+
+    std::vector<config> configs;
+    std::set<decltype(config().key())> seen;
+    for (config c : combinations)
+    {
+        c.items = items;
+        if (!c.uses_scheduler())
+        {
+            c.workers = 0;
+            c.completion = false;
+            c.policy = "-";
+        }
+        if (!c.uses_runners())
+            c.runners = 0;
+        if (!c.uses_batch())
+            c.batch = 0;
+        if (!c.uses_port())
+        {
+            c.shards = 1;
+            c.payload = 0;
+        }
+        if (seen.insert(c.key()).second)
+            configs.push_back(c);
+    }
+
+    std::vector<result> results;
+    try
+    {
+        for (const config &c : configs)
+        {
+            result r = { c, std::vector<double>() };
+            for (std::size_t i = 0; i < repeat; ++i)
+                r.seconds.push_back(run_once(c));
+            results.push_back(r);
+            std::cerr << '.' << std::flush;
+        }
+        std::cerr << '\n';
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    std::ofstream file;
+    if (!output.empty())
+    {
+        file.open(output.c_str());
+        if (!file)
+        {
+            std::cerr << "cannot open " << output << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+    std::ostream &os = output.empty() ? std::cout : file;
+
+    if (format == "csv")
+        write_csv(os, results);
+    else if (format == "json")
+        write_json(os, results);
+    else
+        write_table(os, results);
+    return 0;
+}
@@ -1,7 +1,20 @@
 #include <catch.hpp>
 #include <cport/completion_port.hpp>
+#include <cport/completion_handler_wrapper.hpp>
+#include <cport/post_batch.hpp>
 #include <cport/util/event.hpp>
+#include <cport/util/thread_group.hpp>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#ifdef CPORT_HAS_EVENTFD
+#include <poll.h>
+#endif // CPORT_HAS_EVENTFD
 
 using namespace cport;
 using namespace cport::util;
@@ -503,3 +516,689 @@ TEST_CASE("Test cases related to the completion port", "[completion_port]")
         }
     }
 }
+
+TEST_CASE("Posted handlers are invoked in FIFO order after the dispatched ones", "[completion_port]")
+{
+    completion_port cp;
+
+    // Exceed the capacity of the lock-free ring to exercise the overflow list
+    const int count = 20000;
+    std::vector<int> order;
+
+    for (int i = 0; i < count; ++i)
+    {
+        cp.post([&order, i](const generic_error&){
+            order.push_back(i);
+        });
+    }
+
+    cp.dispatch([&order](const generic_error&){
+        order.push_back(-1);
+    });
+
+    REQUIRE(count + 1 == cp.ready_handlers());
+
+    REQUIRE(count + 1 == cp.wait());
+
+    REQUIRE(count + 1 == order.size());
+    REQUIRE(-1 == order.front());
+    for (int i = 0; i < count; ++i)
+    {
+        REQUIRE(i == order[i + 1]);
+    }
+}
+
+TEST_CASE("Handlers receive the error they were posted with", "[completion_port]")
+{
+    completion_port cp;
+
+    std::vector<const generic_error *> errors;
+    std::vector<int> codes;
+    std::vector<std::string> messages;
+    const auto h = [&](const generic_error &e) {
+        errors.push_back(&e);
+        codes.push_back(e.code());
+        messages.push_back(e.what());
+    };
+
+    cp.post(h);
+    cp.post(h, generic_error(42, "failed"));
+    cp.post(h, generic_error());
+    cp.dispatch(h);
+
+    REQUIRE(4 == cp.wait());
+
+    // Handlers without an error share one instance
+    REQUIRE(&error_code::no_error() == errors[0]);
+    REQUIRE(&error_code::no_error() == errors[1]);
+    REQUIRE(&error_code::no_error() == errors[3]);
+    REQUIRE(std::vector<int>({ generic_error::none, generic_error::none, 42, generic_error::none }) == codes);
+    REQUIRE("failed" == messages[2]);
+
+    SECTION("error_code copies own their message")
+    {
+        error_code e(7, "seven");
+        const error_code copy(e);
+        e = error_code();
+        REQUIRE_FALSE(e);
+        REQUIRE(7 == copy.code());
+        REQUIRE(std::string("seven") == copy.error().what());
+
+        error_code moved(std::move(e));
+        REQUIRE_FALSE(moved);
+        REQUIRE(&error_code::no_error() == &moved.error());
+    }
+
+    SECTION("The message of an object which represents no error is kept")
+    {
+        const error_code e(generic_error(generic_error::none, "note"));
+        REQUIRE_FALSE(e);
+        REQUIRE(std::string("note") == e.error().what());
+        REQUIRE(std::string("note") == error_code(e).error().what());
+
+        messages.clear();
+        cp.post(h, generic_error(generic_error::none, "note"));
+        REQUIRE(1 == cp.wait());
+        REQUIRE(std::vector<std::string>({ "note" }) == messages);
+    }
+}
+
+TEST_CASE("Handlers posted concurrently are all invoked", "[completion_port]")
+{
+    completion_port cp;
+
+    const std::size_t producers = 4;
+    const std::size_t count = 10000;
+    std::atomic<std::size_t> invoked{ 0 };
+
+    thread_group runners([&](){ cp.run(); }, 2);
+    {
+        thread_group tg([&](){
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                cp.post([&](const generic_error&){ ++invoked; });
+            }
+        }, producers);
+    }
+
+    while (invoked < producers * count)
+    {
+        std::this_thread::yield();
+    }
+
+    cp.stop();
+    runners.join();
+
+    REQUIRE(producers * count == invoked);
+    REQUIRE(0 == cp.ready_handlers());
+}
+
+TEST_CASE("Ready handlers are processed in batches", "[completion_port]")
+{
+    completion_port cp;
+
+    std::vector<int> order;
+
+    for (int i = 0; i < 10; ++i)
+    {
+        cp.post([&order, i](const generic_error&){
+            order.push_back(i);
+        });
+    }
+
+    SECTION("pull_n() processes up to max handlers and returns immediately")
+    {
+        REQUIRE(0 == cp.pull_n(0));
+        REQUIRE(4 == cp.pull_n(4));
+        REQUIRE(6 == cp.ready_handlers());
+        REQUIRE(6 == cp.pull_n(100));
+        REQUIRE(0 == cp.pull_n(100));
+    }
+
+    SECTION("run_batch() processes ready handlers without blocking")
+    {
+        REQUIRE(8 == cp.run_batch(8));
+        REQUIRE(2 == cp.run_batch(8));
+    }
+
+    SECTION("run_batch() returns after stop() is called")
+    {
+        REQUIRE(10 == cp.pull());
+
+        std::thread t([&](){
+            REQUIRE(0 == cp.run_batch(8));
+        });
+
+        while (0 == cp.blocked_threads())
+        {
+            std::this_thread::yield();
+        }
+
+        cp.stop();
+
+        t.join();
+    }
+
+    REQUIRE(0 == cp.ready_handlers());
+    REQUIRE(10 == order.size());
+    for (int i = 0; i < 10; ++i)
+    {
+        REQUIRE(i == order[i]);
+    }
+}
+
+TEST_CASE("Claimed handlers are released if a handler in a batch throws", "[completion_port]")
+{
+    completion_port cp;
+
+    int invoked = 0;
+
+    cp.post([&](const generic_error&){
+        ++invoked;
+        throw std::runtime_error("Oops");
+    });
+
+    cp.post([&](const generic_error&){
+        ++invoked;
+    });
+
+    REQUIRE_THROWS(cp.pull_n(2));
+    REQUIRE(1 == cp.ready_handlers());
+    REQUIRE(1 == cp.pull_n(2));
+    REQUIRE(2 == invoked);
+}
+
+TEST_CASE("Handlers are posted in bulk", "[completion_port]")
+{
+    completion_port cp;
+
+    std::vector<int> order;
+
+    SECTION("A range of handlers is posted at once")
+    {
+        std::vector<std::function<void(const generic_error&)>> handlers;
+        for (int i = 0; i < 5; ++i)
+        {
+            handlers.push_back([&order, i](const generic_error&){
+                order.push_back(i);
+            });
+        }
+
+        REQUIRE(5 == cp.post_range(handlers.begin(), handlers.end()));
+        REQUIRE(5 == cp.ready_handlers());
+        REQUIRE(5 == cp.wait());
+        REQUIRE((std::vector<int>{ 0, 1, 2, 3, 4 }) == order);
+    }
+
+    SECTION("A handler which throws when copied ends the range without losing an operation")
+    {
+        struct throwing_handler {
+            throwing_handler(std::vector<int> &o, int i)
+                : order(&o), index(i)
+            {
+            }
+
+            throwing_handler(const throwing_handler &h)
+                : order(h.order), index(h.index)
+            {
+                if (index == 2)
+                    throw std::runtime_error("copy");
+            }
+
+            void operator()(const generic_error&)
+            {
+                order->push_back(index);
+            }
+
+            std::vector<int> *order;
+            int index;
+        };
+
+        std::vector<throwing_handler> handlers;
+        for (int i = 0; i < 3; ++i)
+            handlers.emplace_back(order, i);
+
+        REQUIRE_THROWS_AS(cp.post_range(handlers.begin(), handlers.end()),
+            const std::runtime_error&);
+
+        // No operation id is left behind, so wait_for() returns once idle
+        const auto start = std::chrono::steady_clock::now();
+        REQUIRE(2 == cp.wait_for(std::chrono::seconds(2)));
+        REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(1));
+        REQUIRE((std::vector<int>{ 0, 1 }) == order);
+    }
+
+    SECTION("Handlers added to a batch are not ready until committed")
+    {
+        post_batch batch(cp);
+
+        batch.post([&](const generic_error&){ order.push_back(1); });
+        batch.post([&](const generic_error& e){
+            REQUIRE(e.code() == operation_aborted);
+            order.push_back(2);
+        }, operation_aborted_error());
+        batch.dispatch([&](const generic_error&){ order.push_back(0); });
+
+        REQUIRE(3 == batch.size());
+        REQUIRE(0 == cp.ready_handlers());
+
+        // wait_one() must block on the operations enqueued in the batch
+        std::thread t([&](){
+            REQUIRE(3 == cp.wait());
+        });
+
+        while (0 == cp.blocked_threads())
+        {
+            std::this_thread::yield();
+        }
+
+        REQUIRE(3 == batch.commit());
+        REQUIRE(batch.empty());
+
+        t.join();
+
+        REQUIRE((std::vector<int>{ 0, 1, 2 }) == order);
+    }
+
+    SECTION("A batch wakes all blocked threads it has handlers for")
+    {
+        std::atomic<int> invoked{ 0 };
+
+        thread_group tg([&](){
+            REQUIRE(cp.run_one());
+        }, 3);
+
+        while (3 != cp.blocked_threads())
+        {
+            std::this_thread::yield();
+        }
+
+        {
+            post_batch batch(cp, 3);
+            for (int i = 0; i < 3; ++i)
+            {
+                batch.post([&](const generic_error&){ ++invoked; });
+            }
+        }
+
+        tg.join();
+
+        REQUIRE(3 == invoked);
+    }
+
+    REQUIRE(0 == cp.ready_handlers());
+}
+
+TEST_CASE("Threads wait for ready handlers according to the wait policy", "[completion_port]")
+{
+    completion_port cp;
+
+    REQUIRE(0 == cp.get_wait_policy().spin_count);
+    REQUIRE(0 == cp.get_wait_policy().yield_count);
+
+    SECTION("By default waiting threads are blocked immediately")
+    {
+        std::thread t([&](){
+            REQUIRE(cp.run_one());
+        });
+
+        while (0 == cp.blocked_threads())
+        {
+            std::this_thread::yield();
+        }
+
+        cp.post([](const generic_error&){});
+
+        t.join();
+
+        const wait_stats ws = cp.get_wait_stats();
+        REQUIRE(0 == ws.spins);
+        REQUIRE(0 == ws.yields);
+        REQUIRE(1 == ws.parks);
+    }
+
+    SECTION("A thread that finds a handler while yielding is not blocked")
+    {
+        cp.set_wait_policy(wait_policy(0, std::numeric_limits<std::size_t>::max()));
+
+        REQUIRE(std::numeric_limits<std::size_t>::max() == cp.get_wait_policy().yield_count);
+
+        std::thread t([&](){
+            REQUIRE(cp.run_one());
+        });
+
+        cp.post([](const generic_error&){});
+
+        t.join();
+
+        const wait_stats ws = cp.get_wait_stats();
+        REQUIRE(0 == ws.parks);
+        REQUIRE(0 == cp.blocked_threads());
+    }
+
+    SECTION("Stop interrupts threads that spin")
+    {
+        cp.set_wait_policy(wait_policy(std::numeric_limits<std::size_t>::max()));
+
+        std::thread t([&](){
+            REQUIRE_FALSE(cp.run_one());
+        });
+
+        cp.stop();
+
+        t.join();
+    }
+}
+
+TEST_CASE("A sharded port processes handlers posted from many threads", "[completion_port]")
+{
+    completion_port cp(4);
+
+    REQUIRE(4 == cp.shards());
+    REQUIRE(1 == completion_port().shards());
+    REQUIRE(0 < completion_port(0).shards());
+
+    const std::size_t producers = 4;
+    const std::size_t count = 5000;
+    std::atomic<std::size_t> invoked{ 0 };
+
+    SECTION("Handlers posted to other shards are stolen by a single runner")
+    {
+        {
+            thread_group tg([&](){
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    cp.post([&](const generic_error&){ ++invoked; });
+                }
+            }, producers);
+        }
+
+        REQUIRE(producers * count == cp.ready_handlers());
+        REQUIRE(producers * count == cp.wait());
+        REQUIRE(producers * count == invoked);
+    }
+
+    SECTION("wait() blocks until the operations enqueued in all shards complete")
+    {
+        std::vector<completion_handler_wrapper<std::function<void(const generic_error&)>>> wrappers;
+        for (std::size_t i = 0; i < producers; ++i)
+        {
+            wrappers.emplace_back(wrap_completion_handler(
+                std::function<void(const generic_error&)>([&](const generic_error&){ ++invoked; }), cp));
+        }
+
+        thread_group runners([&](){ cp.wait(); }, 2);
+
+        thread_group tg;
+        for (auto& w : wrappers)
+        {
+            tg.add([&w](){ w(); });
+        }
+        tg.join();
+        runners.join();
+
+        REQUIRE(producers == invoked);
+    }
+
+    REQUIRE(0 == cp.ready_handlers());
+}
+
+TEST_CASE("Blocking methods return when the deadline is reached", "[completion_port]")
+{
+    completion_port cp;
+
+    const auto timeout = std::chrono::milliseconds(20);
+
+    SECTION("run_for() returns without stopping the port")
+    {
+        const auto start = std::chrono::steady_clock::now();
+        REQUIRE(0 == cp.run_for(timeout));
+        REQUIRE(std::chrono::steady_clock::now() - start >= timeout);
+        REQUIRE_FALSE(cp.stopped());
+    }
+
+    SECTION("run_one_until() returns false if no handler becomes ready")
+    {
+        const auto tp = std::chrono::steady_clock::now() + timeout;
+        REQUIRE_FALSE(cp.run_one_until(tp));
+        REQUIRE(std::chrono::steady_clock::now() >= tp);
+    }
+
+    SECTION("run_for() processes the handlers posted before the deadline")
+    {
+        cp.post([](const generic_error&){});
+        cp.post([](const generic_error&){});
+        REQUIRE(2 == cp.run_for(timeout));
+        REQUIRE(cp.run_one_for(std::chrono::seconds(0)) == false);
+    }
+
+    SECTION("wait_for() returns while operations are still enqueued")
+    {
+        auto w = wrap_completion_handler([](const generic_error&){}, cp);
+
+        REQUIRE(0 == cp.wait_for(timeout));
+        REQUIRE_FALSE(cp.wait_one_for(timeout));
+
+        w();
+
+        REQUIRE(cp.wait_one_until(std::chrono::system_clock::now() + timeout));
+        REQUIRE(0 == cp.wait_until(std::chrono::steady_clock::now() + timeout));
+    }
+
+    SECTION("run_for() and wait_for() return while handlers keep becoming ready")
+    {
+        std::atomic<bool> repost(true);
+        std::size_t invoked = 0;
+        std::function<void (const generic_error&)> h;
+        h = [&](const generic_error&) {
+            ++invoked;
+            if (repost)
+                cp.post(h);
+        };
+        cp.post(h);
+
+        const auto tolerance = std::chrono::milliseconds(200);
+        auto start = std::chrono::steady_clock::now();
+        const std::size_t count = cp.run_for(timeout);
+        REQUIRE(std::chrono::steady_clock::now() - start < timeout + tolerance);
+        REQUIRE(count > 0);
+        REQUIRE(count == invoked);
+        REQUIRE(1 == cp.ready_handlers());
+
+        start = std::chrono::steady_clock::now();
+        REQUIRE(cp.wait_for(timeout) > 0);
+        REQUIRE(std::chrono::steady_clock::now() - start < timeout + tolerance);
+
+        repost = false;
+        REQUIRE(1 == cp.pull());
+    }
+
+    SECTION("run_until() processes handlers posted by other threads")
+    {
+        std::thread t([&](){
+            const auto count = cp.run_until(std::chrono::steady_clock::now() + std::chrono::seconds(30));
+            REQUIRE(1 == count);
+        });
+
+        while (0 == cp.blocked_threads())
+        {
+            std::this_thread::yield();
+        }
+
+        cp.post([&](const generic_error&){
+            cp.stop();
+        });
+
+        t.join();
+    }
+}
+
+TEST_CASE("Posted handlers are invoked by priority level", "[completion_port]")
+{
+    completion_port cp(1, 4);
+    REQUIRE(4 == cp.priority_levels());
+    REQUIRE(0 == cp.get_priority_aging());
+
+    std::vector<int> order;
+    const auto post_at = [&](int id, std::size_t priority) {
+        cp.post([&order, id](const generic_error&){
+            order.push_back(id);
+        }, priority);
+    };
+
+    SECTION("Higher levels run first and each level runs in FIFO order")
+    {
+        post_at(30, 3);
+        post_at(20, 2);
+        post_at(31, 3);
+        post_at(10, 1);
+        post_at(0, 0);
+        post_at(21, 2);
+        cp.post([&](const generic_error& e){
+            REQUIRE(e.code() == operation_aborted);
+            order.push_back(1);
+        }, operation_aborted_error(), 0);
+        cp.dispatch([&](const generic_error&){ order.push_back(-1); });
+
+        REQUIRE(8 == cp.ready_handlers());
+        REQUIRE(2 == cp.ready_handlers(0));
+        REQUIRE(1 == cp.ready_handlers(1));
+        REQUIRE(2 == cp.ready_handlers(2));
+        REQUIRE(2 == cp.ready_handlers(3));
+        REQUIRE(0 == cp.ready_handlers(4));
+
+        REQUIRE(8 == cp.pull());
+        REQUIRE((std::vector<int>{ -1, 0, 1, 10, 20, 21, 30, 31 }) == order);
+        REQUIRE(0 == cp.ready_handlers(3));
+    }
+
+    SECTION("Levels past the last one are clamped to it")
+    {
+        post_at(1, 100);
+        post_at(0, 3);
+        REQUIRE(2 == cp.ready_handlers(3));
+        REQUIRE(2 == cp.pull());
+        REQUIRE((std::vector<int>{ 1, 0 }) == order);
+    }
+
+    SECTION("Aging serves lower levels which were passed over")
+    {
+        cp.set_priority_aging(2);
+        REQUIRE(2 == cp.get_priority_aging());
+
+        for (int i = 0; i < 2; ++i)
+            post_at(10 + i, 1);
+        for (int i = 0; i < 6; ++i)
+            post_at(i, 0);
+
+        REQUIRE(8 == cp.pull());
+        REQUIRE((std::vector<int>{ 0, 1, 10, 2, 3, 11, 4, 5 }) == order);
+    }
+}
+
+TEST_CASE("Handlers posted concurrently at all levels are all invoked", "[completion_port]")
+{
+    completion_port cp(4, 3);
+    cp.set_priority_aging(8);
+
+    const int count = 10000;
+    std::atomic<int> invoked(0);
+
+    thread_group producers;
+    for (std::size_t p = 0; p < 3; ++p)
+    {
+        producers.add([&cp, &invoked, p](){
+            for (int i = 0; i < count; ++i)
+                cp.post([&](const generic_error&){ ++invoked; }, p);
+        });
+    }
+
+    thread_group consumers;
+    for (int c = 0; c < 2; ++c)
+    {
+        consumers.add([&](){
+            while (invoked != 3 * count)
+            {
+                if (0 == cp.pull_n(16))
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    producers.join();
+    consumers.join();
+    REQUIRE(3 * count == invoked);
+    for (std::size_t p = 0; p < 3; ++p)
+        REQUIRE(0 == cp.ready_handlers(p));
+}
+
+#ifdef CPORT_HAS_EVENTFD
+namespace {
+
+bool readable(int fd, int timeout_ms)
+{
+    pollfd p = { fd, POLLIN, 0 };
+    return ::poll(&p, 1, timeout_ms) == 1 && (p.revents & POLLIN) != 0;
+}
+
+} // namespace
+
+TEST_CASE("The native handle is readable while there are ready handlers", "[completion_port]")
+{
+    completion_port cp;
+
+    std::atomic<int> invoked(0);
+    const auto handler = [&](const generic_error&){ ++invoked; };
+
+    SECTION("The handle is signalled by post() and drained by pull()")
+    {
+        const int fd = cp.native_handle();
+        REQUIRE(fd >= 0);
+        REQUIRE(fd == cp.native_handle());
+        REQUIRE_FALSE(readable(fd, 0));
+
+        cp.post(handler);
+        cp.dispatch(handler);
+        REQUIRE(readable(fd, 0));
+
+        REQUIRE(1 == cp.pull_n(1));
+        REQUIRE(readable(fd, 0));
+
+        REQUIRE(1 == cp.pull());
+        REQUIRE_FALSE(readable(fd, 0));
+        REQUIRE(2 == invoked);
+    }
+
+    SECTION("Handlers posted before the handle is created signal it")
+    {
+        cp.post(handler);
+
+        const int fd = cp.native_handle();
+        REQUIRE(readable(fd, 0));
+        REQUIRE(1 == cp.pull());
+        REQUIRE_FALSE(readable(fd, 0));
+    }
+
+    SECTION("An external loop processes handlers posted by other threads")
+    {
+        const int fd = cp.native_handle();
+        const int count = 10000;
+
+        std::thread t([&](){
+            for (int i = 0; i < count; ++i)
+            {
+                cp.post(handler);
+            }
+        });
+
+        while (invoked != count)
+        {
+            REQUIRE(readable(fd, 10000));
+            cp.pull();
+        }
+
+        t.join();
+        REQUIRE_FALSE(readable(fd, 0));
+    }
+}
+#endif // CPORT_HAS_EVENTFD
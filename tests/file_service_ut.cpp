@@ -0,0 +1,196 @@
+#include <catch.hpp>
+#include <cport/completion_port.hpp>
+#include <cport/file_batch.hpp>
+#include <cport/file_service.hpp>
+
+#ifdef CPORT_HAS_FILE_SERVICE
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <vector>
+#include <unistd.h>
+
+using namespace cport;
+
+namespace {
+
+struct temp_file {
+    temp_file()
+    {
+        char name[] = "/tmp/cport_file_service_XXXXXX";
+        fd = ::mkstemp(name);
+        REQUIRE(fd >= 0);
+        ::unlink(name);
+    }
+
+    ~temp_file()
+    {
+        ::close(fd);
+    }
+
+    int fd;
+};
+
+std::vector<char> make_data(std::size_t size)
+{
+    std::vector<char> data(size);
+    for (std::size_t i = 0; i < size; ++i)
+        data[i] = static_cast<char>(i * 7 + i / 4096);
+    return data;
+}
+
+void test_file_service(file_service::backend_type backend)
+{
+    completion_port cp;
+    temp_file f;
+
+    const std::size_t block = 4096;
+    const std::size_t blocks = 256;
+    const std::vector<char> data = make_data(block * blocks);
+
+    // Less than the number of blocks, so requests wait in the service queue
+    file_service fs(cp, 32, backend);
+    REQUIRE(backend == fs.backend());
+
+    std::atomic<int> errors(0);
+    std::atomic<std::size_t> transferred(0);
+    const auto handler = [&](const generic_error &e, std::size_t n) {
+        if (e)
+            ++errors;
+        transferred += n;
+    };
+
+    SECTION("Written data is read back")
+    {
+        REQUIRE(fs.async_write(f.fd, data.data(), data.size(), 0, handler));
+        REQUIRE(1 == cp.wait());
+        REQUIRE(0 == errors);
+        REQUIRE(data.size() == transferred);
+
+        std::vector<char> buf(data.size());
+        transferred = 0;
+        REQUIRE(fs.async_read(f.fd, buf.data(), buf.size(), 0, handler));
+        REQUIRE(1 == cp.wait());
+        REQUIRE(data.size() == transferred);
+        REQUIRE(data == buf);
+
+        // A read at the end of file transfers nothing
+        transferred = 0;
+        REQUIRE(fs.async_read(f.fd, buf.data(), buf.size(), data.size(), handler));
+        REQUIRE(1 == cp.wait());
+        REQUIRE(0 == errors);
+        REQUIRE(0 == transferred);
+    }
+
+    SECTION("Batched requests are all completed")
+    {
+        {
+            file_batch batch(fs, blocks);
+            for (std::size_t i = 0; i < blocks; ++i)
+                REQUIRE(batch.write(f.fd, &data[i * block], block, i * block, handler));
+            REQUIRE(blocks == batch.size());
+        }
+        REQUIRE(blocks == cp.wait());
+        REQUIRE(data.size() == transferred);
+
+        std::vector<char> buf(data.size());
+        transferred = 0;
+        file_batch batch(fs);
+        for (std::size_t i = 0; i < blocks; ++i)
+            REQUIRE(batch.read(f.fd, &buf[i * block], block, i * block, handler));
+        REQUIRE(blocks == batch.commit());
+        REQUIRE(batch.empty());
+
+        REQUIRE(blocks == cp.wait());
+        REQUIRE(0 == errors);
+        REQUIRE(data == buf);
+    }
+
+    SECTION("A failed request is posted with the system error")
+    {
+        int error = 0;
+        char buf[16];
+        REQUIRE(fs.async_read(-1, buf, sizeof(buf), 0, [&](const generic_error &e, std::size_t) {
+            error = e.code();
+        }));
+        REQUIRE(1 == cp.wait());
+        REQUIRE(EBADF == error);
+    }
+
+    SECTION("Registered buffers are used by the fixed requests")
+    {
+        std::vector<char> buf(data.size());
+        const file_buffer fb = { buf.data(), buf.size() };
+        try {
+            fs.register_buffers(&fb, 1);
+        }
+        catch (const std::system_error &e) {
+            WARN("Buffers can not be registered: " << e.what());
+            return;
+        }
+
+        REQUIRE(fs.async_write(f.fd, data.data(), data.size(), 0, handler));
+        REQUIRE(1 == cp.wait());
+
+        transferred = 0;
+        file_batch batch(fs);
+        for (std::size_t i = 0; i < blocks; ++i)
+            REQUIRE(batch.read_fixed(f.fd, 0, &buf[i * block], block, i * block, handler));
+        batch.commit();
+        REQUIRE(blocks == cp.wait());
+        REQUIRE(0 == errors);
+        REQUIRE(data == buf);
+
+        int error = 0;
+        const auto failed = [&](const generic_error &e, std::size_t) {
+            error = e.code();
+        };
+        REQUIRE(fs.async_read_fixed(f.fd, 0, &buf[1], buf.size(), 0, failed));
+        REQUIRE(1 == cp.wait());
+        REQUIRE(EINVAL == error);
+
+        error = 0;
+        REQUIRE(fs.async_read_fixed(f.fd, 1, buf.data(), block, 0, failed));
+        REQUIRE(1 == cp.wait());
+        REQUIRE(EINVAL == error);
+
+        fs.unregister_buffers();
+        error = 0;
+        REQUIRE(fs.async_write_fixed(f.fd, 0, buf.data(), block, 0, failed));
+        REQUIRE(1 == cp.wait());
+        REQUIRE(EINVAL == error);
+    }
+
+    SECTION("Nothing is submitted if the port is stopped")
+    {
+        char buf[16];
+        cp.stop();
+        REQUIRE_FALSE(fs.async_read(f.fd, buf, sizeof(buf), 0, handler));
+        file_batch batch(fs);
+        REQUIRE_FALSE(batch.write(f.fd, buf, sizeof(buf), 0, handler));
+        REQUIRE(batch.empty());
+        cp.reset();
+    }
+}
+
+} // namespace
+
+TEST_CASE("File service executes requests on a pool of threads", "[file_service]")
+{
+    test_file_service(file_service::thread_pool);
+}
+
+TEST_CASE("File service executes requests through io_uring", "[file_service]")
+{
+    completion_port cp;
+    file_service fs(cp);
+    if (file_service::uring != fs.backend())
+    {
+        WARN("io_uring is not available");
+        return;
+    }
+    test_file_service(file_service::uring);
+}
+
+#endif // CPORT_HAS_FILE_SERVICE
@@ -0,0 +1,185 @@
+#include <catch.hpp>
+#include <cport/completion_port.hpp>
+#include <cport/handler_pool.hpp>
+#include <cport/post_batch.hpp>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace cport;
+
+namespace {
+
+// Counts the allocations made by the thread while an allocation_counter is alive
+thread_local bool counting = false;
+thread_local std::size_t allocations = 0;
+
+struct allocation_counter {
+    allocation_counter()
+    {
+        allocations = 0;
+        counting = true;
+    }
+
+    ~allocation_counter()
+    {
+        counting = false;
+    }
+
+    // Stop counting, so the assertions do not count their own allocations
+    std::size_t stop()
+    {
+        counting = false;
+        return allocations;
+    }
+};
+
+} // namespace
+
+void* operator new(std::size_t size)
+{
+    if (counting)
+        ++allocations;
+    if (void *p = std::malloc(size != 0 ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+#ifndef CPORT_DISABLE_OBJ_MEMORY_POOL
+TEST_CASE("Small handlers are posted and invoked without heap allocations", "[completion_port]")
+{
+    completion_port cp;
+
+    int invoked = 0;
+    char payload[64] = {};
+    const auto small = [&invoked, payload](const generic_error&) {
+        invoked += payload[0] + 1;
+    };
+    const auto warm_up = [&](std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i)
+            cp.post(small);
+        cp.pull();
+    };
+
+    // Fill the pools up to the largest number of handlers in flight below
+    const std::size_t count = 1000;
+    warm_up(2 * count);
+    invoked = 0;
+
+    SECTION("post() and dispatch()")
+    {
+        allocation_counter counter;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            cp.post(small);
+            cp.dispatch(small);
+        }
+        const std::size_t pulled = cp.pull();
+        const std::size_t allocated = counter.stop();
+        REQUIRE(2 * count == pulled);
+        REQUIRE(0 == allocated);
+    }
+
+    SECTION("post_batch with reserved capacity")
+    {
+        post_batch batch(cp, count);
+        allocation_counter counter;
+        for (std::size_t i = 0; i < count; ++i)
+            batch.post(small);
+        batch.commit();
+        const std::size_t pulled = cp.pull();
+        const std::size_t allocated = counter.stop();
+        REQUIRE(count == pulled);
+        REQUIRE(0 == allocated);
+    }
+
+    SECTION("Handlers of the larger size classes are pooled")
+    {
+        char large_payload[1000] = {};
+        const auto large = [&invoked, large_payload](const generic_error&) {
+            invoked += large_payload[0] + 1;
+        };
+        for (std::size_t i = 0; i < count; ++i)
+            cp.post(large);
+        cp.pull();
+        invoked = 0;
+
+        allocation_counter counter;
+        for (std::size_t i = 0; i < count; ++i)
+            cp.post(large);
+        const std::size_t pulled = cp.pull();
+        const std::size_t allocated = counter.stop();
+        REQUIRE(count == pulled);
+        REQUIRE(0 == allocated);
+        REQUIRE(count == static_cast<std::size_t>(invoked));
+    }
+}
+
+TEST_CASE("The handler pool reports and releases its memory", "[handler_pool]")
+{
+    completion_port cp;
+    handler_pool::trim();
+    const handler_pool_stats before = handler_pool::stats();
+
+    // Fits in the ready queue, so only the handlers are allocated
+    const std::size_t count = 4096;
+    char payload[64] = {};
+    std::size_t invoked = 0;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        cp.post([&invoked, payload](const generic_error&) {
+            invoked += payload[0] + 1;
+        });
+    }
+
+    // The handlers of this size are stored in nodes of 128 bytes
+    const handler_pool_stats posted = handler_pool::stats();
+    REQUIRE(posted.live_bytes - before.live_bytes == count * 128);
+    REQUIRE(posted.high_water_bytes >= posted.live_bytes + posted.cached_bytes);
+
+    REQUIRE(count == cp.pull());
+    REQUIRE(count == invoked);
+
+    const handler_pool_stats pulled = handler_pool::stats();
+    REQUIRE(pulled.live_bytes == before.live_bytes);
+    REQUIRE(pulled.cached_bytes - before.cached_bytes == count * 128);
+
+    SECTION("trim() returns the cached nodes to the heap")
+    {
+        REQUIRE(handler_pool::trim() >= count * 128);
+        const handler_pool_stats trimmed = handler_pool::stats();
+        REQUIRE(trimmed.cached_bytes <= before.cached_bytes);
+        REQUIRE(trimmed.high_water_bytes == pulled.high_water_bytes);
+    }
+
+    SECTION("The cache limit bounds the cached nodes")
+    {
+        const std::size_t limit = handler_pool::cache_limit();
+        handler_pool::trim();
+        handler_pool::set_cache_limit(0);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            cp.post([&invoked, payload](const generic_error&) {
+                invoked += payload[0] + 1;
+            });
+        }
+        REQUIRE(count == cp.pull());
+        handler_pool::set_cache_limit(limit);
+
+        // Only the magazines of this thread are left
+        const handler_pool_stats limited = handler_pool::stats();
+        REQUIRE(limited.cached_bytes <= before.cached_bytes
+            + 2 * CPORT_POOL_MAGAZINE_SIZE * 128);
+    }
+}
+#endif // CPORT_DISABLE_OBJ_MEMORY_POOL
@@ -0,0 +1,379 @@
+#include <cport/completion_port.hpp>
+#include <cport/latency_histogram.hpp>
+#include <cport/task_scheduler.hpp>
+#include <cport/detail/concurrent_histogram.hpp>
+#include <cport/util/event.hpp>
+#include <cport/util/thread_group.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Measures the latency of task_scheduler::async and completion_port::post
+//  under an open-loop load. A pacing thread issues the operations at a
+//  fixed rate, and each operation records the time from its intended
+//  start to the invocation of its completion handler. When the pacer
+//  falls behind, the following operations are issued at once, but their
+//  latency is still taken from the schedule, so the stalls are not hidden
+//  (the coordinated omission of closed-loop benchmarks).
+//
+//  latency_benchmark [--modes=async,post] [--workers=1] [--runners=1]
+//      [--rates=N,...] [--min-rate=10000] [--step=1.5] [--max-rate=N]
+//      [--duration=1000] [--format=table|csv|json] [--output=file]
+//
+// Unless explicit rates are given, the offered load of each mode, workers
+//  and runners configuration grows from min-rate by the step factor until
+//  the configuration saturates: the achieved throughput is below 95% of
+//  the offered one. The saturated point is reported too. Each point runs
+//  for duration milliseconds of issued load.
+
+namespace {
+
+typedef std::chrono::steady_clock clock_type;
+
+struct config {
+    std::string mode;
+    std::size_t workers;
+    std::size_t runners;
+    double rate;
+    std::chrono::milliseconds duration;
+};
+
+struct point {
+    config c;
+    std::size_t count;
+    // Operations completed per second, until the last completion
+    double achieved;
+    cport::latency_histogram latency;
+
+    bool saturated() const
+    {
+        return achieved < 0.95 * c.rate;
+    }
+};
+
+// Signals when all operations are completed
+class countdown {
+public:
+    explicit countdown(std::size_t count)
+        : left_(count)
+    {
+    }
+
+    void finish()
+    {
+        if (left_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            done_.notify_all();
+    }
+
+    void wait()
+    {
+        done_.wait();
+    }
+
+private:
+    std::atomic<std::size_t> left_;
+    cport::util::event done_;
+};
+
+// Wait until the time point, sleeping only when it is far enough away
+void wait_until(clock_type::time_point tp)
+{
+    for (;;)
+    {
+        const clock_type::time_point now = clock_type::now();
+        if (now >= tp)
+            return;
+        if (tp - now > std::chrono::microseconds(200))
+            std::this_thread::sleep_until(tp - std::chrono::microseconds(100));
+        else
+            std::this_thread::yield();
+    }
+}
+
+point run_point(const config &c)
+{
+    const std::size_t count = std::max<std::size_t>(1,
+        static_cast<std::size_t>(c.rate * c.duration.count() / 1000.0));
+    const std::chrono::duration<double> interval(1.0 / c.rate);
+
+    cport::completion_port cp;
+    std::unique_ptr<cport::task_scheduler> ts;
+    if (c.mode == "async")
+        ts.reset(new cport::task_scheduler(cp, c.workers));
+    cport::util::thread_group runners([&]{ cp.run(); }, c.runners);
+
+    cport::detail::concurrent_histogram latency;
+    countdown left(count);
+    std::atomic<clock_type::rep> last_completion(0);
+
+    const clock_type::time_point start = clock_type::now();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const clock_type::time_point intended = start
+            + std::chrono::duration_cast<clock_type::duration>(interval * i);
+        wait_until(intended);
+
+        auto completion = [&, intended](const cport::generic_error&) {
+            const clock_type::time_point now = clock_type::now();
+            latency.record(now - intended);
+            clock_type::rep last = last_completion.load(std::memory_order_relaxed);
+            const clock_type::rep t = (now - start).count();
+            while (t > last && !last_completion.compare_exchange_weak(last, t,
+                    std::memory_order_relaxed))
+                ;
+            left.finish();
+        };
+
+        if (ts)
+            ts->async([](cport::generic_error&) {}, completion);
+        else
+            cp.post(completion);
+    }
+    left.wait();
+
+    ts.reset();
+    cp.stop();
+    runners.join();
+
+    point p;
+    p.c = c;
+    p.count = count;
+    p.achieved = count / std::chrono::duration<double>(
+        clock_type::duration(std::max<clock_type::rep>(last_completion.load(), 1))).count();
+    p.latency = latency.snapshot();
+    return p;
+}
+
+template <typename T>
+std::vector<T> parse_list(const std::string &value)
+{
+    std::vector<T> list;
+    std::istringstream is(value);
+    std::string item;
+    while (std::getline(is, item, ','))
+    {
+        std::istringstream iss(item);
+        T v;
+        if (!(iss >> v))
+            throw std::invalid_argument("invalid value '" + item + "'");
+        list.push_back(v);
+    }
+    if (list.empty())
+        throw std::invalid_argument("empty list");
+    return list;
+}
+
+const double percentiles[] = { 50, 90, 99, 99.9, 99.99 };
+
+double to_us(std::chrono::nanoseconds ns)
+{
+    return ns.count() / 1000.0;
+}
+
+void write_table_header(std::ostream &os)
+{
+    os << std::left << std::setw(7) << "mode" << std::right
+        << std::setw(9) << "workers" << std::setw(9) << "runners"
+        << std::setw(12) << "offered/s" << std::setw(12) << "achieved/s"
+        << std::setw(11) << "p50 us" << std::setw(11) << "p90 us"
+        << std::setw(11) << "p99 us" << std::setw(11) << "p99.9 us"
+        << std::setw(11) << "p99.99 us" << std::setw(11) << "max us" << '\n';
+}
+
+void write_table_row(std::ostream &os, const point &p)
+{
+    os << std::left << std::setw(7) << p.c.mode << std::right
+        << std::setw(9) << p.c.workers << std::setw(9) << p.c.runners
+        << std::fixed << std::setprecision(0)
+        << std::setw(12) << p.c.rate << std::setw(12) << p.achieved
+        << std::setprecision(1);
+    for (double pct : percentiles)
+        os << std::setw(11) << to_us(p.latency.percentile(pct));
+    os << std::setw(11) << to_us(p.latency.max())
+        << (p.saturated() ? "  saturated" : "") << '\n';
+    os.unsetf(std::ios_base::floatfield);
+}
+
+void write_csv(std::ostream &os, const std::vector<point> &points)
+{
+    os << "mode,workers,runners,offered_rate,achieved_rate,count,saturated,"
+        "mean_us,p50_us,p90_us,p99_us,p99_9_us,p99_99_us,max_us\n";
+    for (const point &p : points)
+    {
+        os << p.c.mode << ',' << p.c.workers << ',' << p.c.runners << ','
+            << std::fixed << std::setprecision(0) << p.c.rate << ',' << p.achieved
+            << ',' << p.count << ',' << p.saturated() << ','
+            << std::setprecision(3) << to_us(p.latency.mean());
+        for (double pct : percentiles)
+            os << ',' << to_us(p.latency.percentile(pct));
+        os << ',' << to_us(p.latency.max()) << '\n';
+        os.unsetf(std::ios_base::floatfield);
+    }
+}
+
+void write_json(std::ostream &os, const std::vector<point> &points)
+{
+    const char *const names[] = { "p50", "p90", "p99", "p99_9", "p99_99" };
+    os << "{\"points\":[";
+    for (std::size_t i = 0; i < points.size(); ++i)
+    {
+        const point &p = points[i];
+        os << (i == 0 ? "\n" : ",\n")
+            << "{\"mode\":\"" << p.c.mode << "\""
+            << ",\"workers\":" << p.c.workers
+            << ",\"runners\":" << p.c.runners
+            << std::fixed << std::setprecision(0)
+            << ",\"offered_rate\":" << p.c.rate
+            << ",\"achieved_rate\":" << p.achieved
+            << ",\"count\":" << p.count
+            << ",\"saturated\":" << (p.saturated() ? "true" : "false")
+            << std::setprecision(3)
+            << ",\"latency_us\":{\"mean\":" << to_us(p.latency.mean());
+        for (std::size_t j = 0; j < sizeof(percentiles) / sizeof(percentiles[0]); ++j)
+            os << ",\"" << names[j] << "\":" << to_us(p.latency.percentile(percentiles[j]));
+        os << ",\"max\":" << to_us(p.latency.max()) << "}}";
+        os.unsetf(std::ios_base::floatfield);
+    }
+    os << "\n]}\n";
+}
+
+void usage(std::ostream &os)
+{
+    os << "usage: latency_benchmark [--modes=async,post] [--workers=N,...]\n"
+        "    [--runners=N,...] [--rates=N,...] [--min-rate=N] [--step=F]\n"
+        "    [--max-rate=N] [--duration=MS] [--format=table|csv|json] [--output=FILE]\n";
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    std::vector<std::string> modes = { "async", "post" };
+    std::vector<std::size_t> workers(1, 1);
+    std::vector<std::size_t> runners(1, 1);
+    std::vector<double> rates;
+    double min_rate = 10000;
+    double step = 1.5;
+    double max_rate = 1e8;
+    std::chrono::milliseconds duration(1000);
+    std::string format = "table";
+    std::string output;
+
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            const std::size_t eq = arg.find('=');
+            const std::string name = arg.substr(0, eq);
+            const std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+
+            if (name == "--help")
+            {
+                usage(std::cout);
+                return 0;
+            }
+            else if (name == "--modes")
+                modes = parse_list<std::string>(value);
+            else if (name == "--workers")
+                workers = parse_list<std::size_t>(value);
+            else if (name == "--runners")
+                runners = parse_list<std::size_t>(value);
+            else if (name == "--rates")
+                rates = parse_list<double>(value);
+            else if (name == "--min-rate")
+                min_rate = parse_list<double>(value).front();
+            else if (name == "--step")
+                step = parse_list<double>(value).front();
+            else if (name == "--max-rate")
+                max_rate = parse_list<double>(value).front();
+            else if (name == "--duration")
+                duration = std::chrono::milliseconds(parse_list<std::size_t>(value).front());
+            else if (name == "--format")
+                format = value;
+            else if (name == "--output")
+                output = value;
+            else
+                throw std::invalid_argument("unknown option " + arg);
+        }
+
+        for (const std::string &m : modes)
+        {
+            if (m != "async" && m != "post")
+                throw std::invalid_argument("unknown mode " + m);
+        }
+        for (double r : rates)
+        {
+            if (r <= 0)
+                throw std::invalid_argument("the rates must be positive");
+        }
+        if (format != "table" && format != "csv" && format != "json")
+            throw std::invalid_argument("unknown format " + format);
+        if (min_rate <= 0 || step <= 1 || duration.count() == 0)
+            throw std::invalid_argument("min-rate, step - 1 and duration must be positive");
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        usage(std::cerr);
+        return EXIT_FAILURE;
+    }
+
+    std::ofstream file;
+    if (!output.empty())
+    {
+        file.open(output.c_str());
+        if (!file)
+        {
+            std::cerr << "cannot open " << output << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+    std::ostream &os = output.empty() ? std::cout : file;
+
+    // The table is written point by point, as the sweep could be long
+    if (format == "table")
+        write_table_header(os);
+
+    std::vector<point> points;
+    for (const std::string &m : modes)
+        for (std::size_t w : workers)
+            for (std::size_t r : runners)
+            {
+                // The post mode has no workers
+                if (m == "post" && w != workers.front())
+                    continue;
+                config c = { m, m == "post" ? 0 : std::max<std::size_t>(w, 1),
+                    std::max<std::size_t>(r, 1), 0, duration };
+
+                for (std::size_t i = 0; rates.empty() || i < rates.size(); ++i)
+                {
+                    c.rate = rates.empty() ? min_rate * std::pow(step, i) : rates[i];
+                    if (rates.empty() && c.rate > max_rate)
+                        break;
+                    points.push_back(run_point(c));
+                    if (format == "table")
+                        write_table_row(os, points.back());
+                    if (rates.empty() && points.back().saturated())
+                        break;
+                }
+            }
+
+    if (format == "csv")
+        write_csv(os, points);
+    else if (format == "json")
+        write_json(os, points);
+    return 0;
+}
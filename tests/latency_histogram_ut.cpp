@@ -0,0 +1,101 @@
+#include <catch.hpp>
+#include <cport/latency_histogram.hpp>
+#include <cport/detail/concurrent_histogram.hpp>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace cport;
+using std::chrono::nanoseconds;
+
+TEST_CASE("An empty latency histogram", "[latency_histogram]")
+{
+    latency_histogram h;
+    REQUIRE(h.count() == 0);
+    REQUIRE(h.min() == nanoseconds(0));
+    REQUIRE(h.max() == nanoseconds(0));
+    REQUIRE(h.mean() == nanoseconds(0));
+    REQUIRE(h.percentile(99) == nanoseconds(0));
+}
+
+TEST_CASE("The latencies are counted within the precision of their bucket", "[latency_histogram]")
+{
+    std::size_t prev = 0;
+    for (std::uint64_t v = 1; v < (std::uint64_t(1) << 39); v += v / 7 + 1)
+    {
+        const std::size_t bucket = detail::histogram_buckets::index(v);
+        REQUIRE(bucket >= prev);
+        REQUIRE(bucket < detail::histogram_buckets::count);
+        REQUIRE(detail::histogram_buckets::lower_value(bucket) <= v);
+        REQUIRE(detail::histogram_buckets::upper_value(bucket) >= v);
+        REQUIRE(detail::histogram_buckets::upper_value(bucket) - v <= v / 32);
+        prev = bucket;
+    }
+
+    // The values above the range are clamped
+    REQUIRE(detail::histogram_buckets::index(~std::uint64_t(0))
+        == detail::histogram_buckets::count - 1);
+}
+
+TEST_CASE("The percentiles of a latency histogram", "[latency_histogram]")
+{
+    latency_histogram h;
+    for (int i = 1; i <= 1000; ++i)
+        h.record(std::chrono::microseconds(i));
+
+    REQUIRE(h.count() == 1000);
+    REQUIRE(h.min() == std::chrono::microseconds(1));
+    REQUIRE(h.max() == std::chrono::microseconds(1000));
+
+    const double precision = 1.0 / 32;
+    const double p50 = static_cast<double>(h.percentile(50).count());
+    REQUIRE(p50 >= 500000);
+    REQUIRE(p50 <= 500000 * (1 + precision));
+    const double p99 = static_cast<double>(h.percentile(99).count());
+    REQUIRE(p99 >= 990000);
+    REQUIRE(p99 <= 990000 * (1 + precision));
+    REQUIRE(h.percentile(100) == h.max());
+    REQUIRE(h.percentile(0) == h.min());
+
+    const double mean = static_cast<double>(h.mean().count());
+    REQUIRE(mean >= 500500 * (1 - precision));
+    REQUIRE(mean <= 500500 * (1 + precision));
+}
+
+TEST_CASE("Latency histograms could be merged", "[latency_histogram]")
+{
+    latency_histogram a, b, empty;
+    a.record(nanoseconds(10));
+    b.record(nanoseconds(1000));
+    b.record(nanoseconds(2000));
+    a.merge(b);
+    a.merge(empty);
+
+    REQUIRE(a.count() == 3);
+    REQUIRE(a.min() == nanoseconds(10));
+    REQUIRE(a.max() == nanoseconds(2000));
+    REQUIRE(a.percentile(50) >= nanoseconds(1000));
+    REQUIRE(a.percentile(50) < nanoseconds(2000));
+}
+
+TEST_CASE("A concurrent histogram is recorded by many threads", "[latency_histogram]")
+{
+    detail::concurrent_histogram h;
+    REQUIRE(h.snapshot().count() == 0);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&h, t]() {
+            for (int i = 0; i < 10000; ++i)
+                h.record(nanoseconds(t * 10000 + i + 1));
+        });
+    }
+    for (auto &t : threads)
+        t.join();
+
+    const latency_histogram s = h.snapshot();
+    REQUIRE(s.count() == 40000);
+    REQUIRE(s.min() == nanoseconds(1));
+    REQUIRE(s.max() == nanoseconds(40000));
+}
@@ -0,0 +1,104 @@
+#include <catch.hpp>
+#include <cport/completion_port.hpp>
+#include <cport/lock_profiler.hpp>
+#include <cport/task_scheduler.hpp>
+#include <cport/task_channel.hpp>
+#include <cport/task_channel_group.hpp>
+#include <cport/util/event.hpp>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace cport;
+using namespace cport::util;
+
+#ifndef CPORT_ENABLE_LOCK_PROFILING
+#error "The lock profiler tests require CPORT_ENABLE_LOCK_PROFILING"
+#endif
+
+namespace {
+
+struct test_site {
+    static const char* name() { return "test_site"; }
+};
+
+lock_stats find_site(const char *name)
+{
+    for (const lock_stats &s : lock_profiler::snapshot()) {
+        if (std::strcmp(s.site, name) == 0)
+            return s;
+    }
+    lock_stats none = { name, 0, 0, std::chrono::nanoseconds(0), std::chrono::nanoseconds(0) };
+    return none;
+}
+
+} // namespace
+
+TEST_CASE("The profiled mutex accounts the contended acquisitions", "[lock_profiler]")
+{
+    REQUIRE(lock_profiler::enabled());
+
+    static detail::profiled_mutex<test_site> m;
+    const lock_stats before = find_site("test_site");
+
+    event locked;
+    std::thread owner([&]() {
+        std::lock_guard<detail::profiled_mutex<test_site>> lock(m);
+        locked.notify_all();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    });
+    locked.wait();
+    {
+        std::lock_guard<detail::profiled_mutex<test_site>> lock(m);
+    }
+    owner.join();
+    REQUIRE(m.try_lock());
+    m.unlock();
+
+    const lock_stats after = find_site("test_site");
+    REQUIRE(after.acquisitions - before.acquisitions == 3);
+    REQUIRE(after.contended - before.contended == 1);
+    REQUIRE(after.wait_time - before.wait_time >= std::chrono::milliseconds(10));
+    REQUIRE(after.hold_time - before.hold_time >= std::chrono::milliseconds(10));
+}
+
+TEST_CASE("The internal mutexes are profiled", "[lock_profiler]")
+{
+    {
+        completion_port p;
+        task_scheduler ts(p, 2);
+        task_channel_group<int> group(ts);
+        std::size_t completed = 0;
+        for (int i = 0; i < 10; ++i) {
+            group.enqueue_back(i % 2, [](generic_error&) {},
+                [&completed](const generic_error&) { ++completed; });
+        }
+        while (completed != 10)
+            p.run_one();
+        p.wait();
+    }
+
+    const char *sites[] = {
+        "completion_port_impl::guard_",
+        "task_scheduler_impl::guard_",
+        "task_channel::mutex_",
+        "task_channel_group::mtx_"
+    };
+    for (const char *site : sites) {
+        INFO(site);
+        REQUIRE(find_site(site).acquisitions > 0);
+    }
+
+    const std::vector<lock_stats> stats = lock_profiler::snapshot();
+    for (std::size_t i = 1; i < stats.size(); ++i)
+        REQUIRE(stats[i - 1].wait_time >= stats[i].wait_time);
+
+    std::ostringstream os;
+    lock_profiler::write_report(os);
+    const std::string report = os.str();
+    REQUIRE(report.find("acquisitions") != std::string::npos);
+    for (const char *site : sites)
+        REQUIRE(report.find(site) != std::string::npos);
+}
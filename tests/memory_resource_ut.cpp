@@ -0,0 +1,340 @@
+#include <catch.hpp>
+#include <cport/associated_allocator.hpp>
+#include <cport/completion_port.hpp>
+#include <cport/memory_resource.hpp>
+#include <cport/task_scheduler.hpp>
+#include <cport/task_channel.hpp>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+using namespace cport;
+
+namespace {
+
+// Forwards to the default resource and counts the memory in use
+class counting_resource : public memory_resource {
+public:
+    counting_resource()
+        : allocations(0)
+        , live_bytes(0)
+    {
+    }
+
+    std::atomic<std::size_t> allocations;
+    std::atomic<std::size_t> live_bytes;
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        ++allocations;
+        live_bytes += bytes;
+        return get_default_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override
+    {
+        live_bytes -= bytes;
+        get_default_resource()->deallocate(p, bytes, alignment);
+    }
+};
+
+// Counts the allocations made through all its copies
+template <typename T>
+class counting_allocator {
+public:
+    typedef T value_type;
+
+    explicit counting_allocator(std::atomic<std::size_t> &live)
+        : live_(&live)
+    {
+    }
+
+    template <typename U>
+    counting_allocator(const counting_allocator<U> &other)
+        : live_(other.live())
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+        *live_ += n;
+        return static_cast<T *>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T *p, std::size_t n)
+    {
+        *live_ -= n;
+        ::operator delete(p);
+    }
+
+    std::atomic<std::size_t>* live() const
+    {
+        return live_;
+    }
+
+private:
+    std::atomic<std::size_t> *live_;
+};
+
+template <typename T, typename U>
+bool operator==(const counting_allocator<T> &a, const counting_allocator<U> &b)
+{
+    return a.live() == b.live();
+}
+
+template <typename T, typename U>
+bool operator!=(const counting_allocator<T> &a, const counting_allocator<U> &b)
+{
+    return !(a == b);
+}
+
+} // namespace
+
+TEST_CASE("The port allocates its handlers and queues from the resource", "[memory_resource]")
+{
+    counting_resource r;
+    {
+        completion_port cp(2, 2, r);
+        REQUIRE(cp.get_memory_resource() == &r);
+
+        // The ready queues of a shard are allocated on first use
+        std::size_t invoked = 0;
+        cp.post([&invoked](const generic_error&) { ++invoked; });
+        cp.dispatch([&invoked](const generic_error&) { ++invoked; });
+        const std::size_t queues = r.allocations - 2;
+        REQUIRE(queues > 0);
+
+        for (std::size_t i = 0; i < 100; ++i)
+            cp.post([&invoked](const generic_error&) { ++invoked; });
+        cp.dispatch([&invoked](const generic_error&) { ++invoked; });
+        REQUIRE(r.allocations - queues == 103);
+
+        REQUIRE(cp.pull() == 103);
+        REQUIRE(invoked == 103);
+    }
+    REQUIRE(r.live_bytes == 0);
+}
+
+TEST_CASE("A sharded port allocates the queues of the used shards only", "[memory_resource]")
+{
+    counting_resource r;
+    {
+        completion_port cp(64, 4, r);
+        REQUIRE(r.allocations == 0);
+
+        std::size_t invoked = 0;
+        cp.post([&invoked](const generic_error&) { ++invoked; }, 3);
+        const std::size_t one_queue = r.allocations - 1;
+        REQUIRE(one_queue > 0);
+
+        // The queue of the level of the shard is reused
+        cp.post([&invoked](const generic_error&) { ++invoked; }, 3);
+        REQUIRE(r.allocations == one_queue + 2);
+        REQUIRE(cp.pull() == 2);
+        REQUIRE(invoked == 2);
+    }
+    REQUIRE(r.live_bytes == 0);
+}
+
+TEST_CASE("The default port allocates from the default resource", "[memory_resource]")
+{
+    completion_port cp;
+    REQUIRE(cp.get_memory_resource() == get_default_resource());
+
+    task_scheduler ts(cp, 1);
+    REQUIRE(ts.get_memory_resource() == get_default_resource());
+}
+
+TEST_CASE("A posted lvalue handler is copied", "[memory_resource]")
+{
+    completion_port cp;
+    std::size_t invoked = 0;
+    std::function<void (const generic_error&)> h =
+        [&invoked](const generic_error&) { ++invoked; };
+
+    cp.post(h);
+    cp.post(h);
+    REQUIRE(h);
+    REQUIRE(cp.pull() == 2);
+    REQUIRE(invoked == 2);
+}
+
+TEST_CASE("The scheduler allocates its tasks from its own resource", "[memory_resource]")
+{
+    counting_resource port_resource;
+    counting_resource scheduler_resource;
+    {
+        completion_port cp(port_resource);
+        task_scheduler ts(cp, 1, [](task_scheduler::worker_func_prototype f) { f(); },
+            scheduler_resource);
+        REQUIRE(ts.get_memory_resource() == &scheduler_resource);
+
+        const std::size_t before = scheduler_resource.allocations;
+        std::size_t completed = 0;
+        for (std::size_t i = 0; i < 10; ++i)
+        {
+            ts.async([](generic_error&) {},
+                [&completed](const generic_error&) { ++completed; });
+        }
+        REQUIRE(scheduler_resource.allocations - before >= 10);
+
+        while (completed != 10)
+            cp.run_one();
+        REQUIRE(completed == 10);
+    }
+    REQUIRE(port_resource.live_bytes == 0);
+    REQUIRE(scheduler_resource.live_bytes == 0);
+}
+
+TEST_CASE("The task channel allocates from the resource of the scheduler", "[memory_resource]")
+{
+    counting_resource r;
+    {
+        completion_port cp;
+        task_scheduler ts(cp, 1, [](task_scheduler::worker_func_prototype f) { f(); }, r);
+        task_channel::shared_ptr tc = task_channel::make_shared(ts);
+        REQUIRE(r.live_bytes >= sizeof(task_channel));
+
+        std::size_t completed = 0;
+        for (std::size_t i = 0; i < 10; ++i)
+            tc->enqueue_back([](generic_error&) {},
+                [&completed](const generic_error&) { ++completed; });
+
+        while (completed != 10)
+            cp.run_one();
+        REQUIRE(completed == 10);
+    }
+    REQUIRE(r.live_bytes == 0);
+}
+
+TEST_CASE("The monotonic buffer resource", "[memory_resource]")
+{
+    counting_resource upstream;
+    {
+        monotonic_buffer_resource mr(1024, &upstream);
+        REQUIRE(mr.upstream_resource() == &upstream);
+        REQUIRE(mr.upstream_bytes() == 0);
+
+        SECTION("hands out aligned storage from growing chunks")
+        {
+            void *a = mr.allocate(1, 1);
+            void *b = mr.allocate(8, 8);
+            void *c = mr.allocate(64, 64);
+            REQUIRE(reinterpret_cast<std::uintptr_t>(b) % 8 == 0);
+            REQUIRE(reinterpret_cast<std::uintptr_t>(c) % 64 == 0);
+            REQUIRE(a != b);
+            REQUIRE(upstream.allocations == 1);
+            REQUIRE(mr.upstream_bytes() == 1024);
+
+            // Deallocation does not return the storage
+            mr.deallocate(c, 64, 64);
+            REQUIRE(upstream.live_bytes == 1024);
+
+            mr.allocate(1000);
+            REQUIRE(upstream.allocations == 2);
+            REQUIRE(mr.upstream_bytes() == 1024 + 2048);
+
+            // A large block gets a chunk of its own
+            mr.allocate(10000);
+            REQUIRE(upstream.allocations == 3);
+            REQUIRE(mr.upstream_bytes() > 10000 + 1024 + 2048);
+
+            mr.release();
+            REQUIRE(mr.upstream_bytes() == 0);
+            REQUIRE(upstream.live_bytes == 0);
+        }
+
+        SECTION("serves a port for its lifetime")
+        {
+            {
+                completion_port cp(mr);
+                std::size_t invoked = 0;
+                for (std::size_t i = 0; i < 1000; ++i)
+                    cp.post([&invoked](const generic_error&) { ++invoked; });
+                REQUIRE(cp.pull() == 1000);
+                REQUIRE(invoked == 1000);
+            }
+            REQUIRE(upstream.live_bytes == mr.upstream_bytes());
+        }
+    }
+    REQUIRE(upstream.live_bytes == 0);
+}
+
+TEST_CASE("The resource allocators compare by resource", "[memory_resource]")
+{
+    monotonic_buffer_resource a;
+    monotonic_buffer_resource b;
+    resource_allocator<int> ia(&a);
+    resource_allocator<double> da(&a);
+    resource_allocator<int> ib(&b);
+    REQUIRE(ia == da);
+    REQUIRE(ia != ib);
+
+    std::vector<int, resource_allocator<int>> v(ia);
+    for (int i = 0; i < 100; ++i)
+        v.push_back(i);
+    REQUIRE(v.size() == 100);
+    REQUIRE(a.upstream_bytes() > 0);
+    REQUIRE(b.upstream_bytes() == 0);
+}
+
+TEST_CASE("Handlers are allocated with their associated allocator", "[memory_resource]")
+{
+    counting_resource r;
+    std::atomic<std::size_t> live(0);
+    counting_allocator<char> a(live);
+    {
+        completion_port cp(r);
+        const std::size_t queues = r.allocations;
+        std::size_t invoked = 0;
+
+        SECTION("Posted handlers")
+        {
+            for (std::size_t i = 0; i < 10; ++i)
+                cp.post(bind_allocator(a, [&invoked](const generic_error&) { ++invoked; }));
+            cp.dispatch(bind_allocator(a, [&invoked](const generic_error&) { ++invoked; }));
+            REQUIRE(live == 11);
+            REQUIRE(r.allocations == queues);
+
+            REQUIRE(cp.pull() == 11);
+            REQUIRE(invoked == 11);
+            REQUIRE(live == 0);
+        }
+
+        SECTION("Scheduled tasks use the allocator of the completion handler")
+        {
+            {
+                task_scheduler ts(cp, 1);
+                // The queue of the scheduler
+                const std::size_t queue = r.allocations;
+                bool executed = false;
+                ts.async([&executed](generic_error&) { executed = true; },
+                    bind_allocator(a, [&invoked](const generic_error&) { ++invoked; }));
+
+                while (invoked != 1)
+                    cp.run_one();
+                REQUIRE(executed);
+                REQUIRE(r.allocations == queue);
+            }
+            // The worker may release the task after the completion is invoked
+            REQUIRE(live == 0);
+        }
+    }
+    REQUIRE(r.live_bytes == 0);
+}
+
+TEST_CASE("Handlers could be allocated from a per-request arena", "[memory_resource]")
+{
+    completion_port cp;
+    monotonic_buffer_resource arena;
+    resource_allocator<char> a(&arena);
+
+    std::size_t invoked = 0;
+    for (std::size_t i = 0; i < 100; ++i)
+        cp.post(bind_allocator(a, [&invoked](const generic_error&) { ++invoked; }));
+    REQUIRE(arena.upstream_bytes() > 0);
+    REQUIRE(cp.pull() == 100);
+    REQUIRE(invoked == 100);
+}
@@ -0,0 +1,152 @@
+#include <catch.hpp>
+#include <cport/completion_port.hpp>
+#include <cport/task_scheduler.hpp>
+#include <cport/util/event.hpp>
+#include <chrono>
+#include <thread>
+
+using namespace cport;
+using namespace cport::util;
+
+#ifdef CPORT_HAS_METRICS
+
+TEST_CASE("The port counts posted, dispatched and completed handlers", "[metrics]")
+{
+    completion_port p;
+    port_metrics m = p.snapshot();
+    REQUIRE(m.posted == 0);
+    REQUIRE(m.dispatched == 0);
+    REQUIRE(m.completed == 0);
+    REQUIRE(m.ready == 0);
+    REQUIRE(m.ready_high_water == 0);
+
+    std::size_t invoked = 0;
+    for (std::size_t i = 0; i < 10; ++i)
+        p.post([&invoked](const generic_error&) { ++invoked; });
+    for (std::size_t i = 0; i < 3; ++i)
+        p.dispatch([&invoked](const generic_error&) { ++invoked; });
+
+    m = p.snapshot();
+    REQUIRE(m.posted == 10);
+    REQUIRE(m.dispatched == 3);
+    REQUIRE(m.completed == 0);
+    REQUIRE(m.ready == 13);
+    REQUIRE(m.ready_high_water == 13);
+
+    REQUIRE(p.pull() == 13);
+
+    m = p.snapshot();
+    REQUIRE(m.completed == 13);
+    REQUIRE(m.ready == 0);
+    REQUIRE(m.ready_high_water == 13);
+}
+
+TEST_CASE("The port counts the handlers completed from many threads", "[metrics]")
+{
+    completion_port p(4);
+    const std::size_t count = 10000;
+    std::thread producers[4];
+    for (auto &t : producers)
+    {
+        t = std::thread([&p]() {
+            for (std::size_t i = 0; i < count; ++i)
+                p.post([](const generic_error&) {});
+        });
+    }
+    for (auto &t : producers)
+        t.join();
+
+    std::thread consumers[4];
+    for (auto &t : consumers)
+        t = std::thread([&p]() { p.pull(); });
+    for (auto &t : consumers)
+        t.join();
+    p.pull();
+
+    const port_metrics m = p.snapshot();
+    REQUIRE(m.posted == 4 * count);
+    REQUIRE(m.completed == 4 * count);
+    REQUIRE(m.ready_high_water <= 4 * count);
+}
+
+TEST_CASE("The scheduler counts its tasks and the time of its workers", "[metrics]")
+{
+    completion_port p;
+    task_scheduler ts(p, 1);
+
+    event started, release;
+    ts.async([&](generic_error&) {
+        started.notify_all();
+        release.wait();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    });
+    started.wait();
+
+    for (std::size_t i = 0; i < 5; ++i)
+        ts.async([](generic_error&) {});
+
+    scheduler_metrics m = ts.snapshot();
+    REQUIRE(m.enqueued == 6);
+    REQUIRE(m.pending == 5);
+    REQUIRE(m.pending_high_water == 5);
+    REQUIRE(m.canceled == 0);
+
+    REQUIRE(ts.cancel_all() == 5);
+    release.notify_all();
+    p.wait();
+
+    m = ts.snapshot();
+    REQUIRE(m.canceled == 5);
+    REQUIRE(m.pending == 0);
+    REQUIRE(m.pending_high_water == 5);
+
+    // The worker counts the task after the completion is posted
+    while (ts.snapshot().executed != 1)
+        std::this_thread::yield();
+    m = ts.snapshot();
+    REQUIRE(m.busy_time >= std::chrono::milliseconds(10));
+    REQUIRE(m.idle_time.count() >= 0);
+}
+
+TEST_CASE("The scheduler records the latencies of its tasks", "[metrics]")
+{
+    completion_port p;
+    task_scheduler ts(p, 1);
+
+    event started, release;
+    ts.async([&](generic_error&) {
+        started.notify_all();
+        release.wait();
+    });
+    started.wait();
+
+    // The tasks wait for the first one to be released
+    std::size_t completed = 0;
+    for (std::size_t i = 0; i < 4; ++i)
+    {
+        ts.async([](generic_error&) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            },
+            [&completed](const generic_error&) { ++completed; });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    release.notify_all();
+
+    // The completion handlers wait for the port to be run
+    while (ts.snapshot().executed != 5)
+        std::this_thread::yield();
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    p.wait();
+    REQUIRE(completed == 4);
+
+    const task_latency l = ts.latency();
+    REQUIRE(l.queueing.count() == 5);
+    REQUIRE(l.queueing.max() >= std::chrono::milliseconds(5));
+    REQUIRE(l.execution.count() == 5);
+    REQUIRE(l.execution.percentile(50) >= std::chrono::milliseconds(2));
+    REQUIRE(l.execution.max() >= std::chrono::milliseconds(5));
+    REQUIRE(l.completion.count() == 5);
+    REQUIRE(l.completion.max() >= std::chrono::milliseconds(5));
+}
+
+#endif // CPORT_HAS_METRICS
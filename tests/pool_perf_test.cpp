@@ -0,0 +1,81 @@
+#include <cport/completion_port.hpp>
+#include <cport/util/thread_group.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <thread>
+
+// Built three times: with the thread magazines, with magazines of a
+//  single node (every allocation and free locks the shared depot) and
+//  with CPORT_DISABLE_OBJ_MEMORY_POOL (the global heap).
+#if defined(CPORT_DISABLE_OBJ_MEMORY_POOL)
+static const char pool_name[] = "heap";
+#elif CPORT_POOL_MAGAZINE_SIZE == 1
+static const char pool_name[] = "locked";
+#else
+static const char pool_name[] = "magazines";
+#endif
+
+// The handlers are allocated by the producers and freed by the consumers
+//  running the port.
+template <std::size_t PayloadSize>
+void cross_thread_test(std::size_t producers, std::size_t consumers)
+{
+    const std::size_t items_per_producer = 1000000;
+    const std::size_t total_items = producers * items_per_producer;
+
+    cport::completion_port cp;
+    std::atomic<std::size_t> completed{ 0 };
+    char payload[PayloadSize] = {};
+
+    const auto b = std::chrono::steady_clock::now();
+
+    cport::util::thread_group consumer_group;
+    for (std::size_t i = 0; i < consumers; ++i)
+    {
+        consumer_group.add([&]{
+            while (completed.load() < total_items)
+            {
+                if (cp.pull_n(64) == 0)
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    cport::util::thread_group producer_group;
+    for (std::size_t i = 0; i < producers; ++i)
+    {
+        producer_group.add([&]{
+            for (std::size_t j = 0; j < items_per_producer; ++j)
+            {
+                cp.post([&completed, payload](const cport::generic_error&){
+                    completed.fetch_add(1 + payload[0], std::memory_order_relaxed);
+                });
+            }
+        });
+    }
+
+    producer_group.join();
+    consumer_group.join();
+
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - b;
+
+    std::cout << pool_name
+        << ": payload = " << PayloadSize
+        << ", producers = " << producers
+        << ", consumers = " << consumers
+        << ", handlers/sec = " << static_cast<std::size_t>(total_items / elapsed.count())
+        << std::endl;
+}
+
+int main()
+{
+    for (std::size_t threads = 1; threads <= 4; threads *= 2)
+    {
+        cross_thread_test<16>(threads, threads);
+        cross_thread_test<256>(threads, threads);
+    }
+    return 0;
+}
@@ -0,0 +1,264 @@
+#include <catch.hpp>
+#include <cport/completion_port.hpp>
+#include <cport/reactor.hpp>
+#include <cport/util/event.hpp>
+
+#ifdef CPORT_HAS_EPOLL
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace cport;
+
+namespace {
+
+struct socket_pair {
+    socket_pair()
+    {
+        REQUIRE(0 == ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fd));
+    }
+
+    ~socket_pair()
+    {
+        ::close(fd[0]);
+        ::close(fd[1]);
+    }
+
+    int fd[2];
+};
+
+} // namespace
+
+TEST_CASE("Reactor posts handlers when descriptors become ready", "[reactor]")
+{
+    completion_port cp;
+    socket_pair sp;
+
+    std::atomic<int> invoked(0);
+    std::atomic<int> aborted(0);
+    const auto handler = [&](const generic_error &e) {
+        if (e.code() == static_cast<int>(operation_aborted))
+            ++aborted;
+        else
+            ++invoked;
+    };
+
+    reactor r(cp);
+    const char byte = 'x';
+
+    SECTION("A one-shot registration completes when the descriptor is readable")
+    {
+        const reactor_handle h = r.async_wait(sp.fd[0], reactor::read, handler);
+        REQUIRE(h);
+        REQUIRE(1 == r.registrations());
+
+        // The registration is an enqueued operation
+        REQUIRE_FALSE(cp.wait_one_for(std::chrono::milliseconds(20)));
+
+        REQUIRE(1 == ::write(sp.fd[1], &byte, 1));
+        REQUIRE(1 == cp.wait());
+        REQUIRE(1 == invoked);
+        REQUIRE(0 == r.registrations());
+        REQUIRE_FALSE(r.cancel(h));
+
+        // The descriptor could be registered again
+        REQUIRE(r.async_wait(sp.fd[0], reactor::read, handler));
+        REQUIRE(1 == cp.wait());
+        REQUIRE(2 == invoked);
+    }
+
+    SECTION("A one-shot registration completes when the descriptor is writable")
+    {
+        REQUIRE(r.async_wait(sp.fd[0], reactor::read | reactor::write, handler));
+        REQUIRE(1 == cp.wait());
+        REQUIRE(1 == invoked);
+    }
+
+    SECTION("A canceled registration is posted with operation_aborted error")
+    {
+        const reactor_handle h = r.async_wait(sp.fd[0], reactor::read, handler);
+        REQUIRE(r.cancel(h));
+        REQUIRE_FALSE(r.cancel(h));
+        REQUIRE(0 == r.registrations());
+
+        REQUIRE(1 == cp.wait());
+        REQUIRE(0 == invoked);
+        REQUIRE(1 == aborted);
+    }
+
+    SECTION("A persistent registration is invoked each time the descriptor is ready")
+    {
+        const int count = 5;
+        std::atomic<int> reads(0);
+        const reactor_handle h = r.watch(sp.fd[0], reactor::read, [&](const generic_error &e) {
+            if (e.code() == static_cast<int>(operation_aborted)) {
+                ++aborted;
+                return;
+            }
+            char buf[16];
+            while (::read(sp.fd[0], buf, sizeof(buf)) > 0)
+                ++reads;
+        });
+        REQUIRE(h);
+
+        std::thread t([&]() {
+            cp.run();
+        });
+
+        for (int i = 0; i < count; ++i) {
+            REQUIRE(1 == ::write(sp.fd[1], &byte, 1));
+            while (reads != i + 1)
+                std::this_thread::yield();
+        }
+
+        REQUIRE(1 == r.registrations());
+        REQUIRE(r.cancel(h));
+
+        while (aborted == 0)
+            std::this_thread::yield();
+        cp.stop();
+        t.join();
+
+        REQUIRE(count == reads);
+        REQUIRE(0 == r.registrations());
+        REQUIRE(0 == cp.wait());
+    }
+
+    SECTION("A watched descriptor canceled by its running handler is aborted after it returns")
+    {
+        reactor_handle h;
+        std::size_t ready_on_cancel = 1;
+        h = r.watch(sp.fd[0], reactor::read, [&](const generic_error &e) {
+            if (e.code() == static_cast<int>(operation_aborted)) {
+                ++aborted;
+                return;
+            }
+            ++invoked;
+            REQUIRE(r.cancel(h));
+            REQUIRE_FALSE(r.cancel(h));
+            REQUIRE(0 == r.registrations());
+            ready_on_cancel = cp.ready_handlers();
+        });
+        REQUIRE(h);
+        REQUIRE(1 == ::write(sp.fd[1], &byte, 1));
+
+        REQUIRE(2 == cp.wait());
+        REQUIRE(0 == ready_on_cancel);
+        REQUIRE(1 == invoked);
+        REQUIRE(1 == aborted);
+        REQUIRE(0 == r.registrations());
+    }
+
+    SECTION("A descriptor which can not be registered is posted with the error")
+    {
+        int fd[2];
+        REQUIRE(0 == ::pipe(fd));
+        ::close(fd[0]);
+        ::close(fd[1]);
+
+        std::atomic<int> error(0);
+        REQUIRE_FALSE(r.async_wait(fd[0], reactor::read, [&](const generic_error &e) {
+            error = e.code();
+        }));
+        REQUIRE(1 == cp.wait());
+        REQUIRE(EBADF == error);
+        REQUIRE(0 == r.registrations());
+    }
+
+    SECTION("A descriptor ready while the port is stopped is posted after the earlier handlers")
+    {
+        std::vector<int> order;
+        REQUIRE(r.watch(sp.fd[0], reactor::read, [&](const generic_error &e) {
+            if (!e) {
+                char c;
+                REQUIRE(1 == ::read(sp.fd[0], &c, 1));
+                order.push_back(1);
+            }
+        }));
+        cp.post([&](const generic_error&) { order.push_back(0); });
+
+        cp.stop();
+        REQUIRE(1 == ::write(sp.fd[1], &byte, 1));
+        while (cp.ready_handlers() != 2)
+            std::this_thread::yield();
+        cp.reset();
+
+        REQUIRE(cp.pull() == 2);
+        REQUIRE((std::vector<int>{ 0, 1 }) == order);
+    }
+
+    SECTION("No registration is made if the port is stopped")
+    {
+        cp.stop();
+        REQUIRE_FALSE(r.async_wait(sp.fd[0], reactor::read, handler));
+        REQUIRE_FALSE(r.watch(sp.fd[0], reactor::read, handler));
+        REQUIRE(0 == r.registrations());
+        cp.reset();
+    }
+}
+
+TEST_CASE("Destroying the reactor aborts all registrations", "[reactor]")
+{
+    completion_port cp;
+    socket_pair sp;
+
+    std::atomic<int> aborted(0);
+    const auto handler = [&](const generic_error &e) {
+        if (e.code() == static_cast<int>(operation_aborted))
+            ++aborted;
+    };
+
+    {
+        reactor r(cp);
+        REQUIRE(r.async_wait(sp.fd[0], reactor::read, handler));
+        REQUIRE(r.watch(sp.fd[1], reactor::read, handler));
+    }
+
+    REQUIRE(2 == cp.wait());
+    REQUIRE(2 == aborted);
+}
+
+TEST_CASE("Destroying the reactor aborts a running watch after its handler returns", "[reactor]")
+{
+    completion_port cp;
+    socket_pair sp;
+
+    util::event running, release;
+    std::atomic<int> invoked(0);
+    std::atomic<int> aborted(0);
+    std::thread t;
+    {
+        reactor r(cp);
+        REQUIRE(r.watch(sp.fd[0], reactor::read, [&](const generic_error &e) {
+            if (e.code() == static_cast<int>(operation_aborted)) {
+                ++aborted;
+                return;
+            }
+            ++invoked;
+            running.notify_all();
+            release.wait();
+        }));
+
+        const char byte = 'x';
+        REQUIRE(1 == ::write(sp.fd[1], &byte, 1));
+        // wait() returns when the registration is aborted
+        t = std::thread([&]() {
+            cp.wait();
+        });
+        running.wait();
+    }
+
+    REQUIRE(0 == aborted);
+    release.notify_all();
+    t.join();
+
+    REQUIRE(1 == invoked);
+    REQUIRE(1 == aborted);
+}
+
+#endif // CPORT_HAS_EPOLL
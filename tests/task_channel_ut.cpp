@@ -135,7 +135,7 @@ TEST_CASE("All enqueued tasks that are not processing can be canceled", "[task_c
 
     event e;
 
-    task_t t1 = tc->enqueue_back([&](const generic_error& ge){
+    tc->enqueue_back([&](const generic_error& ge){
 	e.notify_all();
     });
 
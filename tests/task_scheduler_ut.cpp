@@ -2,9 +2,13 @@
 #include <cport/completion_port.hpp>
 #include <cport/task_scheduler.hpp>
 #include <cport/util/event.hpp>
+#include <cport/detail/chase_lev_deque.hpp>
 #include <array>
 #include <atomic>
 #include <fstream>
+#include <set>
+#include <thread>
+#include <vector>
 #include <string.h>
 
 using namespace cport;
@@ -117,7 +121,7 @@ TEST_CASE("All tasks that are not processing can be canceled", "[task_scheduler]
 
     event e1, e2;
 
-    task_t t1 = ts.async([&](generic_error&) {
+    ts.async([&](generic_error&) {
         e2.notify_all();
         e1.wait();
     });
@@ -224,3 +228,279 @@ TEST_CASE("The scheduled tasks are processed simultaneously", "[task_scheduler]"
 
     REQUIRE_FALSE(src == dst);
 }
+
+TEST_CASE("Idle workers wait for tasks according to the wait policy", "[task_scheduler]")
+{
+    completion_port p;
+    task_scheduler ts(p, 2);
+
+    REQUIRE(0 == ts.get_wait_policy().spin_count);
+
+    ts.set_wait_policy(wait_policy(1000, 1000));
+
+    REQUIRE(1000 == ts.get_wait_policy().spin_count);
+    REQUIRE(1000 == ts.get_wait_policy().yield_count);
+
+    std::atomic<int> executed{ 0 };
+
+    for (int i = 0; i < 100; ++i)
+    {
+        ts.async([&](generic_error&) {
+            ++executed;
+        });
+    }
+
+    p.wait();
+
+    REQUIRE(100 == executed);
+
+    // The idle workers will eventually exhaust the policy and block
+    wait_stats ws = ts.get_wait_stats();
+    while (0 == ws.parks)
+    {
+        std::this_thread::yield();
+        ws = ts.get_wait_stats();
+    }
+}
+
+TEST_CASE("The work-stealing deque", "[task_scheduler]")
+{
+    std::vector<int> values(1000);
+    detail::chase_lev_deque<int> d(2);
+    REQUIRE(d.empty());
+    REQUIRE(d.pop() == nullptr);
+    REQUIRE(d.steal() == nullptr);
+
+    SECTION("the owner pops the newest and the thieves steal the oldest")
+    {
+        for (int &v : values)
+            d.push(&v);
+        REQUIRE(d.size() == values.size());
+        REQUIRE(d.pop() == &values.back());
+        REQUIRE(d.steal() == &values.front());
+        REQUIRE(d.size() == values.size() - 2);
+    }
+
+    SECTION("the tasks are extracted and drained oldest first")
+    {
+        for (int i = 0; i < 10; ++i)
+            d.push(&values[i]);
+        REQUIRE(d.extract([&](int *p) { return p == &values[5]; }) == &values[5]);
+        REQUIRE(d.extract([&](int *p) { return p == &values[5]; }) == nullptr);
+        REQUIRE(d.size() == 9);
+
+        std::vector<int *> drained;
+        REQUIRE(d.drain([&](int *p) { drained.push_back(p); }) == 9);
+        REQUIRE(d.empty());
+        REQUIRE(drained.size() == 9);
+        for (int i = 0; i < 9; ++i)
+            REQUIRE(drained[i] == &values[i < 5 ? i : i + 1]);
+    }
+
+    SECTION("each element is taken once by the owner or by a thief")
+    {
+        std::atomic<bool> done(false);
+        std::atomic<std::size_t> stolen(0);
+        std::vector<std::atomic<int>> taken(values.size());
+        for (auto &t : taken)
+            t = 0;
+
+        std::vector<std::thread> thieves;
+        for (int i = 0; i < 3; ++i) {
+            thieves.emplace_back([&]() {
+                while (!done) {
+                    if (int *p = d.steal()) {
+                        ++taken[p - values.data()];
+                        ++stolen;
+                    }
+                    else {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+
+        for (std::size_t round = 0; round < 100; ++round) {
+            for (int &v : values)
+                d.push(&v);
+            while (int *p = d.pop())
+                ++taken[p - values.data()];
+            while (!d.empty())
+                std::this_thread::yield();
+        }
+        done = true;
+        for (auto &t : thieves)
+            t.join();
+
+        for (auto &t : taken)
+            REQUIRE(t == 100);
+    }
+}
+
+TEST_CASE("The work-stealing workers run the tasks of all threads", "[task_scheduler]")
+{
+    completion_port p;
+    task_scheduler ts(p, 4, scheduling_policy::work_stealing);
+    REQUIRE(ts.get_scheduling_policy() == scheduling_policy::work_stealing);
+
+    std::atomic<int> executed{ 0 };
+    std::atomic<int> completed{ 0 };
+    for (int i = 0; i < 100; ++i)
+    {
+        ts.async([&](generic_error&) {
+            ++executed;
+            // Pushed to the deque of the worker
+            for (int j = 0; j < 10; ++j)
+            {
+                ts.async([&](generic_error&) { ++executed; },
+                    [&](const generic_error& e) {
+                        REQUIRE(!e);
+                        ++completed;
+                    });
+            }
+        },
+        [&](const generic_error&) { ++completed; });
+    }
+
+    while (completed != 1100)
+        p.run_one();
+
+    REQUIRE(1100 == executed);
+    REQUIRE(0 == ts.packaged_tasks());
+    // Counted after the completion is posted
+    while (ts.snapshot().executed != 1100)
+        std::this_thread::yield();
+}
+
+TEST_CASE("The idle work-stealing workers steal the tasks", "[task_scheduler]")
+{
+    completion_port p;
+    task_scheduler ts(p, 2, scheduling_policy::work_stealing);
+
+    const int count = 10;
+    std::atomic<int> executed{ 0 };
+    event done;
+    ts.async([&](generic_error&) {
+        for (int i = 0; i < count; ++i)
+        {
+            ts.async([&](generic_error&) {
+                if (++executed == count)
+                    done.notify_all();
+            });
+        }
+        // Only the other worker could run them
+        done.wait();
+    });
+
+    p.wait();
+    REQUIRE(count == executed);
+}
+
+TEST_CASE("The tasks in all queues of the work-stealing workers could be canceled", "[task_scheduler]")
+{
+    completion_port p;
+    task_scheduler ts(p, 1, scheduling_policy::work_stealing);
+
+    event started, release;
+    std::vector<task_t> spawned;
+    std::atomic<int> executed{ 0 };
+    std::atomic<int> aborted{ 0 };
+    auto task = [&](generic_error&) { ++executed; };
+    auto completion = [&](const generic_error& ge) {
+        if (ge.code() == static_cast<int>(operation_aborted))
+            ++aborted;
+    };
+
+    task_t t1 = ts.async([&](generic_error&) {
+        // Pushed to the deque of the worker
+        for (int i = 0; i < 5; ++i)
+            spawned.push_back(ts.async(task, completion));
+        started.notify_all();
+        release.wait();
+    });
+    started.wait();
+
+    // Do not leave the worker blocked when a requirement fails
+    struct releaser {
+        event &e;
+        ~releaser() { e.notify_all(); }
+    } r = { release };
+
+    // Pushed to the injection queue
+    std::vector<task_t> injected;
+    for (int i = 0; i < 5; ++i)
+        injected.push_back(ts.async(task, completion));
+
+    REQUIRE(10 == ts.packaged_tasks());
+    REQUIRE_FALSE(ts.cancel(t1));
+
+    SECTION("one by one")
+    {
+        REQUIRE(ts.cancel(spawned[2]));
+        REQUIRE_FALSE(ts.cancel(spawned[2]));
+        REQUIRE(ts.cancel(injected[3]));
+        REQUIRE(8 == ts.packaged_tasks());
+
+        release.notify_all();
+        while (executed + aborted != 10)
+            p.run_one();
+        REQUIRE(8 == executed);
+        REQUIRE(2 == aborted);
+    }
+
+    SECTION("all at once")
+    {
+        REQUIRE(10 == ts.cancel_all());
+        REQUIRE(0 == ts.packaged_tasks());
+
+        release.notify_all();
+        while (aborted != 10)
+            p.run_one();
+        p.wait();
+        REQUIRE(0 == executed);
+        REQUIRE(10 == ts.snapshot().canceled);
+    }
+}
+
+TEST_CASE("The work-stealing tasks are either executed or canceled", "[task_scheduler]")
+{
+    completion_port p;
+    std::atomic<int> executed{ 0 };
+    std::atomic<int> completed{ 0 };
+    std::atomic<int> canceled{ 0 };
+    const int count = 2000;
+    {
+        task_scheduler ts(p, 3, scheduling_policy::work_stealing);
+        std::vector<task_t> tasks;
+        std::mutex m;
+
+        for (int i = 0; i < count / 2; ++i)
+        {
+            tasks.push_back(ts.async([&](generic_error&) {
+                ++executed;
+                task_t t = ts.async([&](generic_error&) { ++executed; },
+                    [&](const generic_error&) { ++completed; });
+                std::lock_guard<std::mutex> lock(m);
+                tasks.push_back(t);
+            },
+            [&](const generic_error&) { ++completed; }));
+        }
+
+        for (int i = 0; i < count / 2; ++i)
+        {
+            task_t t;
+            {
+                std::lock_guard<std::mutex> lock(m);
+                t = tasks[(i * 7) % tasks.size()];
+            }
+            if (ts.cancel(t))
+                ++canceled;
+        }
+        canceled += static_cast<int>(ts.cancel_all());
+
+        while (completed != executed + canceled || executed + canceled < count / 2)
+            p.run_one();
+    }
+    p.wait();
+    REQUIRE(completed == executed + canceled);
+}
@@ -0,0 +1,115 @@
+#include <catch.hpp>
+#include <cport/completion_port.hpp>
+#include <cport/task_scheduler.hpp>
+#include <cport/util/event.hpp>
+#include <cport/util/thread_group.hpp>
+#include <atomic>
+#include <vector>
+
+using namespace cport;
+using namespace cport::util;
+
+#ifndef CPORT_ENABLE_TASK_STATUS
+#error "The task status tests require CPORT_ENABLE_TASK_STATUS"
+#endif
+
+TEST_CASE("The status of a task follows its execution", "[task_status]")
+{
+    completion_port p;
+    task_scheduler ts(p, 1);
+    event started;
+    event release;
+
+    const task_t first = ts.async([&](generic_error&) {
+        started.notify_all();
+        release.wait();
+    });
+    task_t second = ts.async([](generic_error&) {
+    });
+
+    started.wait();
+    REQUIRE(completion_status::executing == first.get_status());
+    REQUIRE(completion_status::scheduled == second.get_status());
+
+    SECTION("Waiting for a completed task")
+    {
+        release.notify_all();
+        second.wait();
+        REQUIRE(completion_status::complete == second.get_status());
+        REQUIRE(completion_status::complete == first.get_status());
+    }
+
+    SECTION("Waiting for a canceled task")
+    {
+        REQUIRE(ts.cancel(second));
+        second.wait();
+        REQUIRE(completion_status::canceled == second.get_status());
+        release.notify_all();
+    }
+
+    p.wait();
+}
+
+TEST_CASE("All threads waiting for a task are released", "[task_status]")
+{
+    completion_port p;
+    task_scheduler ts(p, 1);
+    event release;
+
+    const task_t task = ts.async([&](generic_error&) {
+        release.wait();
+    });
+
+    std::atomic<int> released{ 0 };
+    thread_group tg;
+    for (int i = 0; i < 8; ++i)
+    {
+        tg.add([&, task]() mutable {
+            task.wait();
+            ++released;
+        });
+    }
+
+    release.notify_all();
+    tg.join();
+    REQUIRE(8 == released);
+    REQUIRE(completion_status::complete == task.get_status());
+    p.wait();
+}
+
+TEST_CASE("An invalid task has no status and does not block", "[task_status]")
+{
+    task_t task;
+    REQUIRE_FALSE(task);
+    REQUIRE(completion_status::none == task.get_status());
+    task.wait();
+}
+
+#ifndef CPORT_DISABLE_OBJ_MEMORY_POOL
+TEST_CASE("Task status blocks are pooled", "[task_status]")
+{
+    const std::size_t count = 1000;
+    {
+        std::vector<task_t> warm_up;
+        for (std::size_t i = 1; i <= count; ++i)
+            warm_up.push_back(task_t(detail::operation_id(i)));
+    }
+
+    std::vector<task_t> tasks;
+    tasks.reserve(count);
+
+    // The slab allocator takes its nodes from the heap only when it grows
+    const detail::slab_allocator &slabs = detail::slab_allocator::instance();
+    const std::size_t footprint = slabs.footprint();
+    const std::size_t live = slabs.live_bytes();
+    for (std::size_t i = 1; i <= count; ++i)
+    {
+        const task_t task{ detail::operation_id(i) };
+        tasks.push_back(task);
+    }
+    REQUIRE(slabs.live_bytes() - live >= count * sizeof(detail::task_status_block));
+    tasks.clear();
+
+    REQUIRE(footprint == slabs.footprint());
+}
+#endif // CPORT_DISABLE_OBJ_MEMORY_POOL
@@ -0,0 +1,217 @@
+#include <catch.hpp>
+#include <cport/completion_port.hpp>
+#include <cport/detail/timer_wheel.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using namespace cport;
+
+namespace {
+
+detail::timer_node make_node(std::uint64_t expiry)
+{
+    const detail::timer_node n = { nullptr, nullptr, expiry, 0, nullptr };
+    return n;
+}
+
+}
+
+TEST_CASE("Timers expire at their tick in all levels of the wheel", "[timer]")
+{
+    detail::timer_wheel wheel(10);
+
+    const std::uint64_t expiries[] = { 0, 11, 265, 300, 20000, 1u << 21, 1u << 27,
+        (std::uint64_t(1) << 33) + 5 };
+    std::vector<detail::timer_node> nodes;
+    for (std::uint64_t e : expiries)
+    {
+        nodes.push_back(make_node(e));
+    }
+    for (auto& n : nodes)
+    {
+        wheel.insert(&n);
+    }
+
+    REQUIRE(nodes.size() == wheel.size());
+
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> fired;
+    std::uint64_t tick = wheel.next();
+
+    // Jump from event to event, as the timer thread does
+    while (wheel.size() > 0)
+    {
+        tick = wheel.next_event();
+        wheel.advance(tick, [&](detail::timer_node *n) {
+            fired.emplace_back(n->expiry, tick);
+        });
+    }
+
+    REQUIRE(nodes.size() == fired.size());
+
+    // A timer which is already due expires on the next tick
+    REQUIRE(0 == fired[0].first);
+    REQUIRE(10 == fired[0].second);
+
+    for (std::size_t i = 1; i < fired.size(); ++i)
+    {
+        REQUIRE(expiries[i] == fired[i].first);
+        REQUIRE(fired[i].first == fired[i].second);
+    }
+}
+
+TEST_CASE("An erased timer does not expire", "[timer]")
+{
+    detail::timer_wheel wheel;
+
+    auto n1 = make_node(100);
+    auto n2 = make_node(100000);
+    wheel.insert(&n1);
+    wheel.insert(&n2);
+    wheel.erase(&n2);
+
+    std::size_t count = 0;
+    wheel.advance(1000000, [&](detail::timer_node*) { ++count; });
+
+    REQUIRE(1 == count);
+    REQUIRE(0 == wheel.size());
+}
+
+TEST_CASE("Timer handlers are posted to the completion port", "[timer]")
+{
+    completion_port cp;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    SECTION("Handlers are posted in order of expiry")
+    {
+        std::vector<int> order;
+
+        cp.post_after(std::chrono::milliseconds(30), [&](const generic_error& e) {
+            REQUIRE_FALSE(e);
+            order.push_back(2);
+        });
+        cp.post_after(std::chrono::milliseconds(10), [&](const generic_error& e) {
+            REQUIRE_FALSE(e);
+            order.push_back(1);
+        });
+        cp.post_at(std::chrono::system_clock::now() - std::chrono::seconds(1), [&](const generic_error& e) {
+            REQUIRE_FALSE(e);
+            order.push_back(0);
+        });
+
+        // wait() blocks until all timers expire
+        REQUIRE(3 == cp.wait());
+        REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(30));
+        REQUIRE((std::vector<int>{ 0, 1, 2 }) == order);
+    }
+
+    SECTION("A canceled timer handler is posted with operation_aborted error")
+    {
+        bool aborted = false;
+
+        const timer_handle t = cp.post_after(std::chrono::hours(1), [&](const generic_error& e) {
+            aborted = e.code() == static_cast<int>(operation_aborted);
+        });
+
+        REQUIRE(t);
+        REQUIRE(cp.cancel(t));
+        REQUIRE_FALSE(cp.cancel(t));
+        REQUIRE_FALSE(cp.cancel(timer_handle()));
+
+        // The port without timers did not schedule it
+        completion_port other;
+        REQUIRE_FALSE(other.cancel(t));
+
+        REQUIRE(1 == cp.wait());
+        REQUIRE(aborted);
+        REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::minutes(1));
+    }
+
+    SECTION("A timer can not be canceled by another port with timers")
+    {
+        int aborted = 0;
+        const auto handler = [&](const generic_error& e) {
+            if (e.code() == static_cast<int>(operation_aborted))
+                ++aborted;
+        };
+
+        completion_port other;
+        const timer_handle t = cp.post_after(std::chrono::hours(1), handler);
+        const timer_handle o = other.post_after(std::chrono::hours(1), handler);
+        REQUIRE(t != o);
+
+        REQUIRE_FALSE(other.cancel(t));
+        REQUIRE_FALSE(cp.cancel(o));
+
+        REQUIRE(cp.cancel(t));
+        REQUIRE(other.cancel(o));
+        REQUIRE(1 == cp.wait());
+        REQUIRE(1 == other.wait());
+        REQUIRE(2 == aborted);
+    }
+
+    SECTION("An expired timer can not be canceled")
+    {
+        const timer_handle t = cp.post_after(std::chrono::milliseconds(1), [](const generic_error&) {});
+
+        REQUIRE(1 == cp.wait());
+        REQUIRE_FALSE(cp.cancel(t));
+    }
+
+    SECTION("A timer can not be scheduled if the port is stopped")
+    {
+        cp.stop();
+
+        const timer_handle t = cp.post_after(std::chrono::milliseconds(1), [](const generic_error&) {});
+
+        REQUIRE_FALSE(t);
+    }
+}
+
+TEST_CASE("Pending timers are canceled when the port is destroyed", "[timer]")
+{
+    std::atomic<int> aborted{ 0 };
+    {
+        completion_port cp;
+        for (int i = 0; i < 3; ++i)
+        {
+            cp.post_after(std::chrono::hours(1), [&](const generic_error& e) {
+                if (e.code() == static_cast<int>(operation_aborted))
+                    ++aborted;
+            });
+        }
+    }
+    REQUIRE(3 == aborted);
+}
+
+TEST_CASE("Many timers scheduled from many threads all expire", "[timer]")
+{
+    completion_port cp;
+
+    std::atomic<int> expired{ 0 };
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < 1000; ++i)
+            {
+                cp.post_after(std::chrono::milliseconds((i + t) % 50), [&](const generic_error& e) {
+                    REQUIRE_FALSE(e);
+                    ++expired;
+                });
+            }
+        });
+    }
+
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    REQUIRE(4000 == cp.wait());
+    REQUIRE(4000 == expired);
+}
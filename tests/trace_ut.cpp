@@ -0,0 +1,158 @@
+#include <catch.hpp>
+#include <cport/completion_port.hpp>
+#include <cport/task_scheduler.hpp>
+#include <cport/task_channel.hpp>
+#include <cport/trace.hpp>
+#include <cport/util/event.hpp>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace cport;
+using namespace cport::util;
+
+#ifdef CPORT_HAS_TRACING
+
+namespace {
+
+std::size_t occurrences(const std::string &s, const std::string &what)
+{
+    std::size_t count = 0;
+    for (std::size_t pos = s.find(what); pos != std::string::npos;
+        pos = s.find(what, pos + what.size()))
+        ++count;
+    return count;
+}
+
+std::string write_trace()
+{
+    std::ostringstream os;
+    trace_recorder::write_chrome_trace(os);
+    return os.str();
+}
+
+} // namespace
+
+TEST_CASE("Nothing is recorded while the trace recorder is stopped", "[trace]")
+{
+    trace_recorder::stop();
+    trace_recorder::clear();
+    REQUIRE_FALSE(trace_recorder::enabled());
+
+    completion_port p;
+    task_scheduler ts(p, 1);
+    ts.async([](generic_error&) {});
+    p.wait();
+
+    std::ostringstream os;
+    REQUIRE(trace_recorder::write_chrome_trace(os) == 0);
+    REQUIRE(os.str().find("\"traceEvents\":[") != std::string::npos);
+}
+
+TEST_CASE("The lifecycle of the scheduled tasks is traced", "[trace]")
+{
+    trace_recorder::clear();
+    trace_recorder::start();
+    REQUIRE(trace_recorder::enabled());
+    {
+        completion_port p;
+        task_scheduler ts(p, 1);
+        for (int i = 0; i < 3; ++i)
+            ts.async([](generic_error&) {}, [](const generic_error&) {});
+        p.wait();
+    }
+    trace_recorder::stop();
+
+    const std::string trace = write_trace();
+    REQUIRE(occurrences(trace, "\"name\":\"async\"") == 3);
+    REQUIRE(occurrences(trace, "\"name\":\"enqueue\"") == 3);
+    REQUIRE(occurrences(trace, "\"name\":\"execute\",\"cat\":\"task\",\"ph\":\"B\"") == 3);
+    REQUIRE(occurrences(trace, "\"name\":\"execute\",\"cat\":\"task\",\"ph\":\"E\"") == 3);
+    REQUIRE(occurrences(trace, "\"name\":\"post_complete\"") == 3);
+    REQUIRE(occurrences(trace, "\"name\":\"completion\",\"cat\":\"task\",\"ph\":\"B\"") == 3);
+    REQUIRE(occurrences(trace, "\"name\":\"completion\",\"cat\":\"task\",\"ph\":\"E\"") == 3);
+    REQUIRE(occurrences(trace, "\"name\":\"task\",\"cat\":\"task\",\"ph\":\"b\"") == 3);
+    REQUIRE(occurrences(trace, "\"name\":\"task\",\"cat\":\"task\",\"ph\":\"e\"") == 3);
+    REQUIRE(occurrences(trace, "\"ph\":\"M\"") >= 2);
+
+    trace_recorder::clear();
+    std::ostringstream os;
+    REQUIRE(trace_recorder::write_chrome_trace(os) == 0);
+}
+
+TEST_CASE("The cancellation and the channel hand-off are traced", "[trace]")
+{
+    trace_recorder::clear();
+    trace_recorder::start();
+    {
+        completion_port p;
+        task_scheduler ts(p, 1);
+        task_channel::shared_ptr tc = task_channel::make_shared(ts);
+
+        event started, release;
+        tc->enqueue_back([&](generic_error&) {
+            started.notify_all();
+            release.wait();
+        });
+        started.wait();
+        tc->enqueue_back([](generic_error&) {});
+        const task_t canceled = tc->enqueue_back([](generic_error&) {});
+        REQUIRE(tc->cancel(canceled));
+        release.notify_all();
+        p.wait();
+    }
+    trace_recorder::stop();
+
+    const std::string trace = write_trace();
+    REQUIRE(occurrences(trace, "\"name\":\"async\"") == 3);
+    REQUIRE(occurrences(trace, "\"name\":\"cancel\"") == 1);
+    REQUIRE(occurrences(trace, "\"name\":\"channel_handoff\"") == 1);
+    REQUIRE(occurrences(trace, "\"name\":\"execute\",\"cat\":\"task\",\"ph\":\"B\"") == 2);
+    trace_recorder::clear();
+}
+
+TEST_CASE("The oldest events of a thread are overwritten", "[trace]")
+{
+    trace_recorder::clear();
+    trace_recorder::start(16);
+    std::thread t([]() {
+        for (int i = 0; i < 100; ++i)
+            detail::trace(detail::trace_event::cancel, i);
+    });
+    t.join();
+    trace_recorder::stop();
+
+    const std::string trace = write_trace();
+    REQUIRE(occurrences(trace, "\"name\":\"cancel\"") == 16);
+    REQUIRE(trace.find("\"id\":99}") != std::string::npos);
+    REQUIRE(trace.find("\"id\":83}") == std::string::npos);
+    trace_recorder::clear();
+    trace_recorder::start();
+    trace_recorder::stop();
+}
+
+TEST_CASE("The buffers of the exited threads are reused", "[trace]")
+{
+    trace_recorder::clear();
+    trace_recorder::start(16);
+    const int threads = 3 * detail::trace_registry::retired_limit;
+    for (int i = 0; i < threads; ++i)
+    {
+        std::thread t([i]() {
+            detail::trace(detail::trace_event::cancel, i);
+        });
+        t.join();
+    }
+    trace_recorder::stop();
+
+    // Only the buffers of the last threads are kept
+    const std::string trace = write_trace();
+    REQUIRE(occurrences(trace, "\"name\":\"cancel\"") == detail::trace_registry::retired_limit);
+    REQUIRE(trace.find("\"id\":" + std::to_string(threads - 1) + "}") != std::string::npos);
+    REQUIRE(trace.find("\"id\":0}") == std::string::npos);
+    trace_recorder::clear();
+    trace_recorder::start();
+    trace_recorder::stop();
+}
+
+#endif // CPORT_HAS_TRACING